@@ -0,0 +1,139 @@
+// audio_mix_bench.cpp
+
+#include "awry/awry.h"
+#include "awry/awry_audio.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// note: headless mixer throughput. mixes blocks on the calling thread with no
+//       sink attached, then optionally runs the mixer thread through a sink.
+//
+//       audio_mix_bench                  throughput only
+//       audio_mix_bench null             plus two seconds through a paced null sink
+//       audio_mix_bench wav <path>       plus two seconds into a wave file
+//       audio_mix_bench alsa [device]    plus two seconds of playback, when built with alsa
+
+namespace
+{
+   constexpr int buffer_count = 8;
+   // note: short enough that every voice is still playing at 1.5x pitch at the end
+   constexpr int block_count = 200;
+   constexpr int repeat_count = 5;
+   constexpr double block_duration_ms = 1000.0 * audio_device_t::block_frame_count / audio_device_t::sample_rate;
+
+   std::vector<short> make_tone(const int channel_count, const float frequency, const int seconds)
+   {
+      std::vector<short> samples(size_t(audio_device_t::sample_rate) * seconds * channel_count);
+      for (size_t index = 0; index < samples.size(); index++) {
+         const float time = float(index / size_t(channel_count)) / float(audio_device_t::sample_rate);
+         samples[index] = short(8000.0f * std::sin(6.2831853f * frequency * time));
+      }
+
+      return samples;
+   }
+
+   void measure(audio_device_t &device, const indexer_t (&buffers)[buffer_count], const char *label, const int voice_count, const float pitch)
+   {
+      std::vector<float> output(size_t(audio_device_t::block_frame_count) * audio_device_t::channel_count);
+
+      double best = 1e9;
+      for (int repeat = 0; repeat < repeat_count; repeat++) {
+         for (const indexer_t buffer : buffers) {
+            device.stop(buffer);
+         }
+
+         device.mix(output.data(), audio_device_t::block_frame_count);
+         for (int index = 0; index < voice_count; index++) {
+            device.play(buffers[index % buffer_count], 0.1f, pitch);
+         }
+
+         device.mix(output.data(), audio_device_t::block_frame_count);
+
+         const auto start = std::chrono::steady_clock::now();
+         for (int block = 0; block < block_count; block++) {
+            device.mix(output.data(), audio_device_t::block_frame_count);
+         }
+
+         const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+         best = std::min(best, elapsed / block_count);
+      }
+
+      printf("%-8s %2d voices: %.4f ms per block (%5.2f%% of %.1f ms), %8.0f voices mixed per ms\n",
+             label, voice_count, best, 100.0 * best / block_duration_ms, block_duration_ms, voice_count / best);
+   }
+
+   bool run_sink(audio_sink_t &sink, const char *name)
+   {
+      audio_device_t device(sink);
+      const std::vector<short> tone = make_tone(2, 440.0f, 1);
+      const indexer_t buffer = device.create(tone, 2, audio_device_t::sample_rate);
+      if (!device.start()) {
+         printf("%s: failed to open the sink\n", name);
+         return false;
+      }
+
+      for (int index = 0; index < 8; index++) {
+         device.play(buffer, 0.2f, 1.0f + 0.125f * float(index));
+         std::this_thread::sleep_for(std::chrono::milliseconds(250));
+      }
+
+      const sound_t::telemetry_t telemetry = device.telemetry();
+      device.stop();
+
+      printf("%s: %u blocks, block time avg %.3f max %.3f of %.1f ms, latency p50 %.1f p99 %.1f ms, %u underruns\n",
+             name, telemetry.blocks, telemetry.block_time.mean_ms, telemetry.block_time.max_ms, telemetry.block_budget_ms,
+             telemetry.latency.percentile(0.5f), telemetry.latency.percentile(0.99f), telemetry.underruns);
+      return true;
+   }
+} // !anon
+
+int main(int argc, char **argv)
+{
+   {
+      audio_null_sink_t sink;
+      auto device = std::make_unique<audio_device_t>(sink);
+
+      indexer_t buffers[buffer_count];
+      for (int index = 0; index < buffer_count; index++) {
+         const int channel_count = index % 2 == 0 ? 2 : 1;
+         buffers[index] = device->create(make_tone(channel_count, 220.0f * float(index + 1), 4), channel_count, audio_device_t::sample_rate);
+      }
+
+      for (const int voice_count : { 1, 8, 32, 64 }) {
+         measure(*device, buffers, "unity", voice_count, 1.0f);
+      }
+
+      measure(*device, buffers, "linear", audio_device_t::max_voice_count, 1.5f);
+      device->set_resampler(sound_t::resampler_t::sinc);
+      measure(*device, buffers, "sinc", audio_device_t::max_voice_count, 1.5f);
+   }
+
+   if (argc < 2) {
+      return 0;
+   }
+
+   if (std::strcmp(argv[1], "null") == 0) {
+      audio_null_sink_t sink(true);
+      return run_sink(sink, "null") ? 0 : 1;
+   }
+
+   if (std::strcmp(argv[1], "wav") == 0 && argc > 2) {
+      audio_wav_sink_t sink(argv[2], true);
+      return run_sink(sink, "wav") ? 0 : 1;
+   }
+
+#if defined(AWRY_AUDIO_ALSA)
+   if (std::strcmp(argv[1], "alsa") == 0) {
+      audio_alsa_sink_t sink(argc > 2 ? argv[2] : "default");
+      return run_sink(sink, "alsa") ? 0 : 1;
+   }
+#endif
+
+   printf("unknown sink '%s'\n", argv[1]);
+   return 1;
+}
@@ -0,0 +1,165 @@
+// inflate_bench.cpp
+
+#include "awry/awry_inflate.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+#include <stb_image_write.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// note: inflate_t against the stb_image zlib decoder on the same raw deflate streams.
+//
+//       inflate_bench <png>    the png's own dynamic blocks, plus fixed and stored
+//                              blocks of its image data repeated up to 4 mb
+
+namespace
+{
+   constexpr int repeat_count = 9;
+   constexpr size_t large_size = size_t(4) << 20;
+
+   struct stream_t {
+      const char          *name;
+      std::vector<uint8_t> compressed;
+      size_t               size;
+   };
+
+   std::vector<uint8_t> png_image_data(const char *path)
+   {
+      std::vector<uint8_t> file;
+      if (FILE *handle = std::fopen(path, "rb")) {
+         uint8_t buffer[4096];
+         for (size_t count; (count = std::fread(buffer, 1, sizeof(buffer), handle)) != 0;) {
+            file.insert(file.end(), buffer, buffer + count);
+         }
+         std::fclose(handle);
+      }
+
+      std::vector<uint8_t> result;
+      for (size_t offset = 8; offset + 12 <= file.size();) {
+         const uint32_t length = uint32_t(file[offset]) << 24 | uint32_t(file[offset + 1]) << 16 | uint32_t(file[offset + 2]) << 8 | file[offset + 3];
+         if (offset + 12 + length > file.size()) {
+            break;
+         }
+
+         if (std::memcmp(file.data() + offset + 4, "IDAT", 4) == 0) {
+            result.insert(result.end(), file.begin() + offset + 8, file.begin() + offset + 8 + length);
+         }
+
+         offset += 12 + length;
+      }
+
+      return result;
+   }
+
+   std::vector<uint8_t> store(const std::vector<uint8_t> &source)
+   {
+      std::vector<uint8_t> result;
+      for (size_t offset = 0; offset < source.size();) {
+         const size_t length = std::min<size_t>(source.size() - offset, 65535);
+         const uint8_t header[5] = {
+            uint8_t(offset + length == source.size() ? 1 : 0),
+            uint8_t(length), uint8_t(length >> 8), uint8_t(~length), uint8_t(~length >> 8),
+         };
+         result.insert(result.end(), header, header + 5);
+         result.insert(result.end(), source.begin() + offset, source.begin() + offset + length);
+         offset += length;
+      }
+
+      result.insert(result.end(), 4, 0);
+      return result;
+   }
+
+   // note: best of a few runs, in mb of output per second
+   template <typename decode_t>
+   double measure(const stream_t &stream, std::vector<uint8_t> &output, decode_t &&decode)
+   {
+      const int passes = int(std::max<size_t>(1, (size_t(64) << 20) / stream.size));
+
+      double best = 1e9;
+      for (int repeat = 0; repeat < repeat_count; repeat++) {
+         const auto start = std::chrono::steady_clock::now();
+         for (int pass = 0; pass < passes; pass++) {
+            if (!decode(stream, output)) {
+               return 0.0;
+            }
+         }
+
+         const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         best = std::min(best, elapsed / passes);
+      }
+
+      return double(stream.size) / best / (1024.0 * 1024.0);
+   }
+} // !anon
+
+int main(int argc, char **argv)
+{
+   if (argc < 2) {
+      printf("usage: inflate_bench <png>\n");
+      return 1;
+   }
+
+   const std::vector<uint8_t> image_data = png_image_data(argv[1]);
+   int image_size = 0;
+   char *image = image_data.size() > 6 ? stbi_zlib_decode_malloc((const char *)image_data.data(), int(image_data.size()), &image_size) : nullptr;
+   if (image == nullptr) {
+      printf("%s: no image data\n", argv[1]);
+      return 1;
+   }
+
+   std::vector<uint8_t> large;
+   while (large.size() < large_size) {
+      large.insert(large.end(), image, image + std::min(size_t(image_size), large_size - large.size()));
+   }
+
+   int fixed_length = 0;
+   unsigned char *fixed = stbi_zlib_compress(large.data(), int(large.size()), &fixed_length, 8);
+
+   // note: only the zlib header is cut, stb_image reports the end of a stream that stops
+   //       right after its last code as truncated so the adler trailer stays on as padding
+   stream_t streams[] = {
+      { "dynamic", std::vector<uint8_t>(image_data.begin() + 2, image_data.end()), size_t(image_size) },
+      { "fixed", std::vector<uint8_t>(fixed + 2, fixed + fixed_length), large.size() },
+      { "stored", store(large), large.size() },
+   };
+
+   STBI_FREE(image);
+   STBIW_FREE(fixed);
+
+   int failures = 0;
+   std::unique_ptr<inflate_t> inflater(new inflate_t);
+   for (const stream_t &stream : streams) {
+      std::vector<uint8_t> output(stream.size);
+      const double awry = measure(stream, output, [&](const stream_t &source, std::vector<uint8_t> &target) {
+         inflater->reset();
+         const uint8_t *input = source.compressed.data();
+         uint8_t *out = target.data();
+         return inflater->inflate(input, input + source.compressed.size(), true, target.data(), out, out + target.size()) == inflate_t::status_t::done;
+      });
+      const std::vector<uint8_t> expected = output;
+
+      const double stb = measure(stream, output, [](const stream_t &source, std::vector<uint8_t> &target) {
+         return stbi_zlib_decode_noheader_buffer((char *)target.data(), int(target.size()), (const char *)source.compressed.data(), int(source.compressed.size())) == int(target.size());
+      });
+
+      const bool matched = awry > 0.0 && stb > 0.0 && output == expected;
+      printf("%-8s %8zu -> %8zu bytes: inflate_t %7.1f mb/s, stb_image %7.1f mb/s, %.2fx%s\n",
+             stream.name, stream.compressed.size(), stream.size, awry, stb, stb > 0.0 ? awry / stb : 0.0, matched ? "" : " (MISMATCH)");
+      failures += matched ? 0 : 1;
+   }
+
+   return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+// triangulate_bench.cpp
+
+#include "awry/awry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// note: ear clipping against the triangulation cache the renderer draws polygons
+//       through. cold is a miss, the cache flushed before every call, cached is
+//       the same local space outline drawn again.
+
+namespace
+{
+   constexpr int repeat_count = 3;
+
+   // note: alternating radius, every other vertex is reflex so every ear test walks the outline
+   std::vector<vector2_t> make_star(const int vertex_count)
+   {
+      std::vector<vector2_t> result;
+      for (int index = 0; index < vertex_count; index++) {
+         const float angle = 6.2831853f * float(index) / float(vertex_count);
+         const float radius = (index % 2) == 0 ? 100.0f : 60.0f;
+         result.push_back(vector2_t{ std::cos(angle) * radius, std::sin(angle) * radius });
+      }
+
+      return result;
+   }
+
+   // note: best of a few runs, in microseconds per call
+   template <typename call_t>
+   double measure(const int call_count, call_t &&call)
+   {
+      double best = 1e9;
+      for (int repeat = 0; repeat < repeat_count; repeat++) {
+         const auto start = std::chrono::steady_clock::now();
+         for (int index = 0; index < call_count; index++) {
+            call();
+         }
+
+         const double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+         best = std::min(best, elapsed / call_count);
+      }
+
+      return best;
+   }
+} // !anon
+
+int main(int, char **)
+{
+   const int vertex_counts[] = { 8, 64, 1024 };
+
+   size_t checksum = 0;
+   for (const int vertex_count : vertex_counts) {
+      const std::vector<vector2_t> star = make_star(vertex_count);
+      const int call_count = std::max(400000 / (vertex_count * vertex_count), 2);
+
+      std::vector<uint32_t> indices;
+      const double triangulate = measure(call_count, [&] {
+         triangulator_t::triangulate(star, indices);
+         checksum += indices.size();
+      });
+
+      triangulation_cache_t cache;
+      const double cold = measure(call_count, [&] {
+         cache.clear();
+         checksum += cache.triangulate(star).size();
+      });
+
+      const double cached = measure(call_count * 64, [&] {
+         checksum += cache.triangulate(star).size();
+      });
+
+      if (indices.size() != size_t(vertex_count - 2) * 3) {
+         printf("%d vertices: %zu indices, expected %d\n", vertex_count, indices.size(), (vertex_count - 2) * 3);
+         return 1;
+      }
+
+      printf("%4d vertices: triangulate %10.3f us, cold %10.3f us, cached %8.3f us, %.0fx\n",
+             vertex_count, triangulate, cold, cached, cold / cached);
+   }
+
+   return checksum != 0 ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+// zip_load_bench.cpp
+
+#include "awry/awry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+#include <stb_image_write.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// note: zip_archive_t::load_many against load_content one entry at a time, with
+//       one worker and then doubling up to one per hardware thread.
+//
+//       zip_load_bench                 writes and loads zip_load_bench.zip, 48 deflated
+//                                      entries of 64 kb to 1 mb in the working directory
+//       zip_load_bench <archive.zip>   loads every entry of an existing archive
+
+namespace
+{
+   constexpr int repeat_count = 5;
+   constexpr int generated_entry_count = 48;
+
+   uint32_t crc32(const std::vector<uint8_t> &data)
+   {
+      static const auto table = [] {
+         std::vector<uint32_t> result(256);
+         for (uint32_t index = 0; index < 256; index++) {
+            uint32_t value = index;
+            for (int bit = 0; bit < 8; bit++) {
+               value = (value & 1) != 0 ? 0xedb88320u ^ (value >> 1) : value >> 1;
+            }
+            result[index] = value;
+         }
+         return result;
+      }();
+
+      uint32_t crc = 0xffffffffu;
+      for (const uint8_t byte : data) {
+         crc = table[(crc ^ byte) & 0xff] ^ (crc >> 8);
+      }
+
+      return ~crc;
+   }
+
+   // note: words with repeats, compresses to roughly a third like the game's text and level data
+   std::vector<uint8_t> make_content(const size_t size, uint32_t state)
+   {
+      const char *words[] = { "space ", "ship ", "cannon ", "boom ", "ready ", "cargo ", "hull ", "\n" };
+      std::vector<uint8_t> result;
+      while (result.size() < size) {
+         state = state * 1664525u + 1013904223u;
+         for (const char *word = words[(state >> 24) % 8]; *word != 0 && result.size() < size; word++) {
+            result.push_back(uint8_t(*word));
+         }
+         result.push_back(uint8_t('0' + (state >> 8) % 10));
+      }
+
+      result.resize(size);
+      return result;
+   }
+
+   template <typename value_t>
+   void append(std::vector<uint8_t> &output, const value_t value)
+   {
+      for (size_t index = 0; index < sizeof(value); index++) {
+         output.push_back(uint8_t(uint64_t(value) >> (index * 8)));
+      }
+   }
+
+   // note: local headers, data and a central directory, deflated with stb_image_write
+   bool write_archive(const char *path, std::vector<std::string> &names)
+   {
+      std::vector<uint8_t> archive;
+      std::vector<uint8_t> directory;
+      for (int index = 0; index < generated_entry_count; index++) {
+         const size_t size = size_t(64 * 1024) << (index % 5);
+         const std::vector<uint8_t> content = make_content(std::min<size_t>(size, 1024 * 1024), 0x2545f491u + uint32_t(index));
+         const std::string name = "entry" + std::to_string(index) + ".txt";
+
+         int zlib_length = 0;
+         unsigned char *zlib = stbi_zlib_compress(const_cast<uint8_t *>(content.data()), int(content.size()), &zlib_length, 5);
+         const uint32_t compressed_size = uint32_t(zlib_length - 6);
+         const uint32_t crc = crc32(content);
+         const uint32_t offset = uint32_t(archive.size());
+
+         append<uint32_t>(archive, 0x04034b50u);
+         append<uint16_t>(archive, 20);
+         append<uint16_t>(archive, 0);
+         append<uint16_t>(archive, 8);
+         append<uint32_t>(archive, 0);
+         append<uint32_t>(archive, crc);
+         append<uint32_t>(archive, compressed_size);
+         append<uint32_t>(archive, uint32_t(content.size()));
+         append<uint16_t>(archive, uint16_t(name.size()));
+         append<uint16_t>(archive, 0);
+         archive.insert(archive.end(), name.begin(), name.end());
+         archive.insert(archive.end(), zlib + 2, zlib + 2 + compressed_size);
+         STBIW_FREE(zlib);
+
+         append<uint32_t>(directory, 0x02014b50u);
+         append<uint16_t>(directory, 20);
+         append<uint16_t>(directory, 20);
+         append<uint16_t>(directory, 0);
+         append<uint16_t>(directory, 8);
+         append<uint32_t>(directory, 0);
+         append<uint32_t>(directory, crc);
+         append<uint32_t>(directory, compressed_size);
+         append<uint32_t>(directory, uint32_t(content.size()));
+         append<uint16_t>(directory, uint16_t(name.size()));
+         append<uint32_t>(directory, 0);
+         append<uint32_t>(directory, 0);
+         append<uint32_t>(directory, 0);
+         append<uint32_t>(directory, offset);
+         directory.insert(directory.end(), name.begin(), name.end());
+
+         names.push_back(name);
+      }
+
+      const uint32_t directory_offset = uint32_t(archive.size());
+      archive.insert(archive.end(), directory.begin(), directory.end());
+      append<uint32_t>(archive, 0x06054b50u);
+      append<uint16_t>(archive, 0);
+      append<uint16_t>(archive, 0);
+      append<uint16_t>(archive, uint16_t(generated_entry_count));
+      append<uint16_t>(archive, uint16_t(generated_entry_count));
+      append<uint32_t>(archive, uint32_t(directory.size()));
+      append<uint32_t>(archive, directory_offset);
+      append<uint16_t>(archive, 0);
+
+      FILE *file = std::fopen(path, "wb");
+      if (file == nullptr) {
+         return false;
+      }
+
+      const bool written = std::fwrite(archive.data(), 1, archive.size(), file) == archive.size();
+      std::fclose(file);
+
+      return written;
+   }
+} // !anon
+
+int main(int argc, char **argv)
+{
+   const char *path = argc > 1 ? argv[1] : "zip_load_bench.zip";
+
+   std::vector<std::string> names;
+   if (argc < 2 && !write_archive(path, names)) {
+      printf("%s: failed to write\n", path);
+      return 1;
+   }
+
+   zip_archive_t archive;
+   if (!archive.open(path)) {
+      printf("%s: not a zip archive\n", path);
+      return 1;
+   }
+
+   if (names.empty()) {
+      for (const zip_archive_t::zip_entry_t &entry : archive.m_entries) {
+         names.push_back(entry.name);
+      }
+   }
+
+   std::vector<std::string_view> paths(names.begin(), names.end());
+   uint64_t total_compressed = 0;
+   uint64_t total_size = 0;
+   for (const std::string_view name : paths) {
+      const zip_archive_t::zip_entry_t *entry = archive.find(name);
+      total_compressed += entry != nullptr ? entry->size_compressed : 0;
+      total_size += entry != nullptr ? entry->size_uncompressed : 0;
+   }
+
+   printf("%s: %zu entries, %.1f mb compressed, %.1f mb uncompressed, %u hardware threads\n",
+          path, paths.size(), total_compressed / (1024.0 * 1024.0), total_size / (1024.0 * 1024.0), std::thread::hardware_concurrency());
+
+   double best = 1e9;
+   for (int repeat = 0; repeat < repeat_count; repeat++) {
+      const auto start = std::chrono::steady_clock::now();
+      std::vector<uint8_t> content;
+      for (const std::string_view name : paths) {
+         if (!archive.load_content(name, content)) {
+            printf("%.*s: failed to load\n", int(name.size()), name.data());
+            return 1;
+         }
+      }
+
+      best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+   }
+
+   const double sequential = best;
+   printf("load_content       : %8.2f ms, %7.1f mb/s\n", sequential, total_size / (1024.0 * 1024.0) / (sequential / 1000.0));
+
+   const int max_workers = std::max(int(std::thread::hardware_concurrency()), 1);
+   for (int workers = 1;; workers = std::min(workers * 2, max_workers)) {
+      thread_pool_t pool(workers);
+
+      best = 1e9;
+      for (int repeat = 0; repeat < repeat_count; repeat++) {
+         const auto start = std::chrono::steady_clock::now();
+         size_t loaded_size = 0;
+         const bool success = archive.load_many(pool, paths, [&loaded_size](size_t, bool, std::vector<uint8_t> &content) {
+            loaded_size += content.size();
+         });
+
+         if (!success || loaded_size != total_size) {
+            printf("load_many with %d workers failed\n", workers);
+            return 1;
+         }
+
+         best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+      }
+
+      printf("load_many %3d worker%s: %8.2f ms, %7.1f mb/s, %.2fx load_content\n",
+             workers, workers == 1 ? " " : "s", best, total_size / (1024.0 * 1024.0) / (best / 1000.0), sequential / best);
+
+      if (workers == max_workers) {
+         break;
+      }
+   }
+
+   return 0;
+}
@@ -7,16 +7,18 @@ static void
 play_random_sound(sound_t(&sounds)[N], const float volume)
 {
    int index = random_t::range_int(0, int(N - 1));
-   sounds[index].play(volume);
+   sounds[index].play(volume, random_t::range(0.95f, 1.05f));
 }
 
 application_t::application_t()
    : m_runtime(*runtime_t::ptr)
    , m_window(m_runtime.window())
    , m_graphics(m_runtime.graphics())
+   , m_capture(m_runtime.capture())
    , m_mouse(m_runtime.input().mouse())
    , m_keyboard(m_runtime.input().keyboard())
    , m_canvas_size({ 1920, 1080 })//m_runtime.get_desktop_size() { 1280, 720 })
+   , m_assets(m_runtime.thread_pool())
    , m_overlay(m_font)
 {
    m_window.set_title("LD54: Limited Space");
@@ -50,13 +52,49 @@ bool application_t::startup()
 {
    mouse_t::hide_cursor();
 
-   if (!m_sprite_tex.create_from_file("data/sprites.png", texture_t::filter_t::linear)) { 
-      return false; 
-   }
+   // note: the sheet streams in on the pool, render() shows progress until it is uploaded
+   m_sprite_asset = m_assets.load_texture(m_sprite_tex, "data/sprites.png", texture_t::filter_t::linear);
 
    m_font.set_texture(m_sprite_tex);
    bitmap_font_t::construct_monospaced_font(m_font, { 16, 6 }, { 8, 8 });
 
+   { // note: map the prebuilt bank when there is one, otherwise decode on the thread pool
+      //       while the rest starts up, those sounds play silence until ready.
+      static constexpr const char *sound_names[sound_count] = {
+         "cannon0",
+         "cannon1",
+         "cannon2",
+         "boom0",
+         "ready",
+      };
+
+      static constexpr const char *sound_paths[sound_count] = {
+         "data/cannon0.ogg",
+         "data/cannon1.ogg",
+         "data/cannon2.ogg",
+         "data/boom0.ogg",
+         "data/ready.ogg",
+      };
+
+      m_sound_load_start = timespan_t::time_since_start();
+      if (m_sound_bank.create_from_file("data/sounds.bank")) {
+         for (int index = 0; index < sound_count; index++) {
+            m_sounds[index] = m_sound_bank.find(sound_names[index]);
+         }
+      }
+      else {
+         for (int index = 0; index < sound_count; index++) {
+            m_assets.load_sound(m_sounds[index], sound_paths[index]);
+         }
+      }
+
+      // note: the effects bus gets muffled while boosting, one filter for every shot at once
+      m_effects_bus.create();
+      for (auto &sound : m_sounds) {
+         sound.set_bus(m_effects_bus);
+      }
+   }
+
    { // note: splash screen settings and position
       m_splash_spr.set_texture(m_sprite_tex);
       m_splash_spr.set_source({ 0, 49, 288, 90 });
@@ -81,19 +119,6 @@ bool application_t::startup()
       m_space_spr.set_position(sprite_position);
    }
 
-   { // note: instructions settings and position
-      m_instructions_spr.set_texture(m_sprite_tex);
-      m_instructions_spr.set_source({ 0, 184, 350, 14 });
-      m_instructions_spr.set_destination({ 0, 0, 350, 14 });
-
-      point_t sprite_dims = m_instructions_spr.dims();
-      vector2_t sprite_position = vector2_t{ 
-         m_canvas_size.x * 0.5f - sprite_dims.x * 0.5f, 
-         m_canvas_size.y - sprite_dims.y * 1.0f
-      };
-      m_instructions_spr.set_position(sprite_position);
-   }
-
    { // note: tmmium sprite settings and position
       m_tmmium_spr.set_texture(m_sprite_tex);
       m_tmmium_spr.set_source({ 130, 18, 122, 14 });
@@ -114,6 +139,16 @@ bool application_t::startup()
 
 void application_t::shutdown()
 {
+   if (m_sound_bank.valid()) {
+      m_sound_bank.destroy();
+   }
+   else {
+      for (auto &sound : m_sounds) {
+         sound.destroy();
+      }
+   }
+
+   m_effects_bus.destroy();
    m_sprite_tex.destroy();
 
    mouse_t::show_cursor();
@@ -133,10 +168,24 @@ void application_t::update()
    m_frame_time = now - m_app_time;
    m_app_time = now;
 
+   if (m_sprite_asset->failed()) {
+      m_running = false;
+   }
+
    //if (m_keyboard.released(keyboard_t::key_t::escape)) {
    //   m_running = false;
    //}
 
+   if (!m_sounds_loaded) {
+      m_sounds_loaded = std::all_of(std::begin(m_sounds), std::end(m_sounds), [](const sound_t &sound) {
+         return sound.ready() || sound.failed();
+      });
+
+      if (m_sounds_loaded) {
+         m_sound_load_time = now - m_sound_load_start;
+      }
+   }
+
    if (m_keyboard.pressed(keyboard_t::key_t::f1)) {
       m_overlay.toggle();
    }
@@ -145,6 +194,37 @@ void application_t::update()
       m_window.fullscreen();
    }
 
+   if (m_keyboard.pressed(keyboard_t::key_t::f2)) {
+      m_antialiasing = !m_antialiasing;
+      m_graphics.antialiasing(m_antialiasing);
+   }
+
+   if (m_keyboard.pressed(keyboard_t::key_t::f12)) {
+      char path[64] = {};
+      snprintf(path, sizeof(path), "screenshot_%03d.png", m_screenshot_count++);
+      m_capture.screenshot(path);
+   }
+
+   if (m_keyboard.pressed(keyboard_t::key_t::f11)) {
+      if (m_capture.recording()) {
+         m_capture.stop_recording();
+      }
+      else {
+         m_capture.start_recording("capture.rgba");
+      }
+   }
+
+   if (m_keyboard.pressed(keyboard_t::key_t::f10)) {
+      if (m_audio_recording) {
+         sound_t::stop_telemetry_recording();
+         m_audio_recording = false;
+      }
+      else {
+         sound_t::reset_telemetry();
+         m_audio_recording = sound_t::start_telemetry_recording("audio_telemetry.csv");
+      }
+   }
+
    m_window_size = m_window.get_size();
    vector2_t canvas_scale = vector2_t{ m_canvas_size } / vector2_t{ m_window_size };
    vector2_t scaled_mouse_position = m_mouse.scaled_position(canvas_scale);
@@ -169,6 +249,7 @@ void application_t::update()
       if (m_keyboard.pressed(keyboard_t::key_t::space)) {
          m_state = state_t::play;
          m_splash_pulse = 0.0f;
+         m_sounds[ready_sound].play(0.8f);
          m_spaceship.m_spawnicator.activate(2);
       }
    }
@@ -187,6 +268,11 @@ void application_t::update()
       }
    }
 
+   if (const bool muffled = m_state == state_t::play && m_spaceship.m_boosting; muffled != m_effects_muffled) {
+      m_effects_muffled = muffled;
+      m_effects_bus.set_filter(muffled ? sound_bus_t::filter_t::low_pass : sound_bus_t::filter_t::none, 800.0f);
+   }
+
    m_spaceship.update(m_frame_time);
 
    m_overlay.clear();
@@ -194,6 +280,7 @@ void application_t::update()
 
 void application_t::pre_render()
 {
+   m_assets.update();
    m_graphics.clear(space_background_color);
    m_graphics.projection(m_canvas_size);
 }
@@ -203,6 +290,13 @@ void application_t::render()
    m_starfield.render(m_graphics);
    m_solarsystem.render(m_graphics);
 
+   if (!m_sprite_tex.valid()) {
+      const rectangle_t bar{ m_canvas_size.x / 2 - 200, m_canvas_size.y / 2, 400, 8 };
+      m_graphics.draw_rect_outlined(bar, 2.0f, cursor_outer_color);
+      m_graphics.draw_rect_filled({ bar.x, bar.y, int(bar.w * m_assets.progress()), bar.h }, cursor_fill_color);
+      return;
+   }
+
    if (m_state == state_t::menu) {
       float scale = 2.0f + (math_t::cosf(m_splash_pulse * 2.0f) * 0.05f);
       matrix3_t transform = 
@@ -227,7 +321,70 @@ void application_t::render()
    m_tmmium_spr.render(m_graphics);
    m_cursor.render(m_graphics);
 
-   m_instructions_spr.render(m_graphics);
+   { // note: laid out once and memoized, centered along the bottom and wrapped should the canvas get narrow
+      static constexpr std::string_view instructions = "RMB = accelerate ship. LMB = shoot. Proximity = Cargo.";
+      const text_layout_t &layout = m_layouts.layout(m_font, instructions, m_canvas_size.x, 2, text_align_t::center);
+      m_layouts.render(m_graphics, layout, { 0, m_canvas_size.y - layout.m_size.y }, color_t{});
+   }
+
+   if (m_sounds_loaded) {
+      const auto failed = std::count_if(std::begin(m_sounds), std::end(m_sounds), [](const sound_t &sound) {
+         return sound.failed();
+      });
+
+      m_overlay.draw_text_va(color_t{},
+                             "sounds: %d %s, %d failed, in %1.3f ms on %d workers",
+                             int(sound_count - failed),
+                             m_sound_bank.valid() ? "mapped" : "decoded",
+                             int(failed),
+                             m_sound_load_time.elapsed_milliseconds(),
+                             m_runtime.thread_pool().thread_count());
+   }
+
+   if (m_sounds_loaded) {
+      const sound_t::telemetry_t telemetry = sound_t::telemetry();
+      m_overlay.draw_text_va(color_t{},
+                             "audio%s: latency p50 %1.1f p99 %1.1f max %1.1f ms, block %1.3f avg %1.3f max of %1.1f ms, queued %d, underruns %u/%u, voices %d (peak %d)",
+                             m_audio_recording ? " (recording)" : "",
+                             telemetry.latency.percentile(0.5f),
+                             telemetry.latency.percentile(0.99f),
+                             telemetry.latency.max_ms,
+                             telemetry.block_time.mean_ms,
+                             telemetry.block_time.max_ms,
+                             telemetry.block_budget_ms,
+                             telemetry.queued_frames,
+                             telemetry.underruns,
+                             telemetry.stream_underruns,
+                             telemetry.active_voices,
+                             telemetry.peak_voices);
+   }
+
+   if (m_assets.idle()) {
+      const asset_loader_t::stats_t stats = m_assets.stats();
+      m_overlay.draw_text_va(color_t{},
+                             "assets: %d loaded, %d failed, %d of %d textures cached in %1.3f ms (read %1.3f ms, decode %1.3f ms, upload %1.3f ms)",
+                             stats.requested - stats.failed,
+                             stats.failed,
+                             stats.cache_hits,
+                             stats.cache_hits + stats.cache_misses,
+                             stats.elapsed.elapsed_milliseconds(),
+                             stats.read_time.elapsed_milliseconds(),
+                             stats.decode_time.elapsed_milliseconds(),
+                             stats.upload_time.elapsed_milliseconds());
+   }
+
+   if (m_capture.active()) {
+      const frame_capture_t::stats_t stats = m_capture.stats();
+      m_overlay.draw_text_va(color_t{},
+                             "capture %dx%d: %u frames, %u dropped, %u pending, cost %1.3f ms (avg %1.3f ms)",
+                             stats.size.x,
+                             stats.size.y,
+                             stats.frames_captured,
+                             stats.frames_dropped,
+                             stats.frames_pending,
+                             stats.last_cost.elapsed_milliseconds(),
+                             stats.average_cost.elapsed_milliseconds());
+   }
 
    m_overlay.render(m_graphics);
 }
@@ -235,5 +392,7 @@ void application_t::render()
 void application_t::post_render()
 {
    m_graphics.execute();
+   m_layouts.next_frame();
+   m_capture.capture_frame();
    m_window.swap_buffers();
 }
@@ -4,6 +4,8 @@
 
 #include "awry/awry.h"
 #include "utils/font.hpp"
+#include "utils/truetype.hpp"
+#include "utils/layout.hpp"
 #include "utils/colors.hpp"
 #include "utils/sprite.hpp"
 #include "utils/overlay.hpp"
@@ -35,12 +37,15 @@ private:
    runtime_t       &m_runtime;
    native_window_t &m_window;
    graphics_t      &m_graphics;
+   frame_capture_t &m_capture;
    mouse_t         &m_mouse;
    keyboard_t      &m_keyboard;
    point_t          m_window_size;
    point_t          m_canvas_size;
    timespan_t       m_app_time;
    timespan_t       m_frame_time;
+   int              m_screenshot_count = 0;
+   bool             m_antialiasing = true;
 
 private:
    enum class state_t 
@@ -50,15 +55,35 @@ private:
       over,
    };
 
+   enum sound_index_t
+   {
+      cannon0_sound,
+      cannon1_sound,
+      cannon2_sound,
+      boom_sound,
+      ready_sound,
+      sound_count,
+   };
+
    state_t          m_state = {};
+   asset_loader_t   m_assets;
+   asset_loader_t::handle_t m_sprite_asset;
+   sound_bank_t     m_sound_bank;
+   sound_t          m_sounds[sound_count];
+   sound_bus_t      m_effects_bus;
+   bool             m_effects_muffled = false;
+   bool             m_audio_recording = false;
+   timespan_t       m_sound_load_start;
+   timespan_t       m_sound_load_time;
+   bool             m_sounds_loaded = false;
    texture_t        m_sprite_tex;
    bitmap_font_t    m_font;
    overlay_t        m_overlay;
+   text_layout_engine_t m_layouts;
    float            m_splash_pulse = 0.0f;
    sprite_t         m_splash_spr;
    sprite_t         m_space_spr;
    sprite_t         m_tmmium_spr;
-   sprite_t         m_instructions_spr;
    cursor_t         m_cursor;
    starfield_t      m_starfield;
    solarsystem_t    m_solarsystem;
@@ -4,11 +4,97 @@
 #include <cmath>
 #include <random>
 #include <numbers>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stb_image.h>
 
 namespace
 {
    std::random_device                    g_random_device;
    std::uniform_real_distribution<float> g_uniform_distribution(0.0f, 1.0f);
+
+   FILE *open_file(const char *path, const char *mode)
+   {
+#if defined(_MSC_VER)
+      FILE *file = nullptr;
+      return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+      return fopen(path, mode);
+#endif
+   }
+
+   bool read_file(const char *path, std::vector<uint8_t> &content)
+   {
+      FILE *file = open_file(path, "rb");
+      if (file == nullptr) {
+         return false;
+      }
+
+      fseek(file, 0, SEEK_END);
+      const long size = ftell(file);
+      fseek(file, 0, SEEK_SET);
+
+      content.resize(size_t(std::max(size, 0l)));
+      const bool result = size >= 0 && fread(content.data(), 1, content.size(), file) == content.size();
+      fclose(file);
+
+      return result;
+   }
+
+   // note: layout of a <path>.rgba texture cache, the pixels follow the header
+   //       as tightly packed rgba8 rows, exactly what the texture upload takes.
+   struct texture_cache_header_t {
+      static constexpr uint32_t magic_value = 0x43545741; // note: 'AWTC'
+      static constexpr uint32_t version_value = 1;
+
+      uint32_t magic = magic_value;
+      uint32_t version = version_value;
+      uint32_t width = 0;
+      uint32_t height = 0;
+      uint64_t source_hash = 0;
+      uint64_t source_size = 0;
+      uint8_t  reserved[32] = {};
+   };
+
+   static_assert(sizeof(texture_cache_header_t) == 64);
+
+   // note: fnv1a over 64-bit words in four independent lanes, the multiplies
+   //       overlap and a sheet hashes at memory speed instead of byte by byte.
+   uint64_t hash_content(const std::span<const uint8_t> content)
+   {
+      uint64_t lanes[4] = {
+         14695981039346656037ull,
+         14695981039346656037ull ^ 1,
+         14695981039346656037ull ^ 2,
+         14695981039346656037ull ^ 3,
+      };
+
+      const size_t block_count = content.size() / 32;
+      for (size_t block = 0; block < block_count; block++) {
+         uint64_t words[4];
+         memcpy(words, content.data() + block * 32, sizeof(words));
+         for (int lane = 0; lane < 4; lane++) {
+            lanes[lane] ^= words[lane];
+            lanes[lane] *= 1099511628211ull;
+         }
+      }
+
+      uint64_t h = 14695981039346656037ull;
+      for (const uint64_t lane : lanes) {
+         h ^= lane;
+         h *= 1099511628211ull;
+      }
+
+      for (size_t index = block_count * 32; index < content.size(); index++) {
+         h ^= uint64_t(content[index]);
+         h *= 1099511628211ull;
+      }
+
+      h ^= uint64_t(content.size());
+      h *= 1099511628211ull;
+      return h;
+   }
 } // !anon
 
 // static 
@@ -103,6 +189,278 @@ matrix3_t matrix3_t::rotate(const float radians)
    };
 }
 
+asset_loader_t::asset_loader_t(thread_pool_t &pool)
+   : m_pool(pool)
+{
+}
+
+asset_loader_t::~asset_loader_t()
+{
+   std::unique_lock lock(m_mutex);
+   m_idle.wait(lock, [this] { return m_in_flight == 0; });
+
+   // note: decoded but never uploaded
+   for (request_t &request : m_uploads) {
+      free_pixels(request);
+   }
+}
+
+asset_loader_t::handle_t asset_loader_t::load_file(const char *path)
+{
+   request_t request;
+   request.asset = std::make_shared<asset_t>();
+   request.asset->path = path;
+
+   return submit(std::move(request));
+}
+
+asset_loader_t::handle_t asset_loader_t::load_texture(texture_t &texture,
+                                                      const char *path,
+                                                      const texture_t::filter_t filter,
+                                                      const texture_t::address_mode_t address)
+{
+   request_t request;
+   request.asset = std::make_shared<asset_t>();
+   request.asset->path = path;
+   request.texture = &texture;
+   request.filter = filter;
+   request.address = address;
+
+   return submit(std::move(request));
+}
+
+asset_loader_t::handle_t asset_loader_t::load_sound(sound_t &sound, const char *path)
+{
+   request_t request;
+   request.asset = std::make_shared<asset_t>();
+   request.asset->path = path;
+   request.sound = &sound;
+
+   // note: sounds already decode on the pool and register with the mixer themselves,
+   //       the loader only tracks them so progress() covers every asset.
+   const char *const paths[] = { path };
+   const bool reserved = sound_t::create_from_files(m_pool, std::span<sound_t>(&sound, 1), paths);
+
+   std::lock_guard lock(m_mutex);
+   handle_t result = request.asset;
+   if (m_stats.requested++ == 0) {
+      m_first_request = timespan_t::time_since_start();
+   }
+
+   m_stats.pending++;
+   if (reserved) {
+      m_sounds.push_back(std::move(request));
+   }
+   else {
+      finish(request, status_t::failed);
+   }
+
+   return result;
+}
+
+asset_loader_t::handle_t asset_loader_t::submit(request_t &&request)
+{
+   handle_t result = request.asset;
+   {
+      std::lock_guard lock(m_mutex);
+      if (m_stats.requested++ == 0) {
+         m_first_request = timespan_t::time_since_start();
+      }
+
+      m_stats.pending++;
+      m_in_flight++;
+   }
+
+   m_pool.submit([this, request = std::move(request)]() mutable {
+      asset_t &asset = *request.asset;
+      const timespan_t started = timespan_t::time_since_start();
+      std::vector<uint8_t> content;
+      const bool read = read_file(asset.path.c_str(), content);
+      const timespan_t decoding = timespan_t::time_since_start();
+      asset.read_time = decoding - started;
+
+      bool decoded = false;
+      if (read && request.texture != nullptr) {
+         // note: the source is read either way, its hash is what invalidates the cache
+         const uint64_t source_hash = hash_content(content);
+         const std::string cache_path = asset.path + ".rgba";
+         if (open_cache(cache_path, source_hash, content.size(), request)) {
+            asset.cached = true;
+         }
+         else {
+            int x = 0, y = 0, c = 0;
+            request.pixels = stbi_load_from_memory(content.data(), int(content.size()), &x, &y, &c, STBI_rgb_alpha);
+            request.size = { x, y };
+            if (request.pixels != nullptr) {
+               store_cache(cache_path, source_hash, content.size(), request);
+            }
+         }
+
+         decoded = request.pixels != nullptr;
+         asset.decode_time = timespan_t::time_since_start() - decoding;
+      }
+      else if (read) {
+         asset.content = std::move(content);
+      }
+
+      std::lock_guard lock(m_mutex);
+      m_stats.read_time += asset.read_time;
+      m_stats.decode_time += asset.decode_time;
+      if (decoded) {
+         (asset.cached ? m_stats.cache_hits : m_stats.cache_misses)++;
+         asset.status = status_t::uploading;
+         m_uploads.push_back(std::move(request));
+      }
+      else {
+         finish(request, read && request.texture == nullptr ? status_t::ready : status_t::failed);
+      }
+
+      if (--m_in_flight == 0) {
+         m_idle.notify_all();
+      }
+   });
+
+   return result;
+}
+
+void asset_loader_t::finish(request_t &request, const status_t status)
+{
+   // note: called with m_mutex held
+   request.asset->status = status;
+   m_stats.pending--;
+   if (status == status_t::failed) {
+      m_stats.failed++;
+   }
+
+   m_stats.elapsed = timespan_t::time_since_start() - m_first_request;
+}
+
+void asset_loader_t::update(const timespan_t budget)
+{
+   {
+      std::lock_guard lock(m_mutex);
+      std::erase_if(m_sounds, [this](request_t &request) {
+         if (request.sound->failed()) {
+            finish(request, status_t::failed);
+            return true;
+         }
+
+         if (!request.sound->ready()) {
+            return false;
+         }
+
+         finish(request, status_t::ready);
+         return true;
+      });
+   }
+
+   const timespan_t started = timespan_t::time_since_start();
+   for (bool first = true;; first = false) {
+      request_t request;
+      {
+         std::lock_guard lock(m_mutex);
+         if (m_uploads.empty() || (!first && timespan_t::time_since_start() - started >= budget)) {
+            break;
+         }
+
+         request = std::move(m_uploads.front());
+         m_uploads.erase(m_uploads.begin());
+      }
+
+      const timespan_t uploading = timespan_t::time_since_start();
+      const bool uploaded = request.texture->create(request.size, request.pixels, request.filter, request.address);
+      free_pixels(request);
+
+      std::lock_guard lock(m_mutex);
+      m_stats.upload_time += timespan_t::time_since_start() - uploading;
+      finish(request, uploaded ? status_t::ready : status_t::failed);
+   }
+}
+
+// static
+bool asset_loader_t::open_cache(const std::string &path, const uint64_t source_hash, const uint64_t source_size, request_t &request)
+{
+   auto mapping = std::make_shared<file_mapping_t>();
+   if (!mapping->open(path) || mapping->m_size < sizeof(texture_cache_header_t)) {
+      return false;
+   }
+
+   texture_cache_header_t header;
+   memcpy(&header, mapping->m_data, sizeof(header));
+   if (header.magic != texture_cache_header_t::magic_value ||
+       header.version != texture_cache_header_t::version_value ||
+       header.source_hash != source_hash ||
+       header.source_size != source_size ||
+       mapping->m_size != sizeof(header) + uint64_t(header.width) * header.height * 4) {
+      return false;
+   }
+
+   request.size = { int(header.width), int(header.height) };
+   request.pixels = mapping->m_data + sizeof(header);
+   request.mapping = std::move(mapping);
+
+   return true;
+}
+
+// static
+void asset_loader_t::store_cache(const std::string &path, const uint64_t source_hash, const uint64_t source_size, const request_t &request)
+{
+   // note: written aside and renamed into place, a reader never maps a partial file.
+   //       failing to write one, a read-only install say, only costs the next decode.
+   const std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+   FILE *file = open_file(temporary.c_str(), "wb");
+   if (file == nullptr) {
+      return;
+   }
+
+   texture_cache_header_t header;
+   header.width = uint32_t(request.size.x);
+   header.height = uint32_t(request.size.y);
+   header.source_hash = source_hash;
+   header.source_size = source_size;
+
+   const size_t pixel_size = size_t(request.size.x) * request.size.y * 4;
+   const bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                        fwrite(request.pixels, 1, pixel_size, file) == pixel_size;
+   fclose(file);
+
+   std::remove(path.c_str());
+   if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+      std::remove(temporary.c_str());
+   }
+}
+
+// static
+void asset_loader_t::free_pixels(request_t &request)
+{
+   if (request.mapping != nullptr) {
+      request.mapping.reset();
+   }
+   else {
+      stbi_image_free(const_cast<uint8_t *>(request.pixels));
+   }
+
+   request.pixels = nullptr;
+}
+
+bool asset_loader_t::idle() const
+{
+   std::lock_guard lock(m_mutex);
+   return m_stats.pending == 0;
+}
+
+float asset_loader_t::progress() const
+{
+   std::lock_guard lock(m_mutex);
+   return m_stats.requested > 0 ? float(m_stats.requested - m_stats.pending) / float(m_stats.requested) : 1.0f;
+}
+
+asset_loader_t::stats_t asset_loader_t::stats() const
+{
+   std::lock_guard lock(m_mutex);
+   return m_stats;
+}
+
 // static 
 float math_t::abs(float value)
 {
@@ -8,6 +8,14 @@
 #include <vector>
 #include <numbers>
 #include <span>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 template <typename T, size_t N>
 constexpr auto array_size(const T(&)[N]) { return N; }
@@ -226,6 +234,31 @@ struct matrix3_t {
    vector3_t z = { 0.0f,0.0f,1.0f };
 };
 
+struct triangulator_t {
+   static uint64_t hash(const std::span<const vector2_t> positions);
+   static bool triangulate(const std::span<const vector2_t> positions, std::vector<uint32_t> &indices);
+};
+
+// note: shapes are expected in local space, so the same outline hits the cache
+//       every frame and only pays for the hash and a compare. flushed when full,
+//       shapes that change every frame cannot grow it without bound.
+struct triangulation_cache_t {
+   static constexpr size_t max_entry_count = 256;
+
+   // note: the outline is kept to tell apart two shapes whose hashes collide
+   struct entry_t {
+      std::vector<vector2_t> positions;
+      std::vector<uint32_t>  indices;
+   };
+
+   const std::vector<uint32_t> &triangulate(const std::span<const vector2_t> positions);
+   void clear();
+
+   static bool same_outline(const std::span<const vector2_t> lhs, const std::span<const vector2_t> rhs);
+
+   std::unordered_map<uint64_t, entry_t> m_entries;
+};
+
 struct timespan_t {
    static constexpr timespan_t zero() { return timespan_t{ 0 }; }
    static constexpr timespan_t from_seconds(double seconds) { return timespan_t{ int64_t(seconds * 1000000.0) }; }
@@ -256,19 +289,218 @@ struct timespan_t {
    int64_t m_duration = 0;
 };
 
+// note: a fixed set of workers pulling tasks from one shared queue
+struct thread_pool_t {
+   // note: zero picks one worker per hardware thread, minus the calling thread
+   thread_pool_t(const int thread_count = 0);
+   ~thread_pool_t();
+
+   int thread_count() const;
+   void submit(std::function<void()> &&task);
+   // note: blocks until every submitted task has finished
+   void wait();
+
+   std::vector<std::thread>          m_threads;
+   std::mutex                        m_mutex;
+   std::condition_variable           m_task_ready;
+   std::condition_variable           m_idle;
+   std::deque<std::function<void()>> m_tasks;
+   int                               m_busy = 0;
+   bool                              m_stopping = false;
+};
+
+// note: read-only view of a whole file, the pages are shared with every other process mapping it
+struct file_mapping_t {
+   file_mapping_t() = default;
+   file_mapping_t(const file_mapping_t &) = delete;
+   file_mapping_t &operator=(const file_mapping_t &) = delete;
+   ~file_mapping_t();
+
+   bool valid() const;
+   bool open(const std::string_view &path);
+   void close();
+
+   std::span<const uint8_t> content() const { return { m_data, m_size }; }
+
+   void          *m_file = nullptr;
+   void          *m_mapping = nullptr;
+   const uint8_t *m_data = nullptr;
+   size_t         m_size = 0;
+};
+
+// note: sounds and streams mix into a bus, which filters, compresses and delays
+//       the sum once per block before adding it to its parent. everything ends
+//       up in the master bus, which always exists.
+struct sound_bus_t {
+   enum class filter_t : uint8_t {
+      none,
+      low_pass,
+      high_pass,
+      band_pass,
+   };
+
+   static sound_bus_t master();
+
+   sound_bus_t() = default;
+
+   bool valid() const;
+   bool create(const sound_bus_t &parent = master());
+   // note: sounds, streams and child buses routed here fall through to the parent
+   void destroy();
+
+   void set_volume(float volume);
+   void set_filter(const filter_t filter, const float cutoff = 1000.0f, const float q = 0.7071f);
+   // note: a ratio of one or less turns the compressor off. with a key bus the
+   //       gain follows the key's level instead of this bus's own, which ducks it.
+   void set_compressor(const float threshold_db, const float ratio, const float attack_ms = 10.0f, const float release_ms = 150.0f,
+                       const sound_bus_t *key = nullptr);
+   // note: a mix of zero turns the delay off, the time is clamped to 12 ms up to a second
+   void set_delay(const float time_ms, const float feedback, const float mix);
+
+   uint32_t m_id = 0;
+};
+
 struct sound_t {
+   // note: a new sound steals the oldest voice of the lowest priority that
+   //       is not above its own, or is dropped when all voices outrank it.
+   enum class priority_t : uint8_t {
+      low,
+      normal,
+      high,
+      critical,
+   };
+
+   // note: used whenever a sound's rate or pitch differs from the mixer's 44.1 kHz
+   enum class resampler_t : uint8_t {
+      linear,
+      sinc,
+   };
+
+   struct stats_t {
+      int      active_voices = 0;
+      uint32_t voices_played = 0;
+      uint32_t voices_stolen = 0;
+      uint32_t voices_dropped = 0;
+      uint32_t commands_dropped = 0;
+      // note: decoded sounds live in the arena, bank sounds in mapped files
+      uint64_t arena_bytes = 0;
+      uint64_t arena_used_bytes = 0;
+      uint64_t arena_largest_free_bytes = 0;
+      uint64_t mapped_bytes = 0;
+      // note: share of free arena bytes outside the largest free range
+      float    arena_fragmentation = 0.0f;
+      uint32_t arena_compactions = 0;
+      uint64_t arena_moved_bytes = 0;
+   };
+
+   // note: fixed width buckets, anything past the last one lands in overflow
+   struct histogram_t {
+      static constexpr int bucket_count = 64;
+
+      // note: upper edge of the bucket holding the given fraction of samples
+      float percentile(const float fraction) const;
+
+      float    bucket_width_ms = 0.0f;
+      uint32_t buckets[bucket_count] = {};
+      uint32_t overflow = 0;
+      uint32_t count = 0;
+      float    min_ms = 0.0f;
+      float    max_ms = 0.0f;
+      float    mean_ms = 0.0f;
+   };
+
+   struct telemetry_t {
+      // note: play() until the first sample of the sound reaches the device,
+      //       which includes whatever the device already had queued.
+      histogram_t latency;
+      histogram_t block_time;
+      float       block_budget_ms = 0.0f;
+      uint32_t    blocks = 0;
+      uint32_t    underruns = 0;
+      uint32_t    stream_underruns = 0;
+      int         queued_frames = 0;
+      int         active_voices = 0;
+      int         peak_voices = 0;
+   };
+
+   static stats_t stats();
+   static telemetry_t telemetry();
+   static void reset_telemetry();
+   // note: one csv row per mixed block, written off the audio thread, so a
+   //       headless run with a null or wav sink records the same numbers.
+   static bool start_telemetry_recording(const char *path);
+   static void stop_telemetry_recording();
+   static void set_resampler(const resampler_t resampler);
+
+   // note: decodes on the pool, every handle is valid on return and plays
+   //       silence until its own decode has been registered with the mixer.
+   static bool create_from_files(thread_pool_t &pool, std::span<sound_t> sounds, std::span<const char *const> paths);
+
    sound_t() = default;
 
    bool valid() const;
+   bool ready() const;
+   // note: its decode or upload went wrong, a failed sound stays valid but silent until destroyed
+   bool failed() const;
    bool create_from_file(const char *path);
    bool create_from_memory(const std::vector<uint8_t> &content);
    void destroy();
 
-   void play(float volume);
+   void set_priority(const priority_t priority);
+   // note: zero is unlimited, past the cap the oldest instance of this sound is restarted
+   void set_max_instances(const int count);
+   void set_bus(const sound_bus_t &bus);
+
+   // note: never blocks, the audio thread applies these at its next block. pitch
+   //       scales the playback rate and is clamped to a quarter up to four times.
+   void play(float volume, float pitch = 1.0f);
+   void stop();
+   void set_volume(float volume);
+   bool playing() const;
 
    uint32_t m_id = 0;
 };
 
+// note: decodes incrementally on the audio streaming thread, memory stays
+//       constant regardless of the length of the track. tracks have to be
+//       encoded at 44100 hz, any other rate fails to create.
+struct sound_stream_t {
+   sound_stream_t() = default;
+
+   bool valid() const;
+   bool create_from_file(const char *path);
+   bool create_from_memory(std::vector<uint8_t> content);
+   void destroy();
+
+   void play(float volume, bool loop = true);
+   void stop();
+   void set_volume(float volume);
+   void set_bus(const sound_bus_t &bus);
+
+   uint32_t m_id = 0;
+};
+
+// note: a bank written by tools/soundbank, its sounds are mixed straight out of
+//       the mapped file and the mapping lives until the mixer releases the last one.
+struct sound_bank_t {
+   struct entry_t {
+      std::string name;
+      sound_t     sound;
+   };
+
+   sound_bank_t() = default;
+
+   bool valid() const;
+   bool create_from_file(const char *path);
+   void destroy();
+
+   // note: looks a sound up by the file stem it was built from, the bank keeps ownership
+   sound_t find(const std::string_view &name) const;
+
+   std::shared_ptr<file_mapping_t> m_mapping;
+   std::vector<entry_t>            m_entries;
+};
+
 struct color_t {
    constexpr color_t() = default;
    constexpr color_t(uint8_t r, uint8_t g, uint8_t b, uint8_t a) : r(r), g(g), b(b), a(a) {}
@@ -307,6 +539,8 @@ struct texture_t {
    bool create_from_memory(const std::vector<uint8_t> &content,
                            const filter_t filter = filter_t::nearest,
                            const address_mode_t address = address_mode_t::clamp);
+   // note: uploads rgba pixels into area, pitch is the source row length in pixels (0 = area width)
+   bool update(const rectangle_t &area, const void *data, const int pitch = 0);
    void destroy();
 
    uint32_t m_id = 0;
@@ -317,9 +551,12 @@ struct zip_archive_t {
    struct zip_entry_t {
       std::string name;
       uint64_t hash = 0;
-      uint64_t data_offset = 0;
+      // note: the local header's name and extra field lengths can differ from the
+      //       central directory's, zip_stream_t::open reads them to find the data
+      uint64_t local_header_offset = 0;
       uint64_t size_compressed = 0;
       uint64_t size_uncompressed = 0;
+      uint16_t method = 0;
    };
 
    zip_archive_t();
@@ -330,12 +567,168 @@ struct zip_archive_t {
    void close();
 
    bool contains(const std::string_view &path) const;
+   const zip_entry_t *find(const std::string_view &path) const;
    bool load_content(const std::string_view &path, std::vector<uint8_t> &content);
-
-   void *m_handle;
+   // note: content has to be exactly size_uncompressed, compressed bytes are read a chunk at a time
+   bool load_content(const std::string_view &path, std::span<uint8_t> content);
+
+   // note: called on the thread that called load_many, in the order entries finish.
+   //       content is empty when the entry is missing or failed to decode.
+   using loaded_t = std::function<void(size_t index, bool success, std::vector<uint8_t> &content)>;
+   // note: every entry reads and inflates as its own task on the pool, largest first.
+   //       returns once all are handed back, true when all of them loaded. it blocks
+   //       until then, so never call it from a task on the same pool, a worker
+   //       waiting on tasks queued behind it can deadlock the pool.
+   bool load_many(thread_pool_t &pool, std::span<const std::string_view> paths, const loaded_t &loaded) const;
+
+   // note: per platform, the rest of the archive and its streams are portable. reads
+   //       are positioned, no file pointer is shared between the threads using them.
+   static void *open_file(const std::string_view &path, uint64_t &size);
+   static void close_file(void *handle);
+   static uint32_t read_file(void *handle, const uint64_t offset, void *buffer, const uint32_t size);
+
+   void *m_handle = nullptr;
    std::vector<zip_entry_t> m_entries;
 };
 
+struct inflate_t;
+
+// note: reads one entry front to back without holding all of it. deflated entries
+//       inflate a chunk at a time into a window that keeps the last 32 kb as
+//       history, stored entries read straight from the file. read, skip and eof
+//       line up with stbi_io_callbacks and stb_vorbis pushdata.
+struct zip_stream_t {
+   static constexpr size_t input_chunk_size = 32 * 1024;
+   static constexpr size_t window_size = 64 * 1024;
+
+   zip_stream_t();
+   zip_stream_t(const zip_stream_t &) = delete;
+   zip_stream_t &operator=(const zip_stream_t &) = delete;
+   ~zip_stream_t();
+
+   bool valid() const;
+   bool open(const zip_archive_t &archive, const std::string_view &path);
+   void close();
+
+   // note: short only at the end of the entry or on failure
+   size_t read(std::span<uint8_t> buffer);
+   bool skip(uint64_t count);
+   bool eof() const;
+   bool failed() const;
+   uint64_t size() const;
+   uint64_t position() const;
+
+   bool fill_input();
+   bool fill_window();
+   void decode(const uint8_t *window, uint8_t *&output, uint8_t *output_end);
+
+   void                      *m_handle = nullptr;
+   uint64_t                   m_data_offset = 0;
+   uint64_t                   m_size_compressed = 0;
+   uint64_t                   m_compressed_read = 0;
+   uint64_t                   m_size = 0;
+   uint64_t                   m_position = 0;
+   bool                       m_stored = false;
+   bool                       m_finished = false;
+   bool                       m_failed = false;
+   std::unique_ptr<inflate_t> m_inflater;
+   std::vector<uint8_t>       m_input;
+   size_t                     m_input_begin = 0;
+   size_t                     m_input_end = 0;
+   std::vector<uint8_t>       m_window;
+   size_t                     m_window_read = 0;
+   size_t                     m_window_write = 0;
+};
+
+// note: reads and decodes on the thread pool, several loads in flight overlap
+//       one file's read with another's decode. decoded textures wait for
+//       update() on the render thread, which owns the graphics context.
+//       a texture's rgba is cached next to its source as <path>.rgba, keyed by
+//       a hash of the source bytes, later loads map it and upload it as is.
+struct asset_loader_t {
+   enum class status_t {
+      loading, uploading, ready, failed,
+   };
+
+   struct asset_t {
+      bool done() const { return status.load() >= status_t::ready; }
+      bool failed() const { return status.load() == status_t::failed; }
+
+      std::string           path;
+      std::atomic<status_t> status = status_t::loading;
+      // note: the bytes of a load_file(), empty for textures and sounds
+      std::vector<uint8_t>  content;
+      bool                  cached = false;
+      timespan_t            read_time;
+      timespan_t            decode_time;
+   };
+
+   using handle_t = std::shared_ptr<const asset_t>;
+
+   struct stats_t {
+      int        requested = 0;
+      int        pending = 0;
+      int        failed = 0;
+      int        cache_hits = 0;
+      int        cache_misses = 0;
+      // note: summed over workers, more than elapsed when reads and decodes overlap
+      timespan_t read_time;
+      timespan_t decode_time;
+      timespan_t upload_time;
+      timespan_t elapsed;
+   };
+
+   asset_loader_t(thread_pool_t &pool);
+   asset_loader_t(const asset_loader_t &) = delete;
+   asset_loader_t &operator=(const asset_loader_t &) = delete;
+   // note: waits for the loads still running on the pool
+   ~asset_loader_t();
+
+   handle_t load_file(const char *path);
+   // note: texture is written by update(), it has to outlive the load
+   handle_t load_texture(texture_t &texture,
+                         const char *path,
+                         const texture_t::filter_t filter = texture_t::filter_t::nearest,
+                         const texture_t::address_mode_t address = texture_t::address_mode_t::clamp);
+   // note: the sound is valid on return and plays silence until decoded
+   handle_t load_sound(sound_t &sound, const char *path);
+
+   // note: render thread, uploads decoded textures until the budget is spent, always at least one
+   void update(const timespan_t budget = timespan_t::from_milliseconds(4.0));
+   bool idle() const;
+   float progress() const;
+   stats_t stats() const;
+
+   struct request_t {
+      std::shared_ptr<asset_t>  asset;
+      texture_t                *texture = nullptr;
+      texture_t::filter_t       filter = texture_t::filter_t::nearest;
+      texture_t::address_mode_t address = texture_t::address_mode_t::clamp;
+      sound_t                  *sound = nullptr;
+      point_t                   size;
+      // note: into the cache mapping when there is one, decoded by stb_image otherwise
+      const uint8_t            *pixels = nullptr;
+      std::shared_ptr<file_mapping_t> mapping;
+   };
+
+   // note: called on the workers, the cache is written as it is decoded
+   static bool open_cache(const std::string &path, const uint64_t source_hash, const uint64_t source_size, request_t &request);
+   static void store_cache(const std::string &path, const uint64_t source_hash, const uint64_t source_size, const request_t &request);
+   static void free_pixels(request_t &request);
+
+   handle_t submit(request_t &&request);
+   void finish(request_t &request, const status_t status);
+
+   thread_pool_t          &m_pool;
+   mutable std::mutex      m_mutex;
+   std::condition_variable m_idle;
+   std::vector<request_t>  m_uploads;
+   std::vector<request_t>  m_sounds;
+   int                     m_in_flight = 0;
+   stats_t                 m_stats;
+   timespan_t              m_first_request;
+};
+
 struct native_window_t {
    virtual ~native_window_t() = default;
    virtual bool poll_events() = 0;
@@ -430,9 +823,36 @@ struct input_context_t {
 };
 
 struct graphics_t {
+   enum class line_join_t {
+      miter, bevel,
+   };
+
+   // note: distance field styling, widths are in distance units where the
+   //       glyph edge sits at 0.5, offsets are in source texels and limited
+   //       by the padding baked around each glyph.
+   struct sdf_style_t {
+      bool operator==(const sdf_style_t &rhs) const
+      {
+         return outline_width == rhs.outline_width &&
+                outline_color.r == rhs.outline_color.r && outline_color.g == rhs.outline_color.g &&
+                outline_color.b == rhs.outline_color.b && outline_color.a == rhs.outline_color.a &&
+                shadow_offset.x == rhs.shadow_offset.x && shadow_offset.y == rhs.shadow_offset.y &&
+                shadow_softness == rhs.shadow_softness &&
+                shadow_color.r == rhs.shadow_color.r && shadow_color.g == rhs.shadow_color.g &&
+                shadow_color.b == rhs.shadow_color.b && shadow_color.a == rhs.shadow_color.a;
+      }
+
+      float     outline_width = 0.0f;
+      color_t   outline_color = { 0, 0, 0, 0 };
+      vector2_t shadow_offset = { 0.0f, 0.0f };
+      float     shadow_softness = 0.0f;
+      color_t   shadow_color = { 0, 0, 0, 0 };
+   };
+
    virtual ~graphics_t() = default;
    virtual void clear(const color_t &color) = 0;
    virtual void projection(const vector2_t &projection) = 0;
+   virtual void antialiasing(const bool enabled) = 0;
    virtual void draw_rect_filled(const rectangle_t &dst, const color_t &color) = 0;
    virtual void draw_rect_filled(const rectangle_t &dst, const matrix3_t &transform, const color_t &color) = 0;
    virtual void draw_rect_outlined(const rectangle_t &dst, const float thickness, const color_t &color) = 0;
@@ -445,14 +865,39 @@ struct graphics_t {
    virtual void draw_line(const vector2_t &from, const vector2_t &to, const float thickness, const color_t &color) = 0;
    virtual void draw_line(const vector2_t &from, const vector2_t &to, const float thickness, const color_t &from_color, const color_t &to_color) = 0;
    virtual void draw_line_strip(const std::span<const vector2_t> positions, const float thickness, const color_t &color) = 0;
+   virtual void draw_line_strip(const std::span<const vector2_t> positions, const float thickness, const bool closed, const line_join_t join, const color_t &color) = 0;
    virtual void draw_triangles_filled(const std::span<const vector2_t> positions, const color_t &color) = 0;
    virtual void draw(const texture_t &texture, const rectangle_t &src, const rectangle_t &dst, const color_t &color) = 0;
    virtual void draw(const texture_t &texture, const rectangle_t &src, const rectangle_t &dst, const matrix3_t &transform, const color_t &color) = 0;
-   //virtual void draw_polygon_filled() = 0;
-   //virtual void draw_polygon_outlined() = 0;
+   virtual void draw_sdf(const texture_t &texture, const rectangle_t &src, const vector2_t &position, const vector2_t &size, const sdf_style_t &style, const color_t &color) = 0;
+   virtual void draw_polygon_filled(const std::span<const vector2_t> positions, const color_t &color) = 0;
+   virtual void draw_polygon_filled(const std::span<const vector2_t> positions, const matrix3_t &transform, const color_t &color) = 0;
+   virtual void draw_polygon_outlined(const std::span<const vector2_t> positions, const float thickness, const color_t &color) = 0;
+   virtual void draw_polygon_outlined(const std::span<const vector2_t> positions, const float thickness, const matrix3_t &transform, const color_t &color) = 0;
    virtual void execute() = 0;
 };
 
+struct frame_capture_t {
+   struct stats_t {
+      point_t    size;
+      uint32_t   frames_captured = 0;
+      uint32_t   frames_dropped = 0;
+      uint32_t   frames_pending = 0;
+      timespan_t last_cost;
+      timespan_t average_cost;
+   };
+
+   virtual ~frame_capture_t() = default;
+   virtual bool active() const = 0;
+   virtual bool recording() const = 0;
+   virtual void screenshot(const char *path) = 0;
+   // note: raw top-down rgba frames back to back, resizing the window ends the recording
+   virtual bool start_recording(const char *path) = 0;
+   virtual void stop_recording() = 0;
+   virtual void capture_frame() = 0;
+   virtual stats_t stats() const = 0;
+};
+
 struct runtime_t {
    static inline runtime_t *ptr = nullptr;
 
@@ -462,10 +907,14 @@ struct runtime_t {
    auto &window()   { return *m_window; }
    auto &input()    { return *m_input; }
    auto &graphics() { return *m_graphics; }
+   auto &capture()  { return *m_capture; }
+   auto &thread_pool() { return *m_thread_pool; }
 
    point_t get_desktop_size() const;
 
    native_window_t *m_window = nullptr;
    input_context_t *m_input = nullptr;
    graphics_t      *m_graphics = nullptr;
+   frame_capture_t *m_capture = nullptr;
+   thread_pool_t   *m_thread_pool = nullptr;
 };
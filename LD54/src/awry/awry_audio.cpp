@@ -0,0 +1,2647 @@
+// awry_audio.cpp
+
+#include "awry_audio.h"
+#include "awry_soundbank.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#define AWRY_AUDIO_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AWRY_AUDIO_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(AWRY_AUDIO_ALSA)
+#include <alsa/asoundlib.h>
+#endif
+
+#define STB_VORBIS_HEADER_ONLY
+#include <stb_vorbis.h>
+
+namespace
+{
+   FILE *open_file(const char *path, const char *mode)
+   {
+#if defined(_MSC_VER)
+      FILE *file = nullptr;
+      return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+      return fopen(path, mode);
+#endif
+   }
+
+   void write_u16(FILE *file, const uint16_t value)
+   {
+      fwrite(&value, sizeof(value), 1, file);
+   }
+
+   void write_u32(FILE *file, const uint32_t value)
+   {
+      fwrite(&value, sizeof(value), 1, file);
+   }
+
+   bool decode_vorbis(stb_vorbis *vorbis, std::vector<short> &samples, int &channels, int &rate)
+   {
+      if (vorbis == nullptr) {
+         return false;
+      }
+
+      const stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+      const uint32_t num_samples = stb_vorbis_stream_length_in_samples(vorbis) * info.channels;
+
+      samples.resize(num_samples);
+      stb_vorbis_get_samples_short_interleaved(vorbis, info.channels, samples.data(), (int)samples.size());
+      stb_vorbis_close(vorbis);
+
+      channels = info.channels;
+      rate = int(info.sample_rate);
+
+      return true;
+   }
+
+   // note: blackman windowed sinc, one row of taps per 1/256th of a frame. each row sums
+   //       to one so a constant signal passes through at unity gain whatever the phase.
+   //       the stereo rows repeat every tap twice to line up with interleaved samples.
+   //       reading faster than one frame per frame moves the output nyquist down, so
+   //       each band lowers the cutoff for the largest step it covers and widens the
+   //       kernel by as much, keeping the transition as sharp as at unity.
+   struct sinc_band_t {
+      static constexpr int phase_count = audio_kernel_t::sinc_phase_count;
+      static constexpr double cutoff = 0.9;
+
+      sinc_band_t(const double max_step)
+         : max_step(max_step)
+         , tap_count(audio_kernel_t::sinc_tap_count * int(std::ceil(max_step)))
+         , mono(size_t(phase_count) * tap_count)
+         , stereo(size_t(phase_count) * tap_count * 2)
+      {
+         constexpr double pi = 3.14159265358979323846;
+         const double half_width = tap_count / 2;
+         const double band_cutoff = cutoff / max_step;
+
+         std::vector<double> taps(tap_count);
+         for (int phase = 0; phase < phase_count; phase++) {
+            const double fraction = double(phase) / phase_count;
+
+            double sum = 0.0;
+            for (int tap = 0; tap < tap_count; tap++) {
+               const double x = double(tap - (tap_count / 2 - 1)) - fraction;
+               const double sinc = x == 0.0 ? 1.0 : std::sin(pi * band_cutoff * x) / (pi * band_cutoff * x);
+               const double window = 0.42 + 0.5 * std::cos(pi * x / half_width) + 0.08 * std::cos(2.0 * pi * x / half_width);
+               taps[tap] = sinc * window;
+               sum += taps[tap];
+            }
+
+            float *mono_row = mono.data() + size_t(phase) * tap_count;
+            float *stereo_row = stereo.data() + size_t(phase) * tap_count * 2;
+            for (int tap = 0; tap < tap_count; tap++) {
+               mono_row[tap] = float(taps[tap] / sum);
+               stereo_row[tap * 2 + 0] = mono_row[tap];
+               stereo_row[tap * 2 + 1] = mono_row[tap];
+            }
+         }
+      }
+
+      const float *mono_row(const int phase) const { return mono.data() + size_t(phase) * tap_count; }
+      const float *stereo_row(const int phase) const { return stereo.data() + size_t(phase) * tap_count * 2; }
+
+      double             max_step = 1.0;
+      int                tap_count = 0;
+      std::vector<float> mono;
+      std::vector<float> stereo;
+   };
+
+   // note: steps past the last band use it and alias above a quarter of the nyquist
+   struct sinc_table_t {
+      static constexpr int band_count = 6;
+
+      sinc_table_t()
+         : bands{ 1.0, 1.25, 1.5, 2.0, 3.0, 4.0 }
+      {
+      }
+
+      const sinc_band_t &band(const uint64_t step) const
+      {
+         const double ratio = double(step) / double(audio_voice_t::unity_step);
+         for (const sinc_band_t &candidate : bands) {
+            if (ratio <= candidate.max_step) {
+               return candidate;
+            }
+         }
+
+         return bands[band_count - 1];
+      }
+
+      sinc_band_t bands[band_count];
+   };
+
+   const sinc_table_t &sinc_table()
+   {
+      static const sinc_table_t table;
+      return table;
+   }
+
+   float fraction_of(const uint64_t position)
+   {
+      return float(uint32_t(position) >> 8) * (1.0f / 16777216.0f);
+   }
+
+   // note: safe frames have every tap they read inside the source
+   int safe_frame_count(const uint64_t position, const uint64_t step, const uint64_t end, const int frame_count)
+   {
+      if (position >= end) {
+         return 0;
+      }
+
+      return int(std::min<uint64_t>((end - position + step - 1) / step, uint64_t(frame_count)));
+   }
+} // !anon
+
+// static
+void audio_kernel_t::accumulate_stereo(float *bus, const short *samples, const int frame_count, const float gain)
+{
+   const int count = frame_count * 2;
+   int index = 0;
+
+#if defined(AWRY_AUDIO_AVX2)
+   const __m256 gain8 = _mm256_set1_ps(gain);
+   for (; index + 8 <= count; index += 8) {
+      const __m128i raw = _mm_loadu_si128((const __m128i *)(samples + index));
+      const __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(raw));
+      const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(bus + index), _mm256_mul_ps(value, gain8));
+      _mm256_storeu_ps(bus + index, sum);
+   }
+#elif defined(AWRY_AUDIO_SSE2)
+   const __m128 gain4 = _mm_set1_ps(gain);
+   for (; index + 8 <= count; index += 8) {
+      const __m128i raw = _mm_loadu_si128((const __m128i *)(samples + index));
+      const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16));
+      const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16));
+      _mm_storeu_ps(bus + index + 0, _mm_add_ps(_mm_loadu_ps(bus + index + 0), _mm_mul_ps(lo, gain4)));
+      _mm_storeu_ps(bus + index + 4, _mm_add_ps(_mm_loadu_ps(bus + index + 4), _mm_mul_ps(hi, gain4)));
+   }
+#endif
+
+   for (; index < count; index++) {
+      bus[index] += float(samples[index]) * gain;
+   }
+}
+
+// static
+void audio_kernel_t::accumulate_mono(float *bus, const short *samples, const int frame_count, const float gain)
+{
+   int index = 0;
+
+#if defined(AWRY_AUDIO_AVX2)
+   const __m256 gain8 = _mm256_set1_ps(gain);
+   for (; index + 8 <= frame_count; index += 8) {
+      const __m128i raw = _mm_loadu_si128((const __m128i *)(samples + index));
+      const __m256 value = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(raw)), gain8);
+      const __m256 lo = _mm256_unpacklo_ps(value, value);
+      const __m256 hi = _mm256_unpackhi_ps(value, value);
+      float *dst = bus + index * 2;
+      _mm256_storeu_ps(dst + 0, _mm256_add_ps(_mm256_loadu_ps(dst + 0), _mm256_permute2f128_ps(lo, hi, 0x20)));
+      _mm256_storeu_ps(dst + 8, _mm256_add_ps(_mm256_loadu_ps(dst + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+   }
+#elif defined(AWRY_AUDIO_SSE2)
+   const __m128 gain4 = _mm_set1_ps(gain);
+   for (; index + 4 <= frame_count; index += 4) {
+      const __m128i raw = _mm_loadl_epi64((const __m128i *)(samples + index));
+      const __m128 value = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16)), gain4);
+      float *dst = bus + index * 2;
+      _mm_storeu_ps(dst + 0, _mm_add_ps(_mm_loadu_ps(dst + 0), _mm_unpacklo_ps(value, value)));
+      _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_unpackhi_ps(value, value)));
+   }
+#endif
+
+   for (; index < frame_count; index++) {
+      const float value = float(samples[index]) * gain;
+      bus[index * 2 + 0] += value;
+      bus[index * 2 + 1] += value;
+   }
+}
+
+// static
+void audio_kernel_t::clamp(float *bus, const int count)
+{
+   int index = 0;
+
+#if defined(AWRY_AUDIO_AVX2)
+   const __m256 lower8 = _mm256_set1_ps(-1.0f);
+   const __m256 upper8 = _mm256_set1_ps(1.0f);
+   for (; index + 8 <= count; index += 8) {
+      _mm256_storeu_ps(bus + index, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(bus + index), lower8), upper8));
+   }
+#elif defined(AWRY_AUDIO_SSE2)
+   const __m128 lower4 = _mm_set1_ps(-1.0f);
+   const __m128 upper4 = _mm_set1_ps(1.0f);
+   for (; index + 4 <= count; index += 4) {
+      _mm_storeu_ps(bus + index, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(bus + index), lower4), upper4));
+   }
+#endif
+
+   for (; index < count; index++) {
+      bus[index] = std::min(std::max(bus[index], -1.0f), 1.0f);
+   }
+}
+
+// static
+int audio_kernel_t::resample_linear(float *bus, const short *samples, const int channel_count, const uint32_t source_frame_count,
+                                    uint64_t &position, const uint64_t step, const int frame_count, const float gain)
+{
+   const uint64_t end = uint64_t(source_frame_count) << 32;
+   const uint64_t last = source_frame_count > 0 ? uint64_t(source_frame_count - 1) << 32 : 0;
+   const int safe_count = safe_frame_count(position, step, last, frame_count);
+   int index = 0;
+
+#if defined(AWRY_AUDIO_SSE2)
+   const __m128 gain4 = _mm_set1_ps(gain);
+   if (channel_count == 2) {
+      // note: two output frames per pass, each reads its frame pair as l0 r0 l1 r1
+      for (; index + 2 <= safe_count; index += 2) {
+         const uint64_t a = position;
+         const uint64_t b = position + step;
+         const __m128i raw_a = _mm_loadl_epi64((const __m128i *)(samples + (a >> 32) * 2));
+         const __m128i raw_b = _mm_loadl_epi64((const __m128i *)(samples + (b >> 32) * 2));
+         const __m128 value_a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw_a, raw_a), 16));
+         const __m128 value_b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw_b, raw_b), 16));
+         const __m128 from = _mm_movelh_ps(value_a, value_b);
+         const __m128 to = _mm_movehl_ps(value_b, value_a);
+         const __m128 fraction = _mm_setr_ps(fraction_of(a), fraction_of(a), fraction_of(b), fraction_of(b));
+         const __m128 value = _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), fraction));
+         float *dst = bus + index * 2;
+         _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(value, gain4)));
+         position += step * 2;
+      }
+   }
+   else {
+      for (; index + 4 <= safe_count; index += 4) {
+         const uint64_t a = position;
+         const uint64_t b = a + step;
+         const uint64_t c = b + step;
+         const uint64_t d = c + step;
+         const short *sa = samples + (a >> 32);
+         const short *sb = samples + (b >> 32);
+         const short *sc = samples + (c >> 32);
+         const short *sd = samples + (d >> 32);
+         const __m128 from = _mm_cvtepi32_ps(_mm_setr_epi32(sa[0], sb[0], sc[0], sd[0]));
+         const __m128 to = _mm_cvtepi32_ps(_mm_setr_epi32(sa[1], sb[1], sc[1], sd[1]));
+         const __m128 fraction = _mm_setr_ps(fraction_of(a), fraction_of(b), fraction_of(c), fraction_of(d));
+         const __m128 value = _mm_mul_ps(_mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), fraction)), gain4);
+         float *dst = bus + index * 2;
+         _mm_storeu_ps(dst + 0, _mm_add_ps(_mm_loadu_ps(dst + 0), _mm_unpacklo_ps(value, value)));
+         _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_unpackhi_ps(value, value)));
+         position += step * 4;
+      }
+   }
+#endif
+
+   // note: the last source frame fades towards silence rather than reading past the end
+   for (; index < frame_count && position < end; index++) {
+      const uint32_t frame = uint32_t(position >> 32);
+      const bool has_next = frame + 1 < source_frame_count;
+      const float fraction = fraction_of(position);
+      for (int channel = 0; channel < 2; channel++) {
+         const int source_channel = channel_count == 2 ? channel : 0;
+         const float from = float(samples[size_t(frame) * channel_count + source_channel]);
+         const float to = has_next ? float(samples[size_t(frame + 1) * channel_count + source_channel]) : 0.0f;
+         bus[index * 2 + channel] += (from + (to - from) * fraction) * gain;
+      }
+
+      position += step;
+   }
+
+   return index;
+}
+
+// static
+int audio_kernel_t::resample_sinc(float *bus, const short *samples, const int channel_count, const uint32_t source_frame_count,
+                                  uint64_t &position, const uint64_t step, const int frame_count, const float gain)
+{
+   const sinc_band_t &band = sinc_table().band(step);
+   const int tap_count = band.tap_count;
+   const int taps_before = tap_count / 2 - 1;
+   const int taps_after = tap_count / 2;
+
+   const uint64_t end = uint64_t(source_frame_count) << 32;
+   const uint64_t first = uint64_t(taps_before) << 32;
+   const uint64_t last = source_frame_count > uint32_t(taps_after) ? uint64_t(source_frame_count - taps_after) << 32 : 0;
+
+   int index = 0;
+   for (; index < frame_count && position < end; index++) {
+      const uint32_t frame = uint32_t(position >> 32);
+      const int phase = int(uint32_t(position) >> 24);
+      float *dst = bus + index * 2;
+
+      if (position < first || position >= last) {
+         // note: the first and last few frames, taps outside the source read as silence
+         const float *coefficients = band.mono_row(phase);
+         float sum[2] = {};
+         for (int tap = 0; tap < tap_count; tap++) {
+            const int64_t source = int64_t(frame) - taps_before + tap;
+            if (source < 0 || source >= int64_t(source_frame_count)) {
+               continue;
+            }
+
+            for (int channel = 0; channel < 2; channel++) {
+               const int source_channel = channel_count == 2 ? channel : 0;
+               sum[channel] += float(samples[size_t(source) * channel_count + source_channel]) * coefficients[tap];
+            }
+         }
+
+         dst[0] += sum[0] * gain;
+         dst[1] += sum[1] * gain;
+      }
+      else if (channel_count == 2) {
+         // note: tap counts are multiples of eight, sixteen interleaved samples per pass
+         const short *source = samples + size_t(frame - taps_before) * 2;
+         const float *coefficients = band.stereo_row(phase);
+#if defined(AWRY_AUDIO_AVX2)
+         __m256 sum8 = _mm256_setzero_ps();
+         for (int offset = 0; offset < tap_count * 2; offset += 16) {
+            const __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(source + offset + 0))));
+            const __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(source + offset + 8))));
+            sum8 = _mm256_add_ps(sum8, _mm256_add_ps(_mm256_mul_ps(lo, _mm256_loadu_ps(coefficients + offset + 0)),
+                                                     _mm256_mul_ps(hi, _mm256_loadu_ps(coefficients + offset + 8))));
+         }
+
+         __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+         sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+         _mm_storel_pi((__m64 *)dst, _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)dst), _mm_mul_ps(sum, _mm_set1_ps(gain))));
+#elif defined(AWRY_AUDIO_SSE2)
+         __m128 sum = _mm_setzero_ps();
+         for (int offset = 0; offset < tap_count * 2; offset += 8) {
+            const __m128i raw = _mm_loadu_si128((const __m128i *)(source + offset));
+            const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16));
+            const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16));
+            sum = _mm_add_ps(sum, _mm_mul_ps(lo, _mm_loadu_ps(coefficients + offset + 0)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(hi, _mm_loadu_ps(coefficients + offset + 4)));
+         }
+
+         sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+         _mm_storel_pi((__m64 *)dst, _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)dst), _mm_mul_ps(sum, _mm_set1_ps(gain))));
+#else
+         float sum[2] = {};
+         for (int tap = 0; tap < tap_count * 2; tap += 2) {
+            sum[0] += float(source[tap + 0]) * coefficients[tap + 0];
+            sum[1] += float(source[tap + 1]) * coefficients[tap + 1];
+         }
+
+         dst[0] += sum[0] * gain;
+         dst[1] += sum[1] * gain;
+#endif
+      }
+      else {
+         const short *source = samples + (frame - taps_before);
+         const float *coefficients = band.mono_row(phase);
+#if defined(AWRY_AUDIO_AVX2)
+         __m256 product = _mm256_setzero_ps();
+         for (int offset = 0; offset < tap_count; offset += 8) {
+            const __m256 taps = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(source + offset))));
+            product = _mm256_add_ps(product, _mm256_mul_ps(taps, _mm256_loadu_ps(coefficients + offset)));
+         }
+
+         __m128 sum = _mm_add_ps(_mm256_castps256_ps128(product), _mm256_extractf128_ps(product, 1));
+#elif defined(AWRY_AUDIO_SSE2)
+         __m128 sum = _mm_setzero_ps();
+         for (int offset = 0; offset < tap_count; offset += 8) {
+            const __m128i raw = _mm_loadu_si128((const __m128i *)(source + offset));
+            const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16));
+            const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16));
+            sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(lo, _mm_loadu_ps(coefficients + offset + 0)), _mm_mul_ps(hi, _mm_loadu_ps(coefficients + offset + 4))));
+         }
+#endif
+#if defined(AWRY_AUDIO_SSE2)
+         sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+         sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+         const float value = _mm_cvtss_f32(sum) * gain;
+#else
+         float value = 0.0f;
+         for (int tap = 0; tap < tap_count; tap++) {
+            value += float(source[tap]) * coefficients[tap];
+         }
+
+         value *= gain;
+#endif
+         dst[0] += value;
+         dst[1] += value;
+      }
+
+      position += step;
+   }
+
+   return index;
+}
+
+// static
+void audio_kernel_t::mix(float *dst, const float *src, const int count, const float gain)
+{
+   int index = 0;
+
+#if defined(AWRY_AUDIO_AVX2)
+   const __m256 gain8 = _mm256_set1_ps(gain);
+   for (; index + 8 <= count; index += 8) {
+      _mm256_storeu_ps(dst + index, _mm256_add_ps(_mm256_loadu_ps(dst + index), _mm256_mul_ps(_mm256_loadu_ps(src + index), gain8)));
+   }
+#elif defined(AWRY_AUDIO_SSE2)
+   const __m128 gain4 = _mm_set1_ps(gain);
+   for (; index + 4 <= count; index += 4) {
+      _mm_storeu_ps(dst + index, _mm_add_ps(_mm_loadu_ps(dst + index), _mm_mul_ps(_mm_loadu_ps(src + index), gain4)));
+   }
+#endif
+
+   for (; index < count; index++) {
+      dst[index] += src[index] * gain;
+   }
+}
+
+// static
+float audio_kernel_t::peak(const float *src, const int count)
+{
+   int index = 0;
+   float result = 0.0f;
+
+#if defined(AWRY_AUDIO_SSE2)
+   // note: clearing the sign bit is the absolute value
+   const __m128 mask4 = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+   __m128 peak4 = _mm_setzero_ps();
+   for (; index + 4 <= count; index += 4) {
+      peak4 = _mm_max_ps(peak4, _mm_and_ps(_mm_loadu_ps(src + index), mask4));
+   }
+
+   peak4 = _mm_max_ps(peak4, _mm_movehl_ps(peak4, peak4));
+   peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(1, 1, 1, 1)));
+   result = _mm_cvtss_f32(peak4);
+#endif
+
+   for (; index < count; index++) {
+      result = std::max(result, std::fabs(src[index]));
+   }
+
+   return result;
+}
+
+void audio_biquad_t::configure(const sound_bus_t::filter_t filter, const float cutoff, const float q, const float rate)
+{
+   type = filter;
+   if (type == sound_bus_t::filter_t::none) {
+      b0 = 1.0f;
+      b1 = b2 = a1 = a2 = 0.0f;
+      z1[0] = z1[1] = z2[0] = z2[1] = 0.0f;
+      return;
+   }
+
+   // note: the audio eq cookbook, state carries over so a moving cutoff does not click
+   constexpr double pi = 3.14159265358979323846;
+   const double frequency = std::clamp(double(cutoff), 10.0, double(rate) * 0.45);
+   const double w0 = 2.0 * pi * frequency / double(rate);
+   const double cos_w0 = std::cos(w0);
+   const double alpha = std::sin(w0) / (2.0 * std::clamp(double(q), 0.1, 20.0));
+   const double a0 = 1.0 + alpha;
+
+   double n0 = 0.0, n1 = 0.0, n2 = 0.0;
+   switch (type) {
+      case sound_bus_t::filter_t::low_pass: {
+         n0 = (1.0 - cos_w0) * 0.5;
+         n1 = 1.0 - cos_w0;
+         n2 = n0;
+      } break;
+
+      case sound_bus_t::filter_t::high_pass: {
+         n0 = (1.0 + cos_w0) * 0.5;
+         n1 = -(1.0 + cos_w0);
+         n2 = n0;
+      } break;
+
+      default: {
+         n0 = alpha;
+         n2 = -alpha;
+      } break;
+   }
+
+   b0 = float(n0 / a0);
+   b1 = float(n1 / a0);
+   b2 = float(n2 / a0);
+   a1 = float(-2.0 * cos_w0 / a0);
+   a2 = float((1.0 - alpha) / a0);
+}
+
+void audio_biquad_t::process(float *bus, const int frame_count)
+{
+   if (type == sound_bus_t::filter_t::none) {
+      return;
+   }
+
+#if defined(AWRY_AUDIO_SSE2)
+   const __m128 vb0 = _mm_set1_ps(b0);
+   const __m128 vb1 = _mm_set1_ps(b1);
+   const __m128 vb2 = _mm_set1_ps(b2);
+   const __m128 va1 = _mm_set1_ps(a1);
+   const __m128 va2 = _mm_set1_ps(a2);
+   __m128 s1 = _mm_setr_ps(z1[0], z1[1], 0.0f, 0.0f);
+   __m128 s2 = _mm_setr_ps(z2[0], z2[1], 0.0f, 0.0f);
+   for (int index = 0; index < frame_count; index++) {
+      __m64 *frame = (__m64 *)(bus + index * 2);
+      const __m128 x = _mm_loadl_pi(_mm_setzero_ps(), frame);
+      const __m128 y = _mm_add_ps(_mm_mul_ps(x, vb0), s1);
+      s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(x, vb1), _mm_mul_ps(y, va1)), s2);
+      s2 = _mm_sub_ps(_mm_mul_ps(x, vb2), _mm_mul_ps(y, va2));
+      _mm_storel_pi(frame, y);
+   }
+
+   float state[4];
+   _mm_storeu_ps(state, s1);
+   z1[0] = state[0];
+   z1[1] = state[1];
+   _mm_storeu_ps(state, s2);
+   z2[0] = state[0];
+   z2[1] = state[1];
+#else
+   for (int index = 0; index < frame_count; index++) {
+      for (int channel = 0; channel < 2; channel++) {
+         const float x = bus[index * 2 + channel];
+         const float y = x * b0 + z1[channel];
+         z1[channel] = x * b1 - y * a1 + z2[channel];
+         z2[channel] = x * b2 - y * a2;
+         bus[index * 2 + channel] = y;
+      }
+   }
+#endif
+}
+
+void audio_compressor_t::configure(const float threshold, const float ratio, const float attack_ms, const float release_ms, const float rate)
+{
+   const float slice_ms = 1000.0f * float(slice_frame_count) / rate;
+   enabled = ratio > 1.0f;
+   threshold_db = threshold;
+   slope = enabled ? 1.0f - 1.0f / ratio : 0.0f;
+   attack = std::exp(-slice_ms / std::max(attack_ms, 0.1f));
+   release = std::exp(-slice_ms / std::max(release_ms, 0.1f));
+   if (!enabled) {
+      envelope = 0.0f;
+      gain = 1.0f;
+   }
+}
+
+void audio_compressor_t::process(float *bus, const int frame_count, const float key_peak)
+{
+   if (!enabled) {
+      return;
+   }
+
+   for (int first = 0; first < frame_count; first += slice_frame_count) {
+      const int count = std::min(slice_frame_count, frame_count - first);
+      float *slice = bus + first * 2;
+
+      const float level = key_peak >= 0.0f ? key_peak : audio_kernel_t::peak(slice, count * 2);
+      const float coefficient = level > envelope ? attack : release;
+      envelope = level + (envelope - level) * coefficient;
+
+      const float over = 20.0f * std::log10(std::max(envelope, 1e-6f)) - threshold_db;
+      const float target = over > 0.0f ? std::pow(10.0f, -over * slope * (1.0f / 20.0f)) : 1.0f;
+      const float delta = (target - gain) / float(count);
+
+      int index = 0;
+#if defined(AWRY_AUDIO_SSE2)
+      // note: two frames per pass, both channels of a frame share its gain
+      __m128 ramp = _mm_setr_ps(gain + delta, gain + delta, gain + delta * 2.0f, gain + delta * 2.0f);
+      const __m128 advance = _mm_set1_ps(delta * 2.0f);
+      for (; index + 2 <= count; index += 2) {
+         _mm_storeu_ps(slice + index * 2, _mm_mul_ps(_mm_loadu_ps(slice + index * 2), ramp));
+         ramp = _mm_add_ps(ramp, advance);
+      }
+#endif
+
+      for (; index < count; index++) {
+         const float frame_gain = gain + delta * float(index + 1);
+         slice[index * 2 + 0] *= frame_gain;
+         slice[index * 2 + 1] *= frame_gain;
+      }
+
+      gain = target;
+   }
+}
+
+void audio_delay_t::configure(const int delay_frame_count, const float feedback_gain, const float mix)
+{
+   const bool was_enabled = enabled;
+   enabled = mix > 0.0f && !line.empty();
+   frame_count = std::clamp(delay_frame_count, 2, std::max(int(line.size() / 2), 2));
+   feedback = std::clamp(feedback_gain, 0.0f, 0.95f);
+   wet = std::clamp(mix, 0.0f, 1.0f);
+
+   // note: an echo switched back on starts from silence rather than whatever was left in the line
+   if (enabled && !was_enabled) {
+      std::fill(line.begin(), line.end(), 0.0f);
+      write = 0;
+   }
+}
+
+void audio_delay_t::process(float *bus, const int count)
+{
+   if (!enabled) {
+      return;
+   }
+
+   const int length = int(line.size() / 2);
+   for (int done = 0; done < count;) {
+      const int read = write >= frame_count ? write - frame_count : write - frame_count + length;
+      const int frames = std::min({ count - done, length - write, length - read, frame_count });
+      float *dry = bus + done * 2;
+      float *to = line.data() + write * 2;
+      const float *from = line.data() + read * 2;
+
+      int index = 0;
+#if defined(AWRY_AUDIO_SSE2)
+      const __m128 feedback4 = _mm_set1_ps(feedback);
+      const __m128 wet4 = _mm_set1_ps(wet);
+      for (; index + 4 <= frames * 2; index += 4) {
+         const __m128 x = _mm_loadu_ps(dry + index);
+         const __m128 echo = _mm_loadu_ps(from + index);
+         _mm_storeu_ps(to + index, _mm_add_ps(x, _mm_mul_ps(echo, feedback4)));
+         _mm_storeu_ps(dry + index, _mm_add_ps(x, _mm_mul_ps(echo, wet4)));
+      }
+#endif
+
+      for (; index < frames * 2; index++) {
+         const float x = dry[index];
+         const float echo = from[index];
+         to[index] = x + echo * feedback;
+         dry[index] = x + echo * wet;
+      }
+
+      write = (write + frames) % length;
+      done += frames;
+   }
+}
+
+audio_arena_t::audio_arena_t(const uint32_t capacity, const int max_block_count)
+   : m_capacity(capacity)
+   , m_samples(new short[capacity])
+{
+   m_blocks.reserve(size_t(max_block_count));
+}
+
+uint32_t audio_arena_t::allocate(const uint16_t owner, const uint32_t sample_count)
+{
+   if (sample_count == 0 || m_blocks.size() == m_blocks.capacity()) {
+      return npos;
+   }
+
+   // note: first fit, the gap before each block and then the tail
+   uint32_t cursor = 0;
+   size_t position = 0;
+   for (; position < m_blocks.size(); position++) {
+      if (m_blocks[position].offset - cursor >= sample_count) {
+         break;
+      }
+
+      cursor = align_up(m_blocks[position].offset + m_blocks[position].size);
+   }
+
+   if (position == m_blocks.size() && (cursor > m_capacity || m_capacity - cursor < sample_count)) {
+      return npos;
+   }
+
+   m_blocks.insert(m_blocks.begin() + position, { cursor, sample_count, owner });
+   m_used += sample_count;
+
+   return cursor;
+}
+
+void audio_arena_t::release(const uint16_t owner)
+{
+   for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+      if (it->owner == owner) {
+         m_used -= it->size;
+         m_blocks.erase(it);
+         return;
+      }
+   }
+}
+
+audio_arena_t::stats_t audio_arena_t::stats() const
+{
+   stats_t result;
+   result.capacity = m_capacity;
+   result.used = m_used;
+   result.block_count = uint32_t(m_blocks.size());
+   result.compactions = m_compactions;
+   result.moved = m_moved;
+
+   uint32_t cursor = 0;
+   for (const block_t &block : m_blocks) {
+      result.largest_free = std::max(result.largest_free, block.offset - cursor);
+      cursor = align_up(block.offset + block.size);
+   }
+
+   if (cursor < m_capacity) {
+      result.largest_free = std::max(result.largest_free, m_capacity - cursor);
+   }
+
+   return result;
+}
+
+audio_histogram_t::audio_histogram_t(const uint32_t bucket_width)
+   : bucket_width_us(bucket_width)
+{
+}
+
+void audio_histogram_t::add(const uint32_t value_us)
+{
+   // note: single writer, plain loads and stores keep the mixer off locked instructions
+   const uint32_t bucket = value_us / bucket_width_us;
+   bucket_t &slot = bucket < uint32_t(sound_t::histogram_t::bucket_count) ? buckets[bucket] : overflow;
+   slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   sum_us.store(sum_us.load(std::memory_order_relaxed) + value_us, std::memory_order_relaxed);
+   min_us.store(std::min(min_us.load(std::memory_order_relaxed), value_us), std::memory_order_relaxed);
+   max_us.store(std::max(max_us.load(std::memory_order_relaxed), value_us), std::memory_order_relaxed);
+}
+
+void audio_histogram_t::reset()
+{
+   for (auto &bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+   }
+
+   overflow.store(0, std::memory_order_relaxed);
+   count.store(0, std::memory_order_relaxed);
+   min_us.store(~0u, std::memory_order_relaxed);
+   max_us.store(0, std::memory_order_relaxed);
+   sum_us.store(0, std::memory_order_relaxed);
+}
+
+sound_t::histogram_t audio_histogram_t::snapshot() const
+{
+   sound_t::histogram_t result;
+   result.bucket_width_ms = float(bucket_width_us) * 0.001f;
+   for (int index = 0; index < sound_t::histogram_t::bucket_count; index++) {
+      result.buckets[index] = buckets[index].load(std::memory_order_relaxed);
+   }
+
+   result.overflow = overflow.load(std::memory_order_relaxed);
+   result.count = count.load(std::memory_order_relaxed);
+   if (result.count > 0) {
+      result.min_ms = float(min_us.load(std::memory_order_relaxed)) * 0.001f;
+      result.max_ms = float(max_us.load(std::memory_order_relaxed)) * 0.001f;
+      result.mean_ms = float(double(sum_us.load(std::memory_order_relaxed)) / result.count * 0.001);
+   }
+
+   return result;
+}
+
+float sound_t::histogram_t::percentile(const float fraction) const
+{
+   if (count == 0) {
+      return 0.0f;
+   }
+
+   const uint32_t target = std::max(uint32_t(std::ceil(double(count) * fraction)), 1u);
+   uint32_t seen = 0;
+   for (int index = 0; index < bucket_count; index++) {
+      seen += buckets[index];
+      if (seen >= target) {
+         return std::min(bucket_width_ms * float(index + 1), max_ms);
+      }
+   }
+
+   return max_ms;
+}
+
+audio_null_sink_t::audio_null_sink_t(const bool paced, const int queued_block_count)
+   : m_paced(paced)
+   , m_queued_block_count(std::max(queued_block_count, 1))
+{
+}
+
+bool audio_null_sink_t::open(const int sample_rate, const int, const int)
+{
+   m_sample_rate = sample_rate;
+   m_underruns = 0;
+   m_deadline = {};
+   return true;
+}
+
+void audio_null_sink_t::close()
+{
+}
+
+bool audio_null_sink_t::write(const float *, const int frame_count)
+{
+   if (m_paced) {
+      // note: advance a virtual playback clock so headless runs consume audio in real time.
+      //       m_deadline is when the last written frame has played, a write that comes
+      //       after it found the virtual device already silent.
+      const auto now = std::chrono::steady_clock::now();
+      if (now > m_deadline) {
+         if (m_deadline != std::chrono::steady_clock::time_point{}) {
+            m_underruns++;
+         }
+
+         m_deadline = now;
+      }
+
+      const auto block = std::chrono::nanoseconds(int64_t(frame_count) * 1000000000 / m_sample_rate);
+      m_deadline += block;
+      std::this_thread::sleep_until(m_deadline - block * m_queued_block_count);
+   }
+
+   return true;
+}
+
+int audio_null_sink_t::queued_frame_count()
+{
+   if (!m_paced) {
+      return 0;
+   }
+
+   const auto remaining = m_deadline - std::chrono::steady_clock::now();
+   return int(std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count(), 0) * m_sample_rate / 1000000000);
+}
+
+uint32_t audio_null_sink_t::underrun_count()
+{
+   return m_underruns;
+}
+
+audio_wav_sink_t::audio_wav_sink_t(const char *path, const bool paced)
+   : m_path(path)
+   , m_pacer(paced)
+{
+}
+
+audio_wav_sink_t::~audio_wav_sink_t()
+{
+   close();
+}
+
+bool audio_wav_sink_t::open(const int sample_rate, const int channel_count, const int block_frame_count)
+{
+   m_file = open_file(m_path.c_str(), "wb");
+   if (m_file == nullptr) {
+      return false;
+   }
+
+   m_channel_count = channel_count;
+   m_data_size = 0;
+
+   const uint16_t bytes_per_sample = sizeof(float);
+   fwrite("RIFF", 4, 1, m_file);
+   write_u32(m_file, 0);
+   fwrite("WAVE", 4, 1, m_file);
+   fwrite("fmt ", 4, 1, m_file);
+   write_u32(m_file, 16);
+   write_u16(m_file, 3);
+   write_u16(m_file, uint16_t(channel_count));
+   write_u32(m_file, uint32_t(sample_rate));
+   write_u32(m_file, uint32_t(sample_rate * channel_count * bytes_per_sample));
+   write_u16(m_file, uint16_t(channel_count * bytes_per_sample));
+   write_u16(m_file, 32);
+   fwrite("data", 4, 1, m_file);
+   write_u32(m_file, 0);
+
+   return m_pacer.open(sample_rate, channel_count, block_frame_count);
+}
+
+void audio_wav_sink_t::close()
+{
+   if (m_file == nullptr) {
+      return;
+   }
+
+   fseek(m_file, 4, SEEK_SET);
+   write_u32(m_file, 36 + m_data_size);
+   fseek(m_file, 40, SEEK_SET);
+   write_u32(m_file, m_data_size);
+   fclose(m_file);
+   m_file = nullptr;
+}
+
+bool audio_wav_sink_t::write(const float *samples, const int frame_count)
+{
+   if (m_file == nullptr) {
+      return false;
+   }
+
+   const size_t count = size_t(frame_count) * m_channel_count;
+   fwrite(samples, sizeof(float), count, m_file);
+   m_data_size += uint32_t(count * sizeof(float));
+
+   return m_pacer.write(samples, frame_count);
+}
+
+int audio_wav_sink_t::queued_frame_count()
+{
+   return m_pacer.queued_frame_count();
+}
+
+uint32_t audio_wav_sink_t::underrun_count()
+{
+   return m_pacer.underrun_count();
+}
+
+#if defined(AWRY_AUDIO_ALSA)
+audio_alsa_sink_t::audio_alsa_sink_t(const char *device)
+   : m_device(device)
+{
+}
+
+audio_alsa_sink_t::~audio_alsa_sink_t()
+{
+   close();
+}
+
+bool audio_alsa_sink_t::open(const int sample_rate, const int channel_count, const int block_frame_count)
+{
+   snd_pcm_t *pcm = nullptr;
+   if (snd_pcm_open(&pcm, m_device.c_str(), SND_PCM_STREAM_PLAYBACK, 0) < 0) {
+      return false;
+   }
+
+   // note: three blocks of device buffering, the same depth the windows sink queues
+   const unsigned int latency = unsigned(int64_t(block_frame_count) * 3 * 1000000 / sample_rate);
+   if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_FLOAT_LE, SND_PCM_ACCESS_RW_INTERLEAVED,
+                          unsigned(channel_count), unsigned(sample_rate), 1, latency) < 0)
+   {
+      snd_pcm_close(pcm);
+      return false;
+   }
+
+   m_pcm = pcm;
+
+   return true;
+}
+
+void audio_alsa_sink_t::close()
+{
+   if (m_pcm != nullptr) {
+      snd_pcm_drain((snd_pcm_t *)m_pcm);
+      snd_pcm_close((snd_pcm_t *)m_pcm);
+      m_pcm = nullptr;
+   }
+}
+
+bool audio_alsa_sink_t::write(const float *samples, const int frame_count)
+{
+   snd_pcm_t *pcm = (snd_pcm_t *)m_pcm;
+   if (pcm == nullptr) {
+      return false;
+   }
+
+   int written = 0;
+   while (written < frame_count) {
+      snd_pcm_sframes_t result = snd_pcm_writei(pcm, samples + written * 2, snd_pcm_uframes_t(frame_count - written));
+      if (result < 0) {
+         // note: recovers from underruns (-EPIPE) and suspends, anything else is fatal
+         if (result == -EPIPE) {
+            m_underruns++;
+         }
+
+         if (snd_pcm_recover(pcm, int(result), 1) < 0) {
+            return false;
+         }
+
+         continue;
+      }
+
+      written += int(result);
+   }
+
+   return true;
+}
+
+int audio_alsa_sink_t::queued_frame_count()
+{
+   snd_pcm_sframes_t delay = 0;
+   if (m_pcm == nullptr || snd_pcm_delay((snd_pcm_t *)m_pcm, &delay) < 0) {
+      return 0;
+   }
+
+   return int(std::max<snd_pcm_sframes_t>(delay, 0));
+}
+
+uint32_t audio_alsa_sink_t::underrun_count()
+{
+   return m_underruns;
+}
+#endif
+
+audio_device_t::audio_device_t(audio_sink_t &sink)
+   : m_sink(sink)
+   , m_arena(arena_sample_count, max_buffer_count)
+{
+   // note: free lists hand out low indices first
+   for (uint16_t index = 0; auto &buffer : m_buffers) {
+      buffer.handle.m_index = index;
+      m_free_buffers[max_buffer_count - 1 - index] = index;
+      index++;
+   }
+
+   m_free_buffer_count = max_buffer_count;
+
+   for (uint16_t index = 0; index < max_voice_count; index++) {
+      link(m_free_voices, &audio_voice_t::age_link, index);
+   }
+
+   for (uint16_t index = 0; auto &stream : m_streams) {
+      stream.handle.m_index = index++;
+   }
+
+   for (uint16_t index = 0; auto &node : m_buses) {
+      node.handle.m_index = index++;
+      node.samples.resize(size_t(block_frame_count) * channel_count);
+   }
+
+   m_buses[0].allocated = true;
+   m_buses[0].active = true;
+
+   m_bus.resize(size_t(block_frame_count) * channel_count);
+
+   audio_device_t::ptr = this;
+}
+
+audio_device_t::~audio_device_t()
+{
+   stop();
+
+   for (auto &stream : m_streams) {
+      close_stream(stream);
+   }
+
+   audio_device_t::ptr = nullptr;
+}
+
+bool audio_device_t::start()
+{
+   if (m_running) {
+      return true;
+   }
+
+   if (!m_sink.open(sample_rate, channel_count, block_frame_count)) {
+      return false;
+   }
+
+   m_running = true;
+   m_streamer = std::thread([this] {
+      uint32_t seen = 0;
+      while (m_running) {
+         m_stream_requests.wait(seen);
+         seen = m_stream_requests.load();
+         service_streams();
+         flush_telemetry();
+      }
+   });
+
+   m_thread = std::thread([this] {
+#if defined(AWRY_AUDIO_SSE2)
+      // note: flush denormals to zero, filter and echo tails decay into them otherwise
+      _mm_setcsr(_mm_getcsr() | 0x8040);
+#endif
+      while (m_running) {
+         const int64_t started = std::chrono::steady_clock::now().time_since_epoch().count();
+         mix(m_bus.data(), block_frame_count);
+         const int64_t mixed = std::chrono::steady_clock::now().time_since_epoch().count();
+         if (!m_sink.write(m_bus.data(), block_frame_count)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+         }
+
+         record_block(started, mixed, std::chrono::steady_clock::now().time_since_epoch().count());
+      }
+   });
+
+   return true;
+}
+
+void audio_device_t::stop()
+{
+   if (!m_running) {
+      return;
+   }
+
+   m_running = false;
+   request_streaming();
+   m_streamer.join();
+   m_thread.join();
+   m_sink.close();
+   stop_telemetry_recording();
+}
+
+void audio_device_t::play(indexer_t handle, float volume, float pitch)
+{
+   poll_events();
+
+   audio_buffer_t &buffer = m_buffers[handle.m_index];
+   if (buffer.handle != handle || buffer.loading || buffer.pcm == nullptr) {
+      return;
+   }
+
+   const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+   if (send({ audio_command_t::type_t::play, handle, volume, 0, std::clamp(pitch, 0.25f, 4.0f), {}, now })) {
+      buffer.playing_count++;
+   }
+}
+
+void audio_device_t::stop(indexer_t handle)
+{
+   if (m_buffers[handle.m_index].handle == handle) {
+      send({ audio_command_t::type_t::stop, handle });
+   }
+}
+
+void audio_device_t::set_volume(indexer_t handle, float volume)
+{
+   if (m_buffers[handle.m_index].handle == handle) {
+      send({ audio_command_t::type_t::volume, handle, volume });
+   }
+}
+
+bool audio_device_t::playing(indexer_t handle)
+{
+   poll_events();
+
+   const audio_buffer_t &buffer = m_buffers[handle.m_index];
+   return buffer.handle == handle && buffer.playing_count > 0;
+}
+
+bool audio_device_t::ready(indexer_t handle)
+{
+   poll_events();
+
+   const audio_buffer_t &buffer = m_buffers[handle.m_index];
+   return buffer.handle == handle && buffer.allocated && !buffer.loading && !buffer.failed;
+}
+
+bool audio_device_t::failed(indexer_t handle)
+{
+   poll_events();
+
+   const audio_buffer_t &buffer = m_buffers[handle.m_index];
+   return buffer.handle == handle && buffer.allocated && buffer.failed;
+}
+
+indexer_t audio_device_t::create(std::span<const short> samples, const int channels, const int source_rate)
+{
+   if (samples.empty() || channels <= 0 || source_rate <= 0) {
+      return indexer_t{ 0 };
+   }
+
+   const indexer_t handle = reserve();
+   if (handle.m_gen == 0) {
+      return handle;
+   }
+
+   audio_buffer_t &buffer = m_buffers[handle.m_index];
+   buffer.loading = false;
+   buffer.channel_count = channels;
+   buffer.sample_rate = uint32_t(source_rate);
+   if (!store(buffer, samples)) {
+      destroy(handle);
+      return indexer_t{ 0 };
+   }
+
+   return handle;
+}
+
+indexer_t audio_device_t::create_view(const short *pcm, const uint32_t frame_count, const int channels, const int source_rate,
+                                      std::shared_ptr<const file_mapping_t> mapping)
+{
+   if (pcm == nullptr || frame_count == 0 || channels <= 0 || source_rate <= 0) {
+      return indexer_t{ 0 };
+   }
+
+   const indexer_t handle = reserve();
+   if (handle.m_gen == 0) {
+      return handle;
+   }
+
+   audio_buffer_t &buffer = m_buffers[handle.m_index];
+   buffer.loading = false;
+   buffer.channel_count = channels;
+   buffer.frame_count = frame_count;
+   buffer.sample_rate = uint32_t(source_rate);
+   buffer.pcm = pcm;
+   buffer.mapping = std::move(mapping);
+   m_mapped_sample_count += uint64_t(frame_count) * channels;
+
+   return handle;
+}
+
+indexer_t audio_device_t::reserve()
+{
+   poll_events();
+
+   if (m_free_buffer_count == 0) {
+      return indexer_t{ 0 };
+   }
+
+   // note: the mixer has released this buffer, nothing reads it until the first command names it
+   audio_buffer_t &buffer = m_buffers[m_free_buffers[--m_free_buffer_count]];
+   buffer.allocated = true;
+   buffer.loading = true;
+   buffer.failed = false;
+   buffer.playing_count = 0;
+   buffer.channel_count = 0;
+   buffer.frame_count = 0;
+   buffer.sample_rate = 0;
+   buffer.pcm = nullptr;
+   buffer.arena = false;
+   buffer.mapping = {};
+   buffer.priority = uint8_t(sound_t::priority_t::normal);
+   buffer.max_instances = 0;
+   buffer.bus = 0;
+
+   return buffer.handle;
+}
+
+void audio_device_t::complete(indexer_t handle, std::vector<short> &&samples, const int channels, const int source_rate)
+{
+   std::lock_guard lock(m_load_mutex);
+   m_loaded.push_back({ handle, channels, source_rate, std::move(samples) });
+}
+
+void audio_device_t::destroy(indexer_t handle)
+{
+   audio_buffer_t &buffer = m_buffers[handle.m_index];
+   if (buffer.handle != handle || !buffer.allocated) {
+      return;
+   }
+
+   // note: the samples are freed once the mixer reports the buffer released,
+   //       a decode still in flight no longer matches the handle and is discarded.
+   buffer.handle.next();
+   buffer.allocated = false;
+   buffer.loading = false;
+   buffer.failed = false;
+   buffer.playing_count = 0;
+   send({ audio_command_t::type_t::release, handle }, 0);
+}
+
+void audio_device_t::set_priority(indexer_t handle, const sound_t::priority_t priority)
+{
+   if (m_buffers[handle.m_index].handle == handle) {
+      send({ audio_command_t::type_t::priority, handle, 1.0f, std::min(int(priority), priority_count - 1) });
+   }
+}
+
+void audio_device_t::set_max_instances(indexer_t handle, const int count)
+{
+   if (m_buffers[handle.m_index].handle == handle) {
+      send({ audio_command_t::type_t::max_instances, handle, 1.0f, std::clamp(count, 0, max_voice_count) });
+   }
+}
+
+sound_t::stats_t audio_device_t::stats()
+{
+   poll_events();
+
+   sound_t::stats_t result;
+   result.active_voices = m_active_voice_count.load(std::memory_order_relaxed);
+   result.voices_played = m_voices_played.load(std::memory_order_relaxed);
+   result.voices_stolen = m_voices_stolen.load(std::memory_order_relaxed);
+   result.voices_dropped = m_voices_dropped.load(std::memory_order_relaxed);
+   result.commands_dropped = m_commands_dropped.load(std::memory_order_relaxed);
+
+   const audio_arena_t::stats_t arena = m_arena.stats();
+   const uint32_t arena_free = arena.capacity - arena.used;
+   result.arena_bytes = uint64_t(arena.capacity) * sizeof(short);
+   result.arena_used_bytes = uint64_t(arena.used) * sizeof(short);
+   result.arena_largest_free_bytes = uint64_t(arena.largest_free) * sizeof(short);
+   result.arena_fragmentation = arena_free > 0 ? 1.0f - float(arena.largest_free) / float(arena_free) : 0.0f;
+   result.arena_compactions = arena.compactions;
+   result.arena_moved_bytes = arena.moved * sizeof(short);
+   result.mapped_bytes = m_mapped_sample_count * sizeof(short);
+
+   return result;
+}
+
+sound_t::telemetry_t audio_device_t::telemetry()
+{
+   sound_t::telemetry_t result;
+   result.latency = m_latency.snapshot();
+   result.block_time = m_block_time.snapshot();
+   result.block_budget_ms = 1000.0f * float(block_frame_count) / float(sample_rate);
+   result.blocks = m_blocks.load(std::memory_order_relaxed);
+   result.underruns = m_underruns.load(std::memory_order_relaxed);
+   result.queued_frames = m_queued_frames.load(std::memory_order_relaxed);
+   result.active_voices = m_active_voice_count.load(std::memory_order_relaxed);
+   result.peak_voices = m_peak_voice_count.load(std::memory_order_relaxed);
+   for (const auto &stream : m_streams) {
+      result.stream_underruns += stream.underruns.load(std::memory_order_relaxed);
+   }
+
+   return result;
+}
+
+void audio_device_t::reset_telemetry()
+{
+   send({ audio_command_t::type_t::reset_telemetry });
+}
+
+bool audio_device_t::start_telemetry_recording(const char *path)
+{
+   std::lock_guard lock(m_record_mutex);
+   if (m_record_file != nullptr) {
+      fclose(m_record_file);
+   }
+
+   m_record_file = open_file(path, "w");
+   if (m_record_file == nullptr) {
+      m_recording = false;
+      return false;
+   }
+
+   // note: rows queued before this recording started belong to no file
+   audio_block_record_t record;
+   while (m_block_records.pop(record)) {
+   }
+
+   fprintf(m_record_file, "block,time_ms,mix_us,queued_frames,underruns,active_voices,plays,max_latency_ms\n");
+   m_record_start = std::chrono::steady_clock::now().time_since_epoch().count();
+   m_records_dropped = 0;
+   m_recording = true;
+
+   return true;
+}
+
+void audio_device_t::stop_telemetry_recording()
+{
+   m_recording = false;
+   flush_telemetry();
+
+   std::lock_guard lock(m_record_mutex);
+   if (m_record_file != nullptr) {
+      if (m_records_dropped > 0) {
+         fprintf(m_record_file, "# %u rows dropped, the writer fell behind\n", m_records_dropped.load());
+      }
+
+      fclose(m_record_file);
+      m_record_file = nullptr;
+   }
+}
+
+void audio_device_t::record_block(const int64_t started, const int64_t mixed, const int64_t submitted)
+{
+   const int queued = m_sink.queued_frame_count();
+   const uint32_t underruns = m_sink.underrun_count() - m_underrun_base;
+
+   // note: the block just handed over starts playing once everything queued ahead of it has
+   const int64_t output = submitted + int64_t(std::max(queued - block_frame_count, 0)) * 1000000000 / sample_rate;
+   uint32_t max_latency = 0;
+   for (int index = 0; index < m_block_trigger_count; index++) {
+      const uint32_t latency = uint32_t(std::max<int64_t>(output - m_block_triggers[index], 0) / 1000);
+      m_latency.add(latency);
+      max_latency = std::max(max_latency, latency);
+   }
+
+   m_block_time.add(uint32_t((mixed - started) / 1000));
+   m_blocks.store(m_blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   m_queued_frames.store(queued, std::memory_order_relaxed);
+   m_underruns.store(underruns, std::memory_order_relaxed);
+
+   if (m_recording.load(std::memory_order_relaxed)) {
+      audio_block_record_t record;
+      record.block = m_blocks.load(std::memory_order_relaxed);
+      record.time = started;
+      record.mix_us = uint32_t((mixed - started) / 1000);
+      record.queued_frames = queued;
+      record.underruns = underruns;
+      record.active_voices = m_active_voice_count.load(std::memory_order_relaxed);
+      record.plays = m_block_trigger_count;
+      record.max_latency_us = max_latency;
+      if (!m_block_records.push(record, 0)) {
+         m_records_dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      // note: wake the writer a few times a second rather than every block
+      if (record.block % 16 == 0) {
+         request_streaming();
+      }
+   }
+
+   m_block_trigger_count = 0;
+}
+
+void audio_device_t::flush_telemetry()
+{
+   std::lock_guard lock(m_record_mutex);
+
+   audio_block_record_t record;
+   while (m_block_records.pop(record)) {
+      if (m_record_file == nullptr) {
+         continue;
+      }
+
+      fprintf(m_record_file, "%u,%.3f,%u,%d,%u,%d,%d,%.3f\n",
+              record.block,
+              double(record.time - m_record_start) * 1e-6,
+              record.mix_us,
+              record.queued_frames,
+              record.underruns,
+              record.active_voices,
+              record.plays,
+              double(record.max_latency_us) * 0.001);
+   }
+}
+
+void audio_device_t::set_resampler(const sound_t::resampler_t resampler)
+{
+   send({ audio_command_t::type_t::resampler, indexer_t{ 0 }, 1.0f, int(resampler) });
+}
+
+bool audio_device_t::send(const audio_command_t &command, const uint32_t headroom)
+{
+   if (!m_commands.push(command, headroom)) {
+      m_commands_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+
+   return true;
+}
+
+void audio_device_t::poll_events()
+{
+   {
+      // note: a worker holds the lock only to append, try again next poll rather than wait
+      std::unique_lock lock(m_load_mutex, std::try_to_lock);
+      if (lock.owns_lock()) {
+         m_registering.swap(m_loaded);
+      }
+   }
+
+   for (audio_load_t &load : m_registering) {
+      audio_buffer_t &buffer = m_buffers[load.handle.m_index];
+      if (buffer.handle != load.handle || !buffer.loading) {
+         continue;
+      }
+
+      buffer.loading = false;
+      buffer.failed = true;
+      if (load.channel_count > 0 && load.sample_rate > 0 && !load.samples.empty()) {
+         buffer.channel_count = load.channel_count;
+         buffer.sample_rate = uint32_t(load.sample_rate);
+         buffer.failed = !store(buffer, load.samples);
+      }
+   }
+
+   m_registering.clear();
+
+   bool defragment_pending = false;
+   audio_event_t event;
+   while (m_events.pop(event)) {
+      audio_buffer_t &buffer = m_buffers[event.handle.m_index];
+      if (event.type == audio_event_t::type_t::finished) {
+         if (buffer.handle == event.handle && buffer.playing_count > 0) {
+            buffer.playing_count--;
+         }
+      }
+      else if (event.type == audio_event_t::type_t::released) {
+         if (buffer.arena) {
+            m_arena.release(event.handle.m_index);
+            defragment_pending = true;
+         }
+         else if (buffer.mapping) {
+            m_mapped_sample_count -= uint64_t(buffer.frame_count) * buffer.channel_count;
+         }
+
+         buffer.pcm = nullptr;
+         buffer.arena = false;
+         buffer.mapping = {};
+         m_free_buffers[m_free_buffer_count++] = event.handle.m_index;
+      }
+   }
+
+   if (defragment_pending) {
+      defragment();
+   }
+}
+
+bool audio_device_t::store(audio_buffer_t &buffer, std::span<const short> samples)
+{
+   const uint32_t sample_count = uint32_t(samples.size());
+   const uint16_t owner = buffer.handle.m_index;
+
+   uint32_t offset = m_arena.allocate(owner, sample_count);
+   if (offset == audio_arena_t::npos && m_arena.m_capacity - m_arena.m_used >= sample_count) {
+      defragment();
+      offset = m_arena.allocate(owner, sample_count);
+   }
+
+   if (offset == audio_arena_t::npos) {
+      return false;
+   }
+
+   short *pcm = m_arena.data(offset);
+   memcpy(pcm, samples.data(), samples.size_bytes());
+   buffer.frame_count = sample_count / uint32_t(buffer.channel_count);
+   buffer.pcm = pcm;
+   buffer.arena = true;
+
+   return true;
+}
+
+void audio_device_t::defragment()
+{
+   // note: the mixer only reads samples through a voice, a buffer with nothing playing
+   //       or queued to play can move and the new pointer is published by the next
+   //       play command. destroyed buffers wait for their release event.
+   m_arena.compact(
+      [this](const uint16_t owner) {
+         const audio_buffer_t &buffer = m_buffers[owner];
+         return buffer.allocated && buffer.playing_count == 0;
+      },
+      [this](const uint16_t owner, const uint32_t offset) {
+         m_buffers[owner].pcm = m_arena.data(offset);
+      });
+}
+
+void audio_device_t::process_commands()
+{
+   audio_command_t command;
+   while (m_commands.pop(command)) {
+      const uint16_t index = command.handle.m_index;
+      switch (command.type) {
+         case audio_command_t::type_t::play: {
+            audio_buffer_t &buffer = m_buffers[index];
+            const uint16_t voice_index = acquire_voice(buffer);
+            if (voice_index == audio_voice_list_t::none) {
+               m_voices_dropped.fetch_add(1, std::memory_order_relaxed);
+               post({ audio_event_t::type_t::finished, command.handle });
+               break;
+            }
+
+            audio_voice_t &voice = m_voices[voice_index];
+            voice.active = true;
+            voice.buffer = command.handle;
+            voice.position = 0;
+            voice.step = uint64_t(double(buffer.sample_rate) / sample_rate * command.pitch * double(audio_voice_t::unity_step) + 0.5);
+            voice.volume = command.volume;
+            voice.priority = buffer.priority;
+            link(m_active_voices[voice.priority], &audio_voice_t::age_link, voice_index);
+            link(buffer.instances, &audio_voice_t::instance_link, voice_index);
+            m_voices_played.fetch_add(1, std::memory_order_relaxed);
+            if (m_block_trigger_count < max_block_trigger_count) {
+               m_block_triggers[m_block_trigger_count++] = command.time;
+            }
+         } break;
+
+         case audio_command_t::type_t::stop:
+         case audio_command_t::type_t::release: {
+            audio_buffer_t &buffer = m_buffers[index];
+            while (buffer.instances.head != audio_voice_list_t::none) {
+               release_voice(buffer.instances.head);
+            }
+
+            if (command.type == audio_command_t::type_t::release) {
+               post({ audio_event_t::type_t::released, command.handle });
+            }
+         } break;
+
+         case audio_command_t::type_t::volume: {
+            const audio_buffer_t &buffer = m_buffers[index];
+            for (uint16_t voice_index = buffer.instances.head; voice_index != audio_voice_list_t::none;) {
+               m_voices[voice_index].volume = command.volume;
+               voice_index = m_voices[voice_index].instance_link.next;
+            }
+         } break;
+
+         case audio_command_t::type_t::priority: {
+            // note: voices already playing keep the priority they started with
+            m_buffers[index].priority = uint8_t(command.value);
+         } break;
+
+         case audio_command_t::type_t::max_instances: {
+            m_buffers[index].max_instances = uint16_t(command.value);
+         } break;
+
+         case audio_command_t::type_t::play_stream: {
+            audio_stream_t &stream = m_streams[index];
+            const bool loop = command.value != 0;
+
+            // note: chunks decoded for the old loop mode or a playing stream start over from the top
+            if (stream.playing || stream.looping != loop) {
+               stream.looping = loop;
+               stream.rewind = true;
+               request_streaming();
+            }
+
+            stream.playing = true;
+            stream.volume = command.volume;
+         } break;
+
+         case audio_command_t::type_t::stop_stream: {
+            audio_stream_t &stream = m_streams[index];
+            stream.playing = false;
+            stream.rewind = true;
+            request_streaming();
+         } break;
+
+         case audio_command_t::type_t::stream_volume: {
+            m_streams[index].volume = command.volume;
+         } break;
+
+         case audio_command_t::type_t::release_stream: {
+            // note: the streaming thread closes the decoder, the mixer never touches it again
+            audio_stream_t &stream = m_streams[index];
+            stream.playing = false;
+            stream.bus = 0;
+            stream.closing = true;
+            request_streaming();
+         } break;
+
+         case audio_command_t::type_t::resampler: {
+            m_resampler = sound_t::resampler_t(command.value);
+         } break;
+
+         case audio_command_t::type_t::route: {
+            m_buffers[index].bus = m_buses[command.value].active ? uint8_t(command.value) : 0;
+         } break;
+
+         case audio_command_t::type_t::route_stream: {
+            m_streams[index].bus = m_buses[command.value].active ? uint8_t(command.value) : 0;
+         } break;
+
+         case audio_command_t::type_t::create_bus: {
+            audio_bus_t &node = m_buses[index];
+            node.active = true;
+            node.parent = uint8_t(command.value);
+            node.volume = 1.0f;
+            node.peak = 0.0f;
+            node.filter.configure(sound_bus_t::filter_t::none, 0.0f, 0.0f, float(sample_rate));
+            node.compressor.configure(0.0f, 1.0f, 0.0f, 0.0f, float(sample_rate));
+            node.compressor.key = audio_bus_t::none;
+            node.delay.enabled = false;
+            update_bus_depths();
+         } break;
+
+         case audio_command_t::type_t::release_bus: {
+            // note: everything routed through the bus falls through to its parent
+            audio_bus_t &node = m_buses[index];
+            node.active = false;
+            for (auto &other : m_buses) {
+               other.parent = other.parent == index ? node.parent : other.parent;
+               other.compressor.key = other.compressor.key == index ? audio_bus_t::none : other.compressor.key;
+            }
+
+            for (auto &buffer : m_buffers) {
+               buffer.bus = buffer.bus == index ? node.parent : buffer.bus;
+            }
+
+            for (auto &stream : m_streams) {
+               stream.bus = stream.bus == index ? node.parent : stream.bus;
+            }
+
+            update_bus_depths();
+         } break;
+
+         case audio_command_t::type_t::bus_volume: {
+            m_buses[index].volume = command.volume;
+         } break;
+
+         case audio_command_t::type_t::bus_filter: {
+            m_buses[index].filter.configure(sound_bus_t::filter_t(command.value), command.params[0], command.params[1], float(sample_rate));
+         } break;
+
+         case audio_command_t::type_t::bus_compressor: {
+            audio_compressor_t &compressor = m_buses[index].compressor;
+            compressor.configure(command.params[0], command.params[1], command.params[2], command.params[3], float(sample_rate));
+            compressor.key = uint8_t(command.value);
+         } break;
+
+         case audio_command_t::type_t::reset_telemetry: {
+            m_latency.reset();
+            m_block_time.reset();
+            m_blocks = 0;
+            m_peak_voice_count = 0;
+            m_underrun_base = m_sink.underrun_count();
+            m_underruns = 0;
+            for (auto &stream : m_streams) {
+               stream.underruns = 0;
+            }
+         } break;
+
+         case audio_command_t::type_t::bus_delay: {
+            const int delay_frame_count = int(command.params[0] * 0.001f * float(sample_rate));
+            m_buses[index].delay.configure(std::clamp(delay_frame_count, block_frame_count, max_delay_frame_count),
+                                           command.params[1], command.params[2]);
+         } break;
+      }
+   }
+}
+
+void audio_device_t::post(const audio_event_t &event)
+{
+   // note: sized for every queued command plus every voice, only a game
+   //       thread that never touches audio again can fill it up
+   m_events.push(event);
+}
+
+void audio_device_t::link(audio_voice_list_t &list, audio_voice_link_t audio_voice_t::*link, const uint16_t index)
+{
+   audio_voice_link_t &entry = m_voices[index].*link;
+   entry.prev = list.tail;
+   entry.next = audio_voice_list_t::none;
+
+   if (list.tail != audio_voice_list_t::none) {
+      (m_voices[list.tail].*link).next = index;
+   }
+   else {
+      list.head = index;
+   }
+
+   list.tail = index;
+   list.count++;
+}
+
+void audio_device_t::unlink(audio_voice_list_t &list, audio_voice_link_t audio_voice_t::*link, const uint16_t index)
+{
+   audio_voice_link_t &entry = m_voices[index].*link;
+
+   if (entry.prev != audio_voice_list_t::none) {
+      (m_voices[entry.prev].*link).next = entry.next;
+   }
+   else {
+      list.head = entry.next;
+   }
+
+   if (entry.next != audio_voice_list_t::none) {
+      (m_voices[entry.next].*link).prev = entry.prev;
+   }
+   else {
+      list.tail = entry.prev;
+   }
+
+   entry = {};
+   list.count--;
+}
+
+uint16_t audio_device_t::acquire_voice(audio_buffer_t &buffer)
+{
+   // note: over the cap the sound restarts its own oldest instance
+   if (buffer.max_instances > 0 && buffer.instances.count >= buffer.max_instances) {
+      const uint16_t index = buffer.instances.head;
+      release_voice(index);
+      m_voices_stolen.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   if (m_free_voices.head == audio_voice_list_t::none) {
+      for (int priority = 0; priority <= buffer.priority; priority++) {
+         if (m_active_voices[priority].head == audio_voice_list_t::none) {
+            continue;
+         }
+
+         release_voice(m_active_voices[priority].head);
+         m_voices_stolen.fetch_add(1, std::memory_order_relaxed);
+         break;
+      }
+   }
+
+   const uint16_t index = m_free_voices.head;
+   if (index != audio_voice_list_t::none) {
+      unlink(m_free_voices, &audio_voice_t::age_link, index);
+   }
+
+   return index;
+}
+
+void audio_device_t::release_voice(const uint16_t index)
+{
+   audio_voice_t &voice = m_voices[index];
+
+   unlink(m_active_voices[voice.priority], &audio_voice_t::age_link, index);
+   unlink(m_buffers[voice.buffer.m_index].instances, &audio_voice_t::instance_link, index);
+   link(m_free_voices, &audio_voice_t::age_link, index);
+
+   voice.active = false;
+   post({ audio_event_t::type_t::finished, voice.buffer });
+}
+
+indexer_t audio_device_t::create_stream(stb_vorbis *vorbis, std::vector<uint8_t> &&content)
+{
+   if (vorbis == nullptr) {
+      return indexer_t{ 0 };
+   }
+
+   // note: stream chunks are copied to the bus frame for frame, other rates would play off pitch
+   const stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+   if (info.sample_rate != uint32_t(sample_rate)) {
+      stb_vorbis_close(vorbis);
+      return indexer_t{ 0 };
+   }
+
+   std::lock_guard lock(m_stream_mutex);
+
+   for (auto &stream : m_streams) {
+      if (stream.vorbis != nullptr || stream.closing) {
+         continue;
+      }
+
+      stream.vorbis = vorbis;
+      stream.content = std::move(content);
+      stream.channel_count = std::min(info.channels, 2);
+      stream.looping = true;
+      stream.rewind = false;
+      stream.underruns = 0;
+      stream.read_chunk = 0;
+      stream.read_position = 0;
+      stream.write_chunk = 0;
+      stream.finished = false;
+      for (auto &chunk : stream.chunks) {
+         chunk.samples.resize(size_t(audio_stream_t::chunk_frame_count) * stream.channel_count);
+         chunk.state = audio_stream_t::chunk_state_t::empty;
+      }
+
+      // note: the first chunk is decoded right here so play() has samples for the very next block
+      fill_chunk(stream, stream.chunks[0]);
+      stream.write_chunk = 1;
+      request_streaming();
+
+      return stream.handle;
+   }
+
+   stb_vorbis_close(vorbis);
+
+   return indexer_t{ 0 };
+}
+
+void audio_device_t::destroy_stream(indexer_t handle)
+{
+   audio_stream_t &stream = m_streams[handle.m_index];
+   if (stream.handle != handle) {
+      return;
+   }
+
+   stream.handle.next();
+   send({ audio_command_t::type_t::release_stream, handle }, 0);
+}
+
+void audio_device_t::play_stream(indexer_t handle, float volume, bool loop)
+{
+   if (m_streams[handle.m_index].handle == handle) {
+      send({ audio_command_t::type_t::play_stream, handle, volume, loop ? 1 : 0 });
+   }
+}
+
+void audio_device_t::stop_stream(indexer_t handle)
+{
+   if (m_streams[handle.m_index].handle == handle) {
+      send({ audio_command_t::type_t::stop_stream, handle });
+   }
+}
+
+void audio_device_t::set_stream_volume(indexer_t handle, float volume)
+{
+   if (m_streams[handle.m_index].handle == handle) {
+      send({ audio_command_t::type_t::stream_volume, handle, volume });
+   }
+}
+
+void audio_device_t::set_bus(indexer_t handle, indexer_t bus)
+{
+   if (m_buffers[handle.m_index].handle == handle && bus_valid(bus)) {
+      send({ audio_command_t::type_t::route, handle, 1.0f, bus.m_index });
+   }
+}
+
+void audio_device_t::set_stream_bus(indexer_t handle, indexer_t bus)
+{
+   if (m_streams[handle.m_index].handle == handle && bus_valid(bus)) {
+      send({ audio_command_t::type_t::route_stream, handle, 1.0f, bus.m_index });
+   }
+}
+
+indexer_t audio_device_t::create_bus(indexer_t parent)
+{
+   if (!bus_valid(parent)) {
+      return indexer_t{ 0 };
+   }
+
+   for (auto &node : m_buses) {
+      if (node.allocated) {
+         continue;
+      }
+
+      // note: a delay line is only ever allocated here, before the first command that could enable it
+      if (node.delay.line.empty()) {
+         node.delay.line.resize(size_t(max_delay_frame_count) * channel_count);
+      }
+
+      if (!send({ audio_command_t::type_t::create_bus, node.handle, 1.0f, parent.m_index })) {
+         return indexer_t{ 0 };
+      }
+
+      node.allocated = true;
+      return node.handle;
+   }
+
+   return indexer_t{ 0 };
+}
+
+void audio_device_t::destroy_bus(indexer_t handle)
+{
+   if (handle.m_index == 0 || !bus_valid(handle)) {
+      return;
+   }
+
+   audio_bus_t &node = m_buses[handle.m_index];
+   node.handle.next();
+   node.allocated = false;
+   send({ audio_command_t::type_t::release_bus, handle }, 0);
+}
+
+void audio_device_t::set_bus_volume(indexer_t handle, float volume)
+{
+   if (bus_valid(handle)) {
+      send({ audio_command_t::type_t::bus_volume, handle, volume });
+   }
+}
+
+void audio_device_t::set_bus_filter(indexer_t handle, const sound_bus_t::filter_t filter, const float cutoff, const float q)
+{
+   if (bus_valid(handle)) {
+      send({ audio_command_t::type_t::bus_filter, handle, 1.0f, int(filter), 1.0f, { cutoff, q } });
+   }
+}
+
+void audio_device_t::set_bus_compressor(indexer_t handle, const float threshold_db, const float ratio, const float attack_ms, const float release_ms, indexer_t key)
+{
+   if (!bus_valid(handle)) {
+      return;
+   }
+
+   const int key_index = bus_valid(key) && key.m_index != handle.m_index ? key.m_index : audio_bus_t::none;
+   send({ audio_command_t::type_t::bus_compressor, handle, 1.0f, key_index, 1.0f, { threshold_db, ratio, attack_ms, release_ms } });
+}
+
+void audio_device_t::set_bus_delay(indexer_t handle, const float time_ms, const float feedback, const float mix)
+{
+   if (bus_valid(handle) && !m_buses[handle.m_index].delay.line.empty()) {
+      send({ audio_command_t::type_t::bus_delay, handle, 1.0f, 0, 1.0f, { time_ms, feedback, mix } });
+   }
+}
+
+bool audio_device_t::bus_valid(indexer_t handle) const
+{
+   return handle.m_index < max_bus_count && m_buses[handle.m_index].allocated && m_buses[handle.m_index].handle == handle;
+}
+
+void audio_device_t::service_streams()
+{
+   std::lock_guard stream_lock(m_stream_mutex);
+
+   for (auto &stream : m_streams) {
+      if (stream.vorbis == nullptr) {
+         continue;
+      }
+
+      if (stream.closing) {
+         close_stream(stream);
+         continue;
+      }
+
+      if (stream.rewind) {
+         // note: the mixer only try-locks, at worst it skips this stream for one block
+         std::lock_guard lock(stream.mutex);
+         stb_vorbis_seek_start(stream.vorbis);
+         for (auto &chunk : stream.chunks) {
+            chunk.state = audio_stream_t::chunk_state_t::empty;
+         }
+
+         stream.read_chunk = 0;
+         stream.read_position = 0;
+         stream.write_chunk = 0;
+         stream.finished = false;
+         stream.rewind = false;
+      }
+
+      while (!stream.finished) {
+         audio_stream_t::chunk_t &chunk = stream.chunks[stream.write_chunk];
+         if (chunk.state.load(std::memory_order_acquire) != audio_stream_t::chunk_state_t::empty) {
+            break;
+         }
+
+         fill_chunk(stream, chunk);
+         stream.write_chunk = (stream.write_chunk + 1) % audio_stream_t::chunk_count;
+      }
+   }
+}
+
+void audio_device_t::close_stream(audio_stream_t &stream)
+{
+   if (stream.vorbis == nullptr) {
+      return;
+   }
+
+   stb_vorbis_close(stream.vorbis);
+   stream.vorbis = nullptr;
+   stream.content = {};
+   for (auto &chunk : stream.chunks) {
+      chunk.samples = {};
+      chunk.state = audio_stream_t::chunk_state_t::empty;
+   }
+
+   stream.closing = false;
+}
+
+void audio_device_t::fill_chunk(audio_stream_t &stream, audio_stream_t::chunk_t &chunk)
+{
+   const int channels = stream.channel_count;
+   int frames = 0;
+   bool wrapped = false;
+
+   chunk.last = false;
+   while (frames < audio_stream_t::chunk_frame_count) {
+      short *samples = chunk.samples.data() + size_t(frames) * channels;
+      const int capacity = (audio_stream_t::chunk_frame_count - frames) * channels;
+      const int count = stb_vorbis_get_samples_short_interleaved(stream.vorbis, channels, samples, capacity);
+      if (count > 0) {
+         frames += count;
+         wrapped = false;
+         continue;
+      }
+
+      // note: looping wraps inside the chunk so the seam never reaches the mixer,
+      //       a second empty read straight after a wrap means the track is empty.
+      if (!stream.looping || wrapped) {
+         chunk.last = true;
+         stream.finished = true;
+         break;
+      }
+
+      stb_vorbis_seek_start(stream.vorbis);
+      wrapped = true;
+   }
+
+   chunk.frames = uint32_t(frames);
+   chunk.state.store(audio_stream_t::chunk_state_t::ready, std::memory_order_release);
+}
+
+void audio_device_t::mix_stream(float *bus, const int frame_count, audio_stream_t &stream)
+{
+   std::unique_lock lock(stream.mutex, std::try_to_lock);
+   if (!lock.owns_lock() || stream.rewind) {
+      return;
+   }
+
+   const float gain = stream.volume * (1.0f / 32768.0f);
+   int mixed = 0;
+   while (mixed < frame_count) {
+      audio_stream_t::chunk_t &chunk = stream.chunks[stream.read_chunk];
+      if (chunk.state.load(std::memory_order_acquire) != audio_stream_t::chunk_state_t::ready) {
+         stream.underruns++;
+         request_streaming();
+         break;
+      }
+
+      const int count = int(std::min<uint32_t>(chunk.frames - stream.read_position, uint32_t(frame_count - mixed)));
+      const short *samples = chunk.samples.data() + size_t(stream.read_position) * stream.channel_count;
+      if (stream.channel_count == 2) {
+         audio_kernel_t::accumulate_stereo(bus + size_t(mixed) * channel_count, samples, count, gain);
+      }
+      else {
+         audio_kernel_t::accumulate_mono(bus + size_t(mixed) * channel_count, samples, count, gain);
+      }
+
+      mixed += count;
+      stream.read_position += uint32_t(count);
+      if (stream.read_position < chunk.frames) {
+         continue;
+      }
+
+      const bool last = chunk.last;
+      chunk.state.store(audio_stream_t::chunk_state_t::empty, std::memory_order_release);
+      stream.read_chunk = (stream.read_chunk + 1) % audio_stream_t::chunk_count;
+      stream.read_position = 0;
+
+      if (last) {
+         stream.playing = false;
+         stream.rewind = true;
+         request_streaming();
+         break;
+      }
+
+      request_streaming();
+   }
+}
+
+void audio_device_t::request_streaming()
+{
+   m_stream_requests.fetch_add(1);
+   m_stream_requests.notify_one();
+}
+
+float *audio_device_t::bus_target(const uint8_t index, float *output)
+{
+   audio_bus_t &node = m_buses[index];
+   node.touched = true;
+   return index == 0 ? output : node.samples.data();
+}
+
+void audio_device_t::update_bus_depths()
+{
+   // note: at most max_bus_count levels, one pass per level settles every depth
+   m_max_bus_depth = 0;
+   for (int pass = 0; pass < max_bus_count; pass++) {
+      for (int index = 1; index < max_bus_count; index++) {
+         audio_bus_t &node = m_buses[index];
+         if (node.active) {
+            node.depth = uint8_t(m_buses[node.parent].depth + 1);
+            m_max_bus_depth = std::max(m_max_bus_depth, int(node.depth));
+         }
+      }
+   }
+}
+
+void audio_device_t::mix_buses(float *output, const int frame_count)
+{
+   // note: deepest first, so every bus has all of its children summed in before it runs
+   const int count = frame_count * channel_count;
+   for (int depth = m_max_bus_depth; depth >= 0; depth--) {
+      for (int index = 0; index < max_bus_count; index++) {
+         audio_bus_t &node = m_buses[index];
+         if (!node.active || node.depth != depth) {
+            continue;
+         }
+
+         if (!node.touched && !node.delay.enabled) {
+            node.peak = 0.0f;
+            continue;
+         }
+
+         float *samples = index == 0 ? output : node.samples.data();
+         const uint8_t key = node.compressor.key;
+         const float key_peak = key != audio_bus_t::none ? m_buses[key].peak : -1.0f;
+         node.filter.process(samples, frame_count);
+         node.compressor.process(samples, frame_count, key_peak);
+         node.delay.process(samples, frame_count);
+         node.peak = audio_kernel_t::peak(samples, count) * std::fabs(node.volume);
+
+         if (index != 0) {
+            audio_kernel_t::mix(bus_target(node.parent, output), samples, count, node.volume);
+         }
+         else if (node.volume != 1.0f) {
+            for (int sample = 0; sample < count; sample++) {
+               samples[sample] *= node.volume;
+            }
+         }
+      }
+   }
+}
+
+void audio_device_t::mix(float *bus, const int frame_count)
+{
+   process_commands();
+
+   std::fill(bus, bus + size_t(frame_count) * channel_count, 0.0f);
+   for (auto &node : m_buses) {
+      if (node.active && &node != &m_buses[0]) {
+         std::fill(node.samples.begin(), node.samples.begin() + size_t(frame_count) * channel_count, 0.0f);
+      }
+
+      node.touched = false;
+   }
+
+   for (auto &list : m_active_voices) {
+      for (uint16_t index = list.head; index != audio_voice_list_t::none;) {
+         audio_voice_t &voice = m_voices[index];
+         const uint16_t next = voice.age_link.next;
+
+         const audio_buffer_t &buffer = m_buffers[voice.buffer.m_index];
+         float *target = bus_target(buffer.bus, bus);
+         const float gain = voice.volume * (1.0f / 32768.0f);
+         if (voice.step == audio_voice_t::unity_step) {
+            const uint32_t frame = uint32_t(voice.position >> 32);
+            const int count = int(std::min<uint32_t>(buffer.frame_count - frame, uint32_t(frame_count)));
+            const short *samples = buffer.pcm + size_t(frame) * buffer.channel_count;
+            if (buffer.channel_count == 2) {
+               audio_kernel_t::accumulate_stereo(target, samples, count, gain);
+            }
+            else {
+               audio_kernel_t::accumulate_mono(target, samples, count, gain);
+            }
+
+            voice.position += uint64_t(count) << 32;
+         }
+         else if (m_resampler == sound_t::resampler_t::sinc) {
+            audio_kernel_t::resample_sinc(target, buffer.pcm, buffer.channel_count, buffer.frame_count, voice.position, voice.step, frame_count, gain);
+         }
+         else {
+            audio_kernel_t::resample_linear(target, buffer.pcm, buffer.channel_count, buffer.frame_count, voice.position, voice.step, frame_count, gain);
+         }
+
+         if ((voice.position >> 32) >= buffer.frame_count) {
+            release_voice(index);
+         }
+
+         index = next;
+      }
+   }
+
+   for (auto &stream : m_streams) {
+      if (stream.playing) {
+         mix_stream(bus_target(stream.bus, bus), frame_count, stream);
+      }
+   }
+
+   const int active_voice_count = max_voice_count - m_free_voices.count;
+   m_active_voice_count.store(active_voice_count, std::memory_order_relaxed);
+   if (active_voice_count > m_peak_voice_count.load(std::memory_order_relaxed)) {
+      m_peak_voice_count.store(active_voice_count, std::memory_order_relaxed);
+   }
+
+   mix_buses(bus, frame_count);
+
+   audio_kernel_t::clamp(bus, frame_count * channel_count);
+}
+
+bool sound_t::valid() const
+{
+   return m_id != 0;
+}
+
+bool sound_t::ready() const
+{
+   return valid() && audio_device_t::ptr->ready(indexer_t{ m_id });
+}
+
+bool sound_t::failed() const
+{
+   return valid() && audio_device_t::ptr->failed(indexer_t{ m_id });
+}
+
+// static
+bool sound_t::create_from_files(thread_pool_t &pool, std::span<sound_t> sounds, std::span<const char *const> paths)
+{
+   bool result = true;
+   for (size_t index = 0; index < sounds.size() && index < paths.size(); index++) {
+      indexer_t handle = audio_device_t::ptr->reserve();
+      sounds[index].m_id = handle.id();
+      if (!sounds[index].valid()) {
+         result = false;
+         continue;
+      }
+
+      pool.submit([handle, path = std::string(paths[index])] {
+         int error_code = 0;
+         std::vector<short> samples;
+         int channels = 0;
+         int rate = 0;
+         decode_vorbis(stb_vorbis_open_filename(path.c_str(), &error_code, nullptr), samples, channels, rate);
+         audio_device_t::ptr->complete(handle, std::move(samples), channels, rate);
+      });
+   }
+
+   return result;
+}
+
+bool sound_t::create_from_file(const char *path)
+{
+   int error_code = 0;
+   std::vector<short> samples;
+   int channels = 0;
+   int rate = 0;
+   if (!decode_vorbis(stb_vorbis_open_filename(path, &error_code, nullptr), samples, channels, rate)) {
+      return false;
+   }
+
+   m_id = audio_device_t::ptr->create(samples, channels, rate).id();
+
+   return valid();
+}
+
+bool sound_t::create_from_memory(const std::vector<uint8_t> &content)
+{
+   int error_code = 0;
+   std::vector<short> samples;
+   int channels = 0;
+   int rate = 0;
+   if (!decode_vorbis(stb_vorbis_open_memory(content.data(), int(content.size()), &error_code, nullptr), samples, channels, rate)) {
+      return false;
+   }
+
+   m_id = audio_device_t::ptr->create(samples, channels, rate).id();
+
+   return valid();
+}
+
+void sound_t::destroy()
+{
+   if (valid()) {
+      audio_device_t::ptr->destroy(indexer_t{ m_id });
+   }
+
+   m_id = 0;
+}
+
+// static
+sound_t::stats_t sound_t::stats()
+{
+   return audio_device_t::ptr->stats();
+}
+
+// static
+sound_t::telemetry_t sound_t::telemetry()
+{
+   return audio_device_t::ptr->telemetry();
+}
+
+// static
+void sound_t::reset_telemetry()
+{
+   audio_device_t::ptr->reset_telemetry();
+}
+
+// static
+bool sound_t::start_telemetry_recording(const char *path)
+{
+   return audio_device_t::ptr->start_telemetry_recording(path);
+}
+
+// static
+void sound_t::stop_telemetry_recording()
+{
+   audio_device_t::ptr->stop_telemetry_recording();
+}
+
+// static
+void sound_t::set_resampler(const resampler_t resampler)
+{
+   audio_device_t::ptr->set_resampler(resampler);
+}
+
+void sound_t::set_priority(const priority_t priority)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_priority(indexer_t{ m_id }, priority);
+   }
+}
+
+void sound_t::set_max_instances(const int count)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_max_instances(indexer_t{ m_id }, count);
+   }
+}
+
+void sound_t::play(float volume, float pitch)
+{
+   if (!valid()) {
+      return;
+   }
+
+   audio_device_t::ptr->play(indexer_t{ m_id }, volume, pitch);
+}
+
+void sound_t::set_bus(const sound_bus_t &bus)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_bus(indexer_t{ m_id }, indexer_t{ bus.m_id });
+   }
+}
+
+void sound_t::stop()
+{
+   if (valid()) {
+      audio_device_t::ptr->stop(indexer_t{ m_id });
+   }
+}
+
+void sound_t::set_volume(float volume)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_volume(indexer_t{ m_id }, volume);
+   }
+}
+
+bool sound_t::playing() const
+{
+   return valid() && audio_device_t::ptr->playing(indexer_t{ m_id });
+}
+
+bool sound_stream_t::valid() const
+{
+   return m_id != 0;
+}
+
+bool sound_stream_t::create_from_file(const char *path)
+{
+   // note: stb_vorbis reads the file incrementally, nothing but the decoder state stays resident
+   int error_code = 0;
+   stb_vorbis *vorbis = stb_vorbis_open_filename(path, &error_code, nullptr);
+   m_id = audio_device_t::ptr->create_stream(vorbis, {}).id();
+
+   return valid();
+}
+
+bool sound_stream_t::create_from_memory(std::vector<uint8_t> content)
+{
+   // note: the decoder points into content, moving the vector keeps that storage alive
+   int error_code = 0;
+   stb_vorbis *vorbis = stb_vorbis_open_memory(content.data(), int(content.size()), &error_code, nullptr);
+   m_id = audio_device_t::ptr->create_stream(vorbis, std::move(content)).id();
+
+   return valid();
+}
+
+void sound_stream_t::destroy()
+{
+   if (valid()) {
+      audio_device_t::ptr->destroy_stream(indexer_t{ m_id });
+   }
+
+   m_id = 0;
+}
+
+void sound_stream_t::play(float volume, bool loop)
+{
+   if (!valid()) {
+      return;
+   }
+
+   audio_device_t::ptr->play_stream(indexer_t{ m_id }, volume, loop);
+}
+
+void sound_stream_t::stop()
+{
+   if (!valid()) {
+      return;
+   }
+
+   audio_device_t::ptr->stop_stream(indexer_t{ m_id });
+}
+
+void sound_stream_t::set_volume(float volume)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_stream_volume(indexer_t{ m_id }, volume);
+   }
+}
+
+void sound_stream_t::set_bus(const sound_bus_t &bus)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_stream_bus(indexer_t{ m_id }, indexer_t{ bus.m_id });
+   }
+}
+
+// static
+sound_bus_t sound_bus_t::master()
+{
+   // note: the master bus is never destroyed, its handle is the first one ever handed out
+   indexer_t handle;
+   sound_bus_t result;
+   result.m_id = handle.id();
+
+   return result;
+}
+
+bool sound_bus_t::valid() const
+{
+   return m_id != 0;
+}
+
+bool sound_bus_t::create(const sound_bus_t &parent)
+{
+   m_id = audio_device_t::ptr->create_bus(indexer_t{ parent.m_id }).id();
+
+   return valid();
+}
+
+void sound_bus_t::destroy()
+{
+   if (valid()) {
+      audio_device_t::ptr->destroy_bus(indexer_t{ m_id });
+   }
+
+   m_id = 0;
+}
+
+void sound_bus_t::set_volume(float volume)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_bus_volume(indexer_t{ m_id }, volume);
+   }
+}
+
+void sound_bus_t::set_filter(const filter_t filter, const float cutoff, const float q)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_bus_filter(indexer_t{ m_id }, filter, cutoff, q);
+   }
+}
+
+void sound_bus_t::set_compressor(const float threshold_db, const float ratio, const float attack_ms, const float release_ms, const sound_bus_t *key)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_bus_compressor(indexer_t{ m_id }, threshold_db, ratio, attack_ms, release_ms, indexer_t{ key != nullptr ? key->m_id : 0 });
+   }
+}
+
+void sound_bus_t::set_delay(const float time_ms, const float feedback, const float mix)
+{
+   if (valid()) {
+      audio_device_t::ptr->set_bus_delay(indexer_t{ m_id }, time_ms, feedback, mix);
+   }
+}
+
+bool sound_bank_t::valid() const
+{
+   return m_mapping != nullptr;
+}
+
+bool sound_bank_t::create_from_file(const char *path)
+{
+   destroy();
+
+   auto mapping = std::make_shared<file_mapping_t>();
+   if (!mapping->open(path)) {
+      return false;
+   }
+
+   const std::span<const uint8_t> content = mapping->content();
+   if (content.size() < sizeof(sound_bank_header_t)) {
+      return false;
+   }
+
+   sound_bank_header_t header;
+   memcpy(&header, content.data(), sizeof(header));
+   if (header.magic != sound_bank_header_t::magic_value || header.version != sound_bank_header_t::version_value) {
+      return false;
+   }
+
+   if (content.size() < sizeof(header) + uint64_t(header.entry_count) * sizeof(sound_bank_entry_t)) {
+      return false;
+   }
+
+   const sound_bank_entry_t *entries = (const sound_bank_entry_t *)(content.data() + sizeof(header));
+   for (uint32_t index = 0; index < header.entry_count; index++) {
+      const sound_bank_entry_t &entry = entries[index];
+      const uint64_t expected_size = uint64_t(entry.frame_count) * entry.channel_count * sizeof(short);
+      if (entry.channel_count < 1 || entry.channel_count > 2 ||
+          entry.size != expected_size ||
+          entry.offset % sound_bank_header_t::alignment != 0 ||
+          entry.offset + entry.size > content.size())
+      {
+         continue;
+      }
+
+      // note: no copy, the mixer reads the pcm straight out of the mapped pages
+      const short *pcm = (const short *)(content.data() + entry.offset);
+      sound_t sound;
+      sound.m_id = audio_device_t::ptr->create_view(pcm, entry.frame_count, int(entry.channel_count), int(entry.sample_rate), mapping).id();
+      if (!sound.valid()) {
+         continue;
+      }
+
+      entry_t result;
+      result.name.assign(entry.name, strnlen(entry.name, sizeof(entry.name)));
+      result.sound = sound;
+      m_entries.push_back(std::move(result));
+   }
+
+   m_mapping = std::move(mapping);
+
+   return valid();
+}
+
+void sound_bank_t::destroy()
+{
+   for (auto &entry : m_entries) {
+      entry.sound.destroy();
+   }
+
+   // note: buffers still hold references, the file is unmapped once the mixer has released them all
+   m_entries.clear();
+   m_mapping.reset();
+}
+
+sound_t sound_bank_t::find(const std::string_view &name) const
+{
+   for (const auto &entry : m_entries) {
+      if (entry.name == name) {
+         return entry.sound;
+      }
+   }
+
+   return {};
+}
+
+#undef STB_VORBIS_HEADER_ONLY
+#define STB_VORBIS_NO_PUSHDATA_API
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4245)
+#pragma warning(disable: 4456)
+#pragma warning(disable: 4457)
+#pragma warning(disable: 4701)
+#endif
+#include <stb_vorbis.h>
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
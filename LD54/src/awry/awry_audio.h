@@ -0,0 +1,615 @@
+// awry_audio.h
+
+#pragma once
+
+#include "awry.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+
+struct stb_vorbis;
+
+// note: internal to awry, shared between the portable mixer and the platform sinks
+
+struct indexer_t {
+   indexer_t() = default;
+   indexer_t(uint32_t i) : m_gen(uint16_t(i >> 16)), m_index(uint16_t(i)) {}
+
+   bool operator==(const indexer_t &rhs) const { return m_gen == rhs.m_gen && m_index == rhs.m_index; }
+
+   uint32_t id()   { return (uint32_t(m_gen) << 16 | uint32_t(m_index)); }
+   void     next() { m_gen++; }
+
+   uint16_t m_gen = 1;
+   uint16_t m_index = 0;
+};
+
+// note: intrusive doubly linked list over the voice array, indices instead of pointers
+struct audio_voice_list_t {
+   static constexpr uint16_t none = 0xffff;
+
+   uint16_t head = none;
+   uint16_t tail = none;
+   uint16_t count = 0;
+};
+
+struct audio_voice_link_t {
+   uint16_t prev = audio_voice_list_t::none;
+   uint16_t next = audio_voice_list_t::none;
+};
+
+// note: one fixed allocation that every decoded sound is carved out of, so loading
+//       and unloading sound sets never touches the heap. blocks stay sorted by
+//       offset and are placed first fit, compact() slides the blocks it is allowed
+//       to move down over the gaps unloading leaves behind. game thread only.
+struct audio_arena_t {
+   // note: in samples, keeps every block on its own 64 byte line
+   static constexpr uint32_t alignment = 32;
+   static constexpr uint32_t npos = ~0u;
+
+   struct block_t {
+      uint32_t offset = 0;
+      uint32_t size = 0;
+      uint16_t owner = 0;
+   };
+
+   struct stats_t {
+      uint32_t capacity = 0;
+      uint32_t used = 0;
+      uint32_t largest_free = 0;
+      uint32_t block_count = 0;
+      uint32_t compactions = 0;
+      uint64_t moved = 0;
+   };
+
+   audio_arena_t(const uint32_t capacity, const int max_block_count);
+
+   short *data(const uint32_t offset) { return m_samples.get() + offset; }
+   uint32_t allocate(const uint16_t owner, const uint32_t sample_count);
+   void release(const uint16_t owner);
+   stats_t stats() const;
+
+   // note: movable(owner) says whether a block may move, moved(owner, offset) is
+   //       told where it went. blocks that may not move pin their place.
+   template <typename Movable, typename Moved>
+   void compact(Movable &&movable, Moved &&moved)
+   {
+      m_compactions++;
+
+      uint32_t cursor = 0;
+      for (block_t &block : m_blocks) {
+         if (block.offset > cursor && movable(block.owner)) {
+            memmove(m_samples.get() + cursor, m_samples.get() + block.offset, size_t(block.size) * sizeof(short));
+            block.offset = cursor;
+            moved(block.owner, cursor);
+            m_moved += block.size;
+         }
+
+         cursor = align_up(block.offset + block.size);
+      }
+   }
+
+   static uint32_t align_up(const uint32_t value) { return (value + alignment - 1) & ~(alignment - 1); }
+
+   uint32_t                 m_capacity = 0;
+   uint32_t                 m_used = 0;
+   uint32_t                 m_compactions = 0;
+   uint64_t                 m_moved = 0;
+   std::unique_ptr<short[]> m_samples;
+   std::vector<block_t>     m_blocks;
+};
+
+// note: handle through playing_count belong to the game thread, as do the
+//       samples, which are written before the first command naming the buffer
+//       and only move while no voice plays them. the rest belongs to the mixer.
+struct audio_buffer_t {
+   indexer_t          handle;
+   bool               allocated = false;
+   bool               loading = false;
+   // note: the decode or the arena came up empty, the buffer stays silent and never ready
+   bool               failed = false;
+   int                playing_count = 0;
+   int                channel_count = 0;
+   uint32_t           frame_count = 0;
+   uint32_t           sample_rate = 0;
+   // note: pcm points into either the arena or a mapped sound bank
+   const short       *pcm = nullptr;
+   bool               arena = false;
+   std::shared_ptr<const file_mapping_t> mapping;
+   uint8_t            priority = uint8_t(sound_t::priority_t::normal);
+   uint16_t           max_instances = 0;
+   uint8_t            bus = 0;
+   audio_voice_list_t instances;
+};
+
+// note: two chunks ping-pong between the streaming thread, which decodes
+//       into empty chunks, and the mixer, which plays ready ones. the mutex
+//       only guards rewinds, the mixer try-locks it and never waits.
+struct audio_stream_t {
+   static constexpr int chunk_count = 2;
+   static constexpr int chunk_frame_count = 4096;
+
+   enum class chunk_state_t : uint32_t {
+      empty, ready,
+   };
+
+   struct chunk_t {
+      std::vector<short>         samples;
+      uint32_t                   frames = 0;
+      bool                       last = false;
+      std::atomic<chunk_state_t> state = chunk_state_t::empty;
+   };
+
+   indexer_t            handle;
+   stb_vorbis          *vorbis = nullptr;
+   std::vector<uint8_t> content;
+   int                  channel_count = 0;
+   std::atomic<bool>    looping = false;
+   std::atomic<bool>    rewind = false;
+   std::atomic<uint32_t> underruns = 0;
+   std::mutex           mutex;
+   std::atomic<bool>    closing = false;
+   bool                 playing = false;
+   float                volume = 1.0f;
+   uint8_t              bus = 0;
+   chunk_t              chunks[chunk_count];
+   int                  read_chunk = 0;
+   uint32_t             read_position = 0;
+   int                  write_chunk = 0;
+   bool                 finished = false;
+};
+
+// note: a voice is linked into either the free list or the priority list
+//       matching its sound, oldest first, and into its buffer's instances.
+// note: position and step are source frames in 32.32 fixed point, a step of
+//       exactly one frame takes the direct path and skips the resampler.
+struct audio_voice_t {
+   static constexpr uint64_t unity_step = uint64_t(1) << 32;
+
+   bool               active = false;
+   indexer_t          buffer;
+   uint64_t           position = 0;
+   uint64_t           step = unity_step;
+   float              volume = 1.0f;
+   uint8_t            priority = 0;
+   audio_voice_link_t age_link;
+   audio_voice_link_t instance_link;
+};
+
+// note: receives the mixed float bus one block at a time, write() blocks
+//       for as long as the device needs and so paces the mixer thread.
+struct audio_sink_t {
+   virtual ~audio_sink_t() = default;
+   virtual bool open(const int sample_rate, const int channel_count, const int block_frame_count) = 0;
+   virtual void close() = 0;
+   virtual bool write(const float *samples, const int frame_count) = 0;
+   // note: frames written but not played yet, and how often playback ran dry
+   virtual int queued_frame_count() = 0;
+   virtual uint32_t underrun_count() = 0;
+};
+
+// note: paced, it plays a virtual device that keeps queued_block_count blocks
+//       queued and runs dry like a real one when the mixer falls behind.
+struct audio_null_sink_t final : audio_sink_t {
+   audio_null_sink_t(const bool paced = false, const int queued_block_count = 2);
+
+   bool open(const int sample_rate, const int channel_count, const int block_frame_count);
+   void close();
+   bool write(const float *samples, const int frame_count);
+   int queued_frame_count();
+   uint32_t underrun_count();
+
+   bool                                  m_paced = false;
+   int                                   m_queued_block_count = 0;
+   int                                   m_sample_rate = 0;
+   uint32_t                              m_underruns = 0;
+   std::chrono::steady_clock::time_point m_deadline;
+};
+
+// note: 32-bit float wave file, the header sizes are patched on close
+struct audio_wav_sink_t final : audio_sink_t {
+   audio_wav_sink_t(const char *path, const bool paced = false);
+   ~audio_wav_sink_t();
+
+   bool open(const int sample_rate, const int channel_count, const int block_frame_count);
+   void close();
+   bool write(const float *samples, const int frame_count);
+   int queued_frame_count();
+   uint32_t underrun_count();
+
+   std::string       m_path;
+   FILE             *m_file = nullptr;
+   int               m_channel_count = 0;
+   uint32_t          m_data_size = 0;
+   audio_null_sink_t m_pacer;
+};
+
+#if defined(__linux__) && __has_include(<alsa/asoundlib.h>)
+#define AWRY_AUDIO_ALSA 1
+
+// note: link with -lasound
+struct audio_alsa_sink_t final : audio_sink_t {
+   audio_alsa_sink_t(const char *device = "default");
+   ~audio_alsa_sink_t();
+
+   bool open(const int sample_rate, const int channel_count, const int block_frame_count);
+   void close();
+   bool write(const float *samples, const int frame_count);
+   int queued_frame_count();
+   uint32_t underrun_count();
+
+   std::string m_device;
+   void       *m_pcm = nullptr;
+   uint32_t    m_underruns = 0;
+};
+#endif
+
+// note: bounded single producer single consumer ring, push fails rather than
+//       block when fewer than headroom slots would remain free.
+template <typename T, uint32_t N>
+struct audio_ring_t {
+   static_assert((N & (N - 1)) == 0, "ring capacity must be a power of two");
+
+   bool push(const T &value, const uint32_t headroom = 0)
+   {
+      const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+      if (tail - m_head.load(std::memory_order_acquire) + headroom >= N) {
+         return false;
+      }
+
+      m_items[tail & (N - 1)] = value;
+      m_tail.store(tail + 1, std::memory_order_release);
+
+      return true;
+   }
+
+   bool pop(T &value)
+   {
+      const uint32_t head = m_head.load(std::memory_order_relaxed);
+      if (head == m_tail.load(std::memory_order_acquire)) {
+         return false;
+      }
+
+      value = m_items[head & (N - 1)];
+      m_head.store(head + 1, std::memory_order_release);
+
+      return true;
+   }
+
+   // note: the indices live on separate cache lines so producer and consumer do not false share
+   std::atomic<uint32_t> m_head = 0;
+   uint8_t               m_head_padding[64 - sizeof(std::atomic<uint32_t>)] = {};
+   std::atomic<uint32_t> m_tail = 0;
+   uint8_t               m_tail_padding[64 - sizeof(std::atomic<uint32_t>)] = {};
+   T                     m_items[N];
+};
+
+struct audio_command_t {
+   enum class type_t : uint8_t {
+      play,
+      stop,
+      volume,
+      priority,
+      max_instances,
+      release,
+      play_stream,
+      stop_stream,
+      stream_volume,
+      release_stream,
+      resampler,
+      route,
+      route_stream,
+      create_bus,
+      release_bus,
+      bus_volume,
+      bus_filter,
+      bus_compressor,
+      bus_delay,
+      reset_telemetry,
+   };
+
+   type_t    type = type_t::play;
+   indexer_t handle = {};
+   float     volume = 1.0f;
+   int       value = 0;
+   float     pitch = 1.0f;
+   // note: effect settings, passed as given and turned into coefficients by the mixer
+   float     params[4] = {};
+   // note: steady clock nanoseconds when play() was called, for the latency histogram
+   int64_t   time = 0;
+};
+
+struct audio_load_t {
+   indexer_t          handle;
+   int                channel_count = 0;
+   int                sample_rate = 0;
+   std::vector<short> samples;
+};
+
+struct audio_event_t {
+   enum class type_t : uint8_t {
+      finished,
+      released,
+   };
+
+   type_t    type = type_t::finished;
+   indexer_t handle;
+};
+
+// note: written by the mixer thread only, read whenever, so every field is a
+//       relaxed atomic and a snapshot may straddle a block.
+struct audio_histogram_t {
+   using bucket_t = std::atomic<uint32_t>;
+
+   audio_histogram_t(const uint32_t bucket_width_us);
+
+   void add(const uint32_t value_us);
+   void reset();
+   sound_t::histogram_t snapshot() const;
+
+   uint32_t              bucket_width_us = 1;
+   bucket_t              buckets[sound_t::histogram_t::bucket_count] = {};
+   bucket_t              overflow = 0;
+   bucket_t              count = 0;
+   bucket_t              min_us = ~0u;
+   bucket_t              max_us = 0;
+   std::atomic<uint64_t> sum_us = 0;
+};
+
+// note: one row of a telemetry recording, the mixer queues these for the
+//       streaming thread, which owns the file writes.
+struct audio_block_record_t {
+   uint32_t block = 0;
+   int64_t  time = 0;
+   uint32_t mix_us = 0;
+   int      queued_frames = 0;
+   uint32_t underruns = 0;
+   int      active_voices = 0;
+   int      plays = 0;
+   uint32_t max_latency_us = 0;
+};
+
+struct audio_kernel_t {
+   static constexpr int sinc_tap_count = 8;
+   static constexpr int sinc_phase_count = 256;
+
+   // note: bus += samples * gain, the bus is interleaved stereo
+   static void accumulate_stereo(float *bus, const short *samples, const int frame_count, const float gain);
+   static void accumulate_mono(float *bus, const short *samples, const int frame_count, const float gain);
+   static void clamp(float *bus, const int count);
+
+   // note: bus += samples read at position, advancing by step per output frame. taps
+   //       past either end of the source read as silence. returns the frames written,
+   //       fewer than frame_count once position reaches the end of the source.
+   static int resample_linear(float *bus, const short *samples, const int channel_count, const uint32_t source_frame_count,
+                              uint64_t &position, const uint64_t step, const int frame_count, const float gain);
+   // note: the sinc kernel is sinc_tap_count wide at unity and widens with step, its
+   //       cutoff tracks the lower of the source and output nyquist up to four times unity.
+   static int resample_sinc(float *bus, const short *samples, const int channel_count, const uint32_t source_frame_count,
+                            uint64_t &position, const uint64_t step, const int frame_count, const float gain);
+
+   // note: dst += src * gain and the largest magnitude in src, both over count floats
+   static void mix(float *dst, const float *src, const int count, const float gain);
+   static float peak(const float *src, const int count);
+};
+
+// note: transposed direct form ii on an interleaved stereo bus, left and right
+//       run side by side in the low lanes of one vector so the recursion costs
+//       one pass over the frames.
+struct audio_biquad_t {
+   void configure(const sound_bus_t::filter_t filter, const float cutoff, const float q, const float rate);
+   void process(float *bus, const int frame_count);
+
+   sound_bus_t::filter_t type = sound_bus_t::filter_t::none;
+   float b0 = 1.0f;
+   float b1 = 0.0f;
+   float b2 = 0.0f;
+   float a1 = 0.0f;
+   float a2 = 0.0f;
+   float z1[2] = {};
+   float z2[2] = {};
+};
+
+// note: peak compressor. the gain is worked out once per slice from the slice
+//       peak, or the key's level when ducking, and ramped across the slice.
+struct audio_compressor_t {
+   static constexpr int slice_frame_count = 16;
+
+   void configure(const float threshold_db, const float ratio, const float attack_ms, const float release_ms, const float rate);
+   void process(float *bus, const int frame_count, const float key_peak);
+
+   bool    enabled = false;
+   uint8_t key = 0xff;
+   float   threshold_db = 0.0f;
+   float   slope = 0.0f;
+   float   attack = 0.0f;
+   float   release = 0.0f;
+   float   envelope = 0.0f;
+   float   gain = 1.0f;
+};
+
+// note: feedback echo over a preallocated line. the delay is never shorter than
+//       a block, so a block only reads what earlier blocks wrote.
+struct audio_delay_t {
+   void configure(const int delay_frame_count, const float feedback, const float mix);
+   void process(float *bus, const int frame_count);
+
+   bool               enabled = false;
+   int                frame_count = 0;
+   int                write = 0;
+   float              feedback = 0.0f;
+   float              wet = 0.0f;
+   std::vector<float> line;
+};
+
+// note: allocated and handle belong to the game thread, the rest to the mixer.
+//       bus 0 is the master and mixes straight into the output block.
+struct audio_bus_t {
+   static constexpr uint8_t none = 0xff;
+
+   indexer_t          handle;
+   bool               allocated = false;
+   bool               active = false;
+   bool               touched = false;
+   uint8_t            parent = none;
+   uint8_t            depth = 0;
+   float              volume = 1.0f;
+   float              peak = 0.0f;
+   audio_biquad_t     filter;
+   audio_compressor_t compressor;
+   audio_delay_t      delay;
+   std::vector<float> samples;
+};
+
+struct audio_device_t {
+   static inline audio_device_t *ptr = nullptr;
+
+   static constexpr int max_buffer_count = 256;
+   static constexpr int max_voice_count = 64;
+   static constexpr int max_stream_count = 8;
+   static constexpr int max_bus_count = 8;
+   static constexpr int max_delay_frame_count = 44100;
+   static constexpr int channel_count = 2;
+   static constexpr int sample_rate = 44100;
+   static constexpr int block_frame_count = 512;
+   // note: 8 MB, about 47 seconds of stereo at 44.1 kHz. pages are committed as they are used
+   static constexpr uint32_t arena_sample_count = 4 * 1024 * 1024;
+   static constexpr int priority_count = int(sound_t::priority_t::critical) + 1;
+   static constexpr uint32_t command_capacity = 1024;
+   static constexpr uint32_t event_capacity = 2048;
+   // note: kept free for release commands so destroy() can never be refused
+   static constexpr uint32_t release_headroom = max_buffer_count + max_stream_count + max_bus_count;
+
+   audio_device_t(audio_sink_t &sink);
+   ~audio_device_t();
+
+   bool start();
+   void stop();
+
+   // note: game thread, these only validate the handle and queue a command
+   void play(indexer_t handle, float volume, float pitch);
+   void stop(indexer_t handle);
+   void set_volume(indexer_t handle, float volume);
+   void set_priority(indexer_t handle, const sound_t::priority_t priority);
+   void set_max_instances(indexer_t handle, const int count);
+   bool playing(indexer_t handle);
+   bool ready(indexer_t handle);
+   bool failed(indexer_t handle);
+   // note: copies the samples into the arena, fails once even a compacted arena has no room
+   indexer_t create(std::span<const short> samples, const int channels, const int source_rate);
+   // note: the buffer mixes pcm in place and keeps the mapping alive until it is released
+   indexer_t create_view(const short *pcm, const uint32_t frame_count, const int channels, const int source_rate,
+                         std::shared_ptr<const file_mapping_t> mapping);
+   // note: hands out a silent buffer whose samples arrive later through complete()
+   indexer_t reserve();
+   void destroy(indexer_t handle);
+   sound_t::stats_t stats();
+   sound_t::telemetry_t telemetry();
+   void reset_telemetry();
+   bool start_telemetry_recording(const char *path);
+   void stop_telemetry_recording();
+   void set_resampler(const sound_t::resampler_t resampler);
+
+   indexer_t create_stream(stb_vorbis *vorbis, std::vector<uint8_t> &&content);
+   void destroy_stream(indexer_t handle);
+   void play_stream(indexer_t handle, float volume, bool loop);
+   void stop_stream(indexer_t handle);
+   void set_stream_volume(indexer_t handle, float volume);
+   void set_bus(indexer_t handle, indexer_t bus);
+   void set_stream_bus(indexer_t handle, indexer_t bus);
+
+   indexer_t create_bus(indexer_t parent);
+   void destroy_bus(indexer_t handle);
+   void set_bus_volume(indexer_t handle, float volume);
+   void set_bus_filter(indexer_t handle, const sound_bus_t::filter_t filter, const float cutoff, const float q);
+   void set_bus_compressor(indexer_t handle, const float threshold_db, const float ratio, const float attack_ms, const float release_ms, indexer_t key);
+   void set_bus_delay(indexer_t handle, const float time_ms, const float feedback, const float mix);
+   bool bus_valid(indexer_t handle) const;
+
+   // note: any thread, the game thread picks the samples up on its next poll
+   void complete(indexer_t handle, std::vector<short> &&samples, const int channels, const int source_rate);
+
+   bool send(const audio_command_t &command, const uint32_t headroom = release_headroom);
+   bool store(audio_buffer_t &buffer, std::span<const short> samples);
+   void defragment();
+   // note: registers finished decodes and drains voice-finished and
+   //       buffer-released events, runs on the game thread
+   void poll_events();
+
+   // note: mixer thread
+   void process_commands();
+   void post(const audio_event_t &event);
+   void link(audio_voice_list_t &list, audio_voice_link_t audio_voice_t::*link, const uint16_t index);
+   void unlink(audio_voice_list_t &list, audio_voice_link_t audio_voice_t::*link, const uint16_t index);
+   uint16_t acquire_voice(audio_buffer_t &buffer);
+   void release_voice(const uint16_t index);
+
+   // note: one pass of the streaming thread, decodes into every empty chunk
+   void service_streams();
+   // note: mixer thread after each block is handed to the sink, streaming thread for the file
+   void record_block(const int64_t started, const int64_t mixed, const int64_t submitted);
+   void flush_telemetry();
+   void close_stream(audio_stream_t &stream);
+   void fill_chunk(audio_stream_t &stream, audio_stream_t::chunk_t &chunk);
+   void mix_stream(float *bus, const int frame_count, audio_stream_t &stream);
+   // note: mixer thread, where a bus's sources accumulate this block
+   float *bus_target(const uint8_t index, float *output);
+   void update_bus_depths();
+   void mix_buses(float *output, const int frame_count);
+   void request_streaming();
+
+   // note: drains the command ring, then mixes every active voice into the bus and clamps it
+   void mix(float *bus, const int frame_count);
+
+   audio_sink_t      &m_sink;
+   std::thread        m_thread;
+   std::thread        m_streamer;
+   std::atomic<bool>  m_running = false;
+   std::mutex         m_stream_mutex;
+   std::mutex         m_load_mutex;
+   std::vector<audio_load_t> m_loaded;
+   std::vector<audio_load_t> m_registering;
+   std::atomic<uint32_t> m_stream_requests = 0;
+   std::vector<float> m_bus;
+   audio_arena_t      m_arena;
+   uint64_t           m_mapped_sample_count = 0;
+   audio_buffer_t     m_buffers[max_buffer_count];
+   uint16_t           m_free_buffers[max_buffer_count];
+   int                m_free_buffer_count = 0;
+   audio_voice_t      m_voices[max_voice_count];
+   audio_voice_list_t m_free_voices;
+   audio_voice_list_t m_active_voices[priority_count];
+   sound_t::resampler_t m_resampler = sound_t::resampler_t::linear;
+   audio_stream_t     m_streams[max_stream_count];
+   audio_bus_t        m_buses[max_bus_count];
+   int                m_max_bus_depth = 0;
+   audio_ring_t<audio_command_t, command_capacity> m_commands;
+   audio_ring_t<audio_event_t, event_capacity>     m_events;
+   std::atomic<int>      m_active_voice_count = 0;
+   std::atomic<uint32_t> m_voices_played = 0;
+   std::atomic<uint32_t> m_voices_stolen = 0;
+   std::atomic<uint32_t> m_voices_dropped = 0;
+   std::atomic<uint32_t> m_commands_dropped = 0;
+
+   static constexpr int max_block_trigger_count = 64;
+   static constexpr uint32_t block_record_capacity = 4096;
+   int64_t               m_block_triggers[max_block_trigger_count] = {};
+   int                   m_block_trigger_count = 0;
+   audio_histogram_t     m_latency{ 1000 };
+   audio_histogram_t     m_block_time{ 25 };
+   std::atomic<uint32_t> m_blocks = 0;
+   std::atomic<int>      m_queued_frames = 0;
+   std::atomic<int>      m_peak_voice_count = 0;
+   std::atomic<uint32_t> m_underruns = 0;
+   uint32_t              m_underrun_base = 0;
+   std::atomic<bool>     m_recording = false;
+   std::mutex            m_record_mutex;
+   FILE                 *m_record_file = nullptr;
+   int64_t               m_record_start = 0;
+   audio_ring_t<audio_block_record_t, block_record_capacity> m_block_records;
+   std::atomic<uint32_t> m_records_dropped = 0;
+};
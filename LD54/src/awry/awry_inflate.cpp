@@ -0,0 +1,665 @@
+// awry_inflate.cpp
+
+#include "awry_inflate.h"
+#include <cstring>
+#include <memory>
+#include <algorithm>
+
+namespace
+{
+   // note: a table entry keeps the bits it consumes in the low byte, then its
+   //       kind, an extra bit count and a 16-bit value: the literal byte(s), a
+   //       length or distance base, or the offset of a subtable. a pair keeps
+   //       the length of its first code where the extra bit count would be.
+   enum entry_kind_t : uint32_t {
+      kind_literal,
+      kind_literal_pair,
+      kind_length,
+      kind_end,
+      kind_distance,
+      kind_subtable,
+      kind_invalid,
+   };
+
+   constexpr uint32_t make_entry(const uint32_t kind, const uint32_t bits, const uint32_t extra, const uint32_t value)
+   {
+      return value << 16 | extra << 12 | kind << 8 | bits;
+   }
+
+   constexpr uint32_t entry_bits(const uint32_t entry) { return entry & 0xff; }
+   constexpr uint32_t entry_kind(const uint32_t entry) { return (entry >> 8) & 0xf; }
+   constexpr uint32_t entry_extra(const uint32_t entry) { return (entry >> 12) & 0xf; }
+   constexpr uint32_t entry_value(const uint32_t entry) { return entry >> 16; }
+   constexpr uint64_t low_bits(const uint32_t count) { return (uint64_t(1) << count) - 1; }
+
+   constexpr uint16_t length_base[29] = {
+      3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+   };
+
+   constexpr uint8_t length_extra[29] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+   };
+
+   constexpr uint16_t distance_base[30] = {
+      1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+      257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+   };
+
+   constexpr uint8_t distance_extra[30] = {
+      0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+      7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+   };
+
+   constexpr uint8_t code_length_order[19] = {
+      16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+   };
+
+   // note: what each symbol decodes to, build_table() only adds the code length
+   struct symbol_templates_t {
+      symbol_templates_t()
+      {
+         for (uint32_t symbol = 0; symbol < 288; symbol++) {
+            if (symbol < 256) {
+               litlen[symbol] = make_entry(kind_literal, 0, 0, symbol);
+            }
+            else if (symbol == 256) {
+               litlen[symbol] = make_entry(kind_end, 0, 0, 0);
+            }
+            else if (symbol < 286) {
+               litlen[symbol] = make_entry(kind_length, 0, length_extra[symbol - 257], length_base[symbol - 257]);
+            }
+            else {
+               litlen[symbol] = make_entry(kind_invalid, 0, 0, 0);
+            }
+         }
+
+         for (uint32_t symbol = 0; symbol < 32; symbol++) {
+            distance[symbol] = symbol < 30 ? make_entry(kind_distance, 0, distance_extra[symbol], distance_base[symbol]) : make_entry(kind_invalid, 0, 0, 0);
+         }
+
+         for (uint32_t symbol = 0; symbol < 19; symbol++) {
+            code_length[symbol] = make_entry(kind_literal, 0, 0, symbol);
+         }
+      }
+
+      uint32_t litlen[288] = {};
+      uint32_t distance[32] = {};
+      uint32_t code_length[19] = {};
+   };
+
+   const symbol_templates_t &symbol_templates()
+   {
+      static const symbol_templates_t templates;
+      return templates;
+   }
+
+   uint32_t reverse_bits(uint32_t code, const int length)
+   {
+      uint32_t result = 0;
+      for (int index = 0; index < length; index++) {
+         result = result << 1 | (code & 1);
+         code >>= 1;
+      }
+
+      return result;
+   }
+
+   // note: canonical codes indexed by their first primary_bits bits, codes longer
+   //       than that continue in a subtable sized for the longest one. slots no
+   //       code reaches stay invalid, which is how an incomplete code fails.
+   bool build_table(const uint8_t *lengths,
+                    const int count,
+                    const uint32_t *symbols,
+                    uint32_t *table,
+                    const int primary_bits,
+                    const int capacity)
+   {
+      int counts[16] = {};
+      for (int symbol = 0; symbol < count; symbol++) {
+         counts[lengths[symbol]]++;
+      }
+
+      counts[0] = 0;
+      int left = 1;
+      int max_length = 0;
+      for (int length = 1; length <= 15; length++) {
+         left = (left << 1) - counts[length];
+         if (left < 0) {
+            return false;
+         }
+
+         if (counts[length] > 0) {
+            max_length = length;
+         }
+      }
+
+      uint32_t next_code[16] = {};
+      uint32_t code = 0;
+      for (int length = 1; length <= 15; length++) {
+         code = (code + uint32_t(counts[length - 1])) << 1;
+         next_code[length] = code;
+      }
+
+      const uint32_t invalid = make_entry(kind_invalid, 1, 0, 0);
+      const int primary_size = 1 << primary_bits;
+      const int sub_bits = std::max(max_length - primary_bits, 0);
+      std::fill(table, table + primary_size, invalid);
+
+      int next_subtable = primary_size;
+      for (int symbol = 0; symbol < count; symbol++) {
+         const int length = lengths[symbol];
+         if (length == 0) {
+            continue;
+         }
+
+         const uint32_t reversed = reverse_bits(next_code[length]++, length);
+         if (length <= primary_bits) {
+            for (uint32_t index = reversed; index < uint32_t(primary_size); index += 1u << length) {
+               table[index] = symbols[symbol] | uint32_t(length);
+            }
+
+            continue;
+         }
+
+         uint32_t &link = table[reversed & uint32_t(primary_size - 1)];
+         if (entry_kind(link) != kind_subtable) {
+            if (next_subtable + (1 << sub_bits) > capacity) {
+               return false;
+            }
+
+            link = make_entry(kind_subtable, uint32_t(primary_bits), uint32_t(sub_bits), uint32_t(next_subtable));
+            std::fill(table + next_subtable, table + next_subtable + (1 << sub_bits), invalid);
+            next_subtable += 1 << sub_bits;
+         }
+
+         uint32_t *subtable = table + entry_value(link);
+         const int sub_length = length - primary_bits;
+         for (uint32_t index = reversed >> primary_bits; index < (1u << sub_bits); index += 1u << sub_length) {
+            subtable[index] = symbols[symbol] | uint32_t(sub_length);
+         }
+      }
+
+      return true;
+   }
+
+   // note: where one short literal code is followed by another that still fits
+   //       in the primary bits, one lookup emits both. descending, so the entry
+   //       read for the second literal has not been paired yet.
+   void pair_literals(uint32_t *table)
+   {
+      for (int index = (1 << inflate_t::litlen_bits) - 1; index >= 0; index--) {
+         const uint32_t first = table[index];
+         const uint32_t first_bits = entry_bits(first);
+         if (entry_kind(first) != kind_literal || first_bits >= uint32_t(inflate_t::litlen_bits)) {
+            continue;
+         }
+
+         const uint32_t second = table[index >> first_bits];
+         if (entry_kind(second) != kind_literal || entry_bits(second) > inflate_t::litlen_bits - first_bits) {
+            continue;
+         }
+
+         table[index] = make_entry(kind_literal_pair,
+                                   first_bits + entry_bits(second),
+                                   first_bits,
+                                   entry_value(first) | entry_value(second) << 8);
+      }
+   }
+
+   inline uint64_t load_word(const uint8_t *source)
+   {
+      uint64_t result;
+      memcpy(&result, source, sizeof(result));
+      return result;
+   }
+} // !anon
+
+// static
+bool inflate_t::decompress(std::span<const uint8_t> input, std::span<uint8_t> output, size_t &written)
+{
+   // note: default initialized, make_unique would clear the tables first
+   std::unique_ptr<inflate_t> inflater(new inflate_t);
+   const uint8_t *in = input.data();
+   uint8_t *out = output.data();
+   const status_t status = inflater->inflate(in, in + input.size(), true, output.data(), out, out + output.size());
+   written = size_t(out - output.data());
+
+   return status == status_t::done;
+}
+
+void inflate_t::reset()
+{
+   m_bits = 0;
+   m_bit_count = 0;
+   m_padding = 0;
+   m_state = state_t::header;
+   m_final = false;
+   m_fixed = false;
+   m_stored_remaining = 0;
+   m_match_length = 0;
+   m_match_distance = 0;
+}
+
+inflate_t::status_t inflate_t::inflate(const uint8_t *&input,
+                                       const uint8_t *input_end,
+                                       const bool input_final,
+                                       const uint8_t *window,
+                                       uint8_t *&output,
+                                       uint8_t *output_end)
+{
+   // note: room for three literal pairs, a longest match and the overshoot of its word copy
+   constexpr ptrdiff_t fast_output_margin = 6 + 258 + 8;
+   // note: a multiple of each short distance that is at least a word
+   constexpr uint8_t pattern_step[8] = { 0, 0, 8, 9, 8, 10, 12, 14 };
+
+   // note: locals rather than members, writes through the output pointer may alias
+   //       anything and would otherwise force the bit buffer back to memory.
+   uint64_t bits = m_bits;
+   int count = m_bit_count;
+   int padding = m_padding;
+   const uint8_t *in = input;
+   uint8_t *out = output;
+   status_t status = status_t::error;
+
+   // note: bits above count may already hold the next bytes from a word refill,
+   //       or'ing the same bytes in again leaves them as they are. past the end
+   //       of a final input zeros stand in, consuming one of those is an error.
+   const auto ensure = [&](const int wanted) {
+      while (count < wanted) {
+         if (in < input_end) {
+            bits |= uint64_t(*in++) << count;
+         }
+         else if (input_final) {
+            padding++;
+         }
+         else {
+            return false;
+         }
+
+         count += 8;
+      }
+
+      return true;
+   };
+
+   const auto consume = [&](const uint32_t bit_count) {
+      bits >>= bit_count;
+      count -= int(bit_count);
+   };
+
+   for (;;) {
+      if (m_state == state_t::done) {
+         status = status_t::done;
+         break;
+      }
+
+      if (m_state == state_t::header) {
+         if (!input_final && input_end - in < max_header_size) {
+            status = status_t::need_input;
+            break;
+         }
+
+         ensure(3);
+         m_final = (bits & 1) != 0;
+         const uint32_t type = uint32_t(bits >> 1) & 3;
+         consume(3);
+
+         if (type == 0) {
+            consume(uint32_t(count & 7));
+            ensure(32);
+            const uint32_t length = uint32_t(bits) & 0xffff;
+            const uint32_t complement = uint32_t(bits >> 16) & 0xffff;
+            consume(32);
+            if (length != (~complement & 0xffff)) {
+               break;
+            }
+
+            m_stored_remaining = length;
+            m_state = state_t::stored;
+         }
+         else if (type == 1) {
+            if (!m_fixed) {
+               uint8_t lengths[288 + 32];
+               std::fill(lengths, lengths + 144, uint8_t(8));
+               std::fill(lengths + 144, lengths + 256, uint8_t(9));
+               std::fill(lengths + 256, lengths + 280, uint8_t(7));
+               std::fill(lengths + 280, lengths + 288, uint8_t(8));
+               std::fill(lengths + 288, lengths + 320, uint8_t(5));
+               build_table(lengths, 288, symbol_templates().litlen, m_litlen, litlen_bits, litlen_table_size);
+               build_table(lengths + 288, 32, symbol_templates().distance, m_distance, distance_bits, distance_table_size);
+               pair_literals(m_litlen);
+               m_fixed = true;
+            }
+
+            m_state = state_t::huffman;
+         }
+         else if (type == 2) {
+            ensure(14);
+            const int litlen_count = int(bits & 31) + 257;
+            const int distance_count = int(bits >> 5 & 31) + 1;
+            const int code_length_count = int(bits >> 10 & 15) + 4;
+            consume(14);
+            if (litlen_count > 286 || distance_count > 30) {
+               break;
+            }
+
+            uint8_t code_lengths[19] = {};
+            for (int index = 0; index < code_length_count; index++) {
+               ensure(3);
+               code_lengths[code_length_order[index]] = uint8_t(bits & 7);
+               consume(3);
+            }
+
+            uint32_t code_table[1 << 7];
+            if (!build_table(code_lengths, 19, symbol_templates().code_length, code_table, 7, 1 << 7)) {
+               break;
+            }
+
+            uint8_t lengths[288 + 32] = {};
+            const int total = litlen_count + distance_count;
+            int index = 0;
+            while (index < total) {
+               ensure(14);
+               const uint32_t entry = code_table[bits & 127];
+               if (entry_kind(entry) != kind_literal) {
+                  break;
+               }
+
+               consume(entry_bits(entry));
+               const uint32_t symbol = entry_value(entry);
+               if (symbol < 16) {
+                  lengths[index++] = uint8_t(symbol);
+                  continue;
+               }
+
+               uint8_t value = 0;
+               int repeat = 0;
+               if (symbol == 16) {
+                  if (index == 0) {
+                     break;
+                  }
+
+                  value = lengths[index - 1];
+                  repeat = 3 + int(bits & 3);
+                  consume(2);
+               }
+               else if (symbol == 17) {
+                  repeat = 3 + int(bits & 7);
+                  consume(3);
+               }
+               else {
+                  repeat = 11 + int(bits & 127);
+                  consume(7);
+               }
+
+               if (index + repeat > total) {
+                  break;
+               }
+
+               std::fill(lengths + index, lengths + index + repeat, value);
+               index += repeat;
+            }
+
+            if (index != total || lengths[256] == 0) {
+               break;
+            }
+
+            if (!build_table(lengths, litlen_count, symbol_templates().litlen, m_litlen, litlen_bits, litlen_table_size) ||
+                !build_table(lengths + litlen_count, distance_count, symbol_templates().distance, m_distance, distance_bits, distance_table_size)) {
+               break;
+            }
+
+            pair_literals(m_litlen);
+            m_fixed = false;
+            m_state = state_t::huffman;
+         }
+         else {
+            break;
+         }
+
+         continue;
+      }
+
+      if (m_state == state_t::stored) {
+         // note: the length fields left the bit buffer byte aligned, drain it before copying input
+         while (m_stored_remaining > 0 && out < output_end && count >= 8) {
+            *out++ = uint8_t(bits);
+            consume(8);
+            m_stored_remaining--;
+         }
+
+         if (m_stored_remaining > 0 && out < output_end) {
+            if (in == input_end) {
+               status = input_final ? status_t::error : status_t::need_input;
+               break;
+            }
+
+            // note: the copy skips past bytes a word refill may have left above count
+            bits = 0;
+            const size_t size = std::min({ size_t(m_stored_remaining), size_t(output_end - out), size_t(input_end - in) });
+            memcpy(out, in, size);
+            out += size;
+            in += size;
+            m_stored_remaining -= uint32_t(size);
+         }
+
+         if (m_stored_remaining > 0) {
+            if (out == output_end) {
+               status = status_t::need_output;
+               break;
+            }
+
+            continue;
+         }
+
+         m_state = m_final ? state_t::done : state_t::header;
+         continue;
+      }
+
+      // note: a match the previous call had no room left for
+      if (m_match_length > 0) {
+         const uint32_t size = std::min(m_match_length, uint32_t(output_end - out));
+         const uint8_t *source = out - m_match_distance;
+         for (uint32_t index = 0; index < size; index++) {
+            out[index] = source[index];
+         }
+
+         out += size;
+         m_match_length -= size;
+         if (m_match_length > 0) {
+            status = status_t::need_output;
+            break;
+         }
+      }
+
+      const uint32_t *litlen = m_litlen;
+      const uint32_t *distances = m_distance;
+      bool block_end = false;
+      bool failed = false;
+
+      // note: a refill leaves at least 56 bits, three primary literals take at
+      //       most 33 and a length and distance pair 48, so the loop refills at
+      //       most twice and checks neither buffer inside. the margins cover both.
+      while (input_end - in >= 16 && output_end - out >= fast_output_margin) {
+         bits |= load_word(in) << count;
+         in += (63 - count) >> 3;
+         count |= 56;
+
+         // note: both bytes are stored either way, a single literal advances by one
+         uint32_t entry = litlen[bits & low_bits(litlen_bits)];
+         for (int index = 0; index < 3 && entry_kind(entry) <= kind_literal_pair; index++) {
+            out[0] = uint8_t(entry_value(entry));
+            out[1] = uint8_t(entry_value(entry) >> 8);
+            out += 1 + entry_kind(entry);
+            consume(entry_bits(entry));
+            entry = litlen[bits & low_bits(litlen_bits)];
+         }
+
+         if (entry_kind(entry) <= kind_literal_pair) {
+            continue;
+         }
+
+         bits |= load_word(in) << count;
+         in += (63 - count) >> 3;
+         count |= 56;
+
+         if (entry_kind(entry) == kind_subtable) {
+            consume(litlen_bits);
+            entry = litlen[entry_value(entry) + (bits & low_bits(entry_extra(entry)))];
+         }
+
+         const uint32_t kind = entry_kind(entry);
+         if (kind == kind_literal) {
+            *out++ = uint8_t(entry_value(entry));
+            consume(entry_bits(entry));
+            continue;
+         }
+
+         if (kind != kind_length) {
+            consume(entry_bits(entry));
+            block_end = kind == kind_end;
+            failed = !block_end;
+            break;
+         }
+
+         const uint32_t length = entry_value(entry) + uint32_t((bits >> entry_bits(entry)) & low_bits(entry_extra(entry)));
+         consume(entry_bits(entry) + entry_extra(entry));
+
+         entry = distances[bits & low_bits(distance_bits)];
+         if (entry_kind(entry) == kind_subtable) {
+            consume(distance_bits);
+            entry = distances[entry_value(entry) + (bits & low_bits(entry_extra(entry)))];
+         }
+
+         if (entry_kind(entry) != kind_distance) {
+            failed = true;
+            break;
+         }
+
+         const uint32_t distance = entry_value(entry) + uint32_t((bits >> entry_bits(entry)) & low_bits(entry_extra(entry)));
+         consume(entry_bits(entry) + entry_extra(entry));
+         if (distance > uint32_t(out - window)) {
+            failed = true;
+            break;
+         }
+
+         // note: whole words when the source is a word or more behind, each word
+         //       then reads only bytes already written. the tail may overshoot.
+         uint8_t *destination = out;
+         const uint8_t *source = out - distance;
+         out += length;
+         if (distance >= 8) {
+            do {
+               memcpy(destination, source, 8);
+               destination += 8;
+               source += 8;
+            } while (destination < out);
+         }
+         else if (distance == 1) {
+            memset(destination, *source, length);
+         }
+         else {
+            // note: the bytes repeat every distance, once a step's worth is written
+            //       the rest copies a word at a time from a step behind
+            const uint32_t step = pattern_step[distance];
+            const uint8_t *pattern_end = destination + step;
+            do {
+               *destination++ = *source++;
+            } while (destination < out && destination < pattern_end);
+
+            source = destination - step;
+            while (destination < out) {
+               memcpy(destination, source, 8);
+               destination += 8;
+               source += 8;
+            }
+         }
+      }
+
+      if (failed) {
+         break;
+      }
+
+      if (block_end) {
+         m_state = m_final ? state_t::done : state_t::header;
+         continue;
+      }
+
+      // note: near the end of either buffer, one symbol at a time and nothing
+      //       consumed unless it can be completed or kept as a pending match.
+      if (!ensure(48)) {
+         status = status_t::need_input;
+         break;
+      }
+
+      uint32_t entry = litlen[bits & low_bits(litlen_bits)];
+      uint32_t used = 0;
+      if (entry_kind(entry) == kind_subtable) {
+         used = litlen_bits;
+         entry = litlen[entry_value(entry) + ((bits >> used) & low_bits(entry_extra(entry)))];
+      }
+
+      const uint32_t kind = entry_kind(entry);
+      if ((kind == kind_literal || kind == kind_literal_pair) && out == output_end) {
+         status = status_t::need_output;
+         break;
+      }
+
+      if (kind == kind_literal_pair) {
+         *out++ = uint8_t(entry_value(entry));
+         consume(entry_extra(entry));
+      }
+      else if (kind == kind_literal) {
+         *out++ = uint8_t(entry_value(entry));
+         consume(used + entry_bits(entry));
+      }
+      else if (kind == kind_end) {
+         consume(used + entry_bits(entry));
+         m_state = m_final ? state_t::done : state_t::header;
+      }
+      else if (kind == kind_length) {
+         used += entry_bits(entry);
+         const uint32_t length = entry_value(entry) + uint32_t((bits >> used) & low_bits(entry_extra(entry)));
+         used += entry_extra(entry);
+
+         entry = distances[(bits >> used) & low_bits(distance_bits)];
+         if (entry_kind(entry) == kind_subtable) {
+            used += distance_bits;
+            entry = distances[entry_value(entry) + ((bits >> used) & low_bits(entry_extra(entry)))];
+         }
+
+         if (entry_kind(entry) != kind_distance) {
+            break;
+         }
+
+         used += entry_bits(entry);
+         const uint32_t distance = entry_value(entry) + uint32_t((bits >> used) & low_bits(entry_extra(entry)));
+         used += entry_extra(entry);
+         if (distance > uint32_t(out - window)) {
+            break;
+         }
+
+         consume(used);
+         m_match_length = length;
+         m_match_distance = distance;
+      }
+      else {
+         break;
+      }
+   }
+
+   // note: decoding bits that were only padding means the input was cut short
+   if (padding * 8 > count) {
+      status = status_t::error;
+   }
+
+   m_bits = bits;
+   m_bit_count = count;
+   m_padding = padding;
+   input = in;
+   output = out;
+
+   return status;
+}
@@ -0,0 +1,59 @@
+// awry_inflate.h
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+// note: raw deflate (rfc 1951) decoder. output goes into one flat buffer that
+//       also holds the history, a match is a forward copy within it. the bit
+//       buffer is 64 bits wide and refilled a word at a time, and the
+//       literal/length table resolves two short literals with one lookup.
+struct inflate_t {
+   enum class status_t {
+      need_input, need_output, done, error,
+   };
+
+   static constexpr int litlen_bits = 11;
+   static constexpr int distance_bits = 8;
+   static constexpr int litlen_table_size = (1 << litlen_bits) + 288 * (1 << (15 - litlen_bits));
+   static constexpr int distance_table_size = (1 << distance_bits) + 30 * (1 << (15 - distance_bits));
+   // note: every block header fits, a caller streaming input keeps at least this much buffered
+   static constexpr int max_header_size = 512;
+   static constexpr uint32_t max_distance = 32768;
+
+   // note: the whole stream in one call, true when it ended exactly within output
+   static bool decompress(std::span<const uint8_t> input, std::span<uint8_t> output, size_t &written);
+
+   void reset();
+
+   // note: decodes from input into output until it runs out of either or the stream
+   //       ends, both pointers are advanced past what was used. window is where
+   //       history starts, at least max_distance bytes before output once there
+   //       is that much. without input_final, input is only consumed while enough
+   //       remains to decode a whole symbol or header.
+   status_t inflate(const uint8_t *&input,
+                    const uint8_t *input_end,
+                    const bool input_final,
+                    const uint8_t *window,
+                    uint8_t *&output,
+                    uint8_t *output_end);
+
+   enum class state_t : uint8_t {
+      header, stored, huffman, done,
+   };
+
+   uint64_t m_bits = 0;
+   int      m_bit_count = 0;
+   int      m_padding = 0;
+   state_t  m_state = state_t::header;
+   bool     m_final = false;
+   bool     m_fixed = false;
+   uint32_t m_stored_remaining = 0;
+   uint32_t m_match_length = 0;
+   uint32_t m_match_distance = 0;
+   // note: left uninitialized, every block builds its tables before decoding
+   uint32_t m_litlen[litlen_table_size];
+   uint32_t m_distance[distance_table_size];
+};
@@ -0,0 +1,106 @@
+// awry_posix.cpp
+
+#include "awry.h"
+#include <chrono>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// note: the platform pieces the portable modules need outside windows, there is
+//       no window or graphics backend here. headless builds, tests and benchmarks.
+
+timespan_t timespan_t::time_since_start()
+{
+   static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   const auto elapsed = std::chrono::steady_clock::now() - start;
+
+   return timespan_t{ std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() };
+}
+
+file_mapping_t::~file_mapping_t()
+{
+   close();
+}
+
+bool file_mapping_t::valid() const
+{
+   return m_data != nullptr;
+}
+
+bool file_mapping_t::open(const std::string_view &path)
+{
+   close();
+
+   // note: the descriptor can be closed right away, the mapping keeps the file referenced
+   const std::string filename(path);
+   const int file = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+   if (file < 0) {
+      return false;
+   }
+
+   struct stat status = {};
+   if (fstat(file, &status) != 0 || status.st_size == 0) {
+      ::close(file);
+      return false;
+   }
+
+   void *data = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+   ::close(file);
+   if (data == MAP_FAILED) {
+      return false;
+   }
+
+   m_data = (const uint8_t *)data;
+   m_size = size_t(status.st_size);
+
+   return valid();
+}
+
+void file_mapping_t::close()
+{
+   if (m_data != nullptr) {
+      munmap((void *)m_data, m_size);
+   }
+
+   m_file = nullptr;
+   m_mapping = nullptr;
+   m_data = nullptr;
+   m_size = 0;
+}
+
+// note: the descriptor is stored off by one, so a valid handle is never null
+// static
+void *zip_archive_t::open_file(const std::string_view &path, uint64_t &size)
+{
+   const std::string filename(path);
+   const int file = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+   if (file < 0) {
+      return nullptr;
+   }
+
+   struct stat status = {};
+   if (fstat(file, &status) != 0) {
+      ::close(file);
+      return nullptr;
+   }
+
+   size = uint64_t(status.st_size);
+
+   return (void *)(intptr_t(file) + 1);
+}
+
+// static
+void zip_archive_t::close_file(void *handle)
+{
+   ::close(int(intptr_t(handle) - 1));
+}
+
+// static
+uint32_t zip_archive_t::read_file(void *handle, const uint64_t offset, void *buffer, const uint32_t size)
+{
+   const ssize_t result = pread(int(intptr_t(handle) - 1), buffer, size, off_t(offset));
+
+   return result > 0 ? uint32_t(result) : 0;
+}
@@ -0,0 +1,35 @@
+// awry_soundbank.h
+
+#pragma once
+
+#include <cstdint>
+
+// note: on-disk layout shared by the runtime loader and tools/soundbank. a
+//       header, a table of contents, then each sound as interleaved 16-bit
+//       pcm starting on its own alignment boundary, ready to be mixed in place.
+
+struct sound_bank_header_t {
+   static constexpr uint32_t magic_value = 0x42535741; // note: 'AWSB'
+   static constexpr uint32_t version_value = 1;
+   static constexpr uint32_t alignment = 64;
+
+   uint32_t magic = magic_value;
+   uint32_t version = version_value;
+   uint32_t entry_count = 0;
+   uint32_t reserved = 0;
+};
+
+struct sound_bank_entry_t {
+   static constexpr int max_name_length = 47;
+
+   char     name[max_name_length + 1] = {};
+   uint32_t channel_count = 0;
+   uint32_t sample_rate = 0;
+   uint32_t frame_count = 0;
+   uint32_t reserved = 0;
+   uint64_t offset = 0;
+   uint64_t size = 0;
+};
+
+static_assert(sizeof(sound_bank_header_t) == 16);
+static_assert(sizeof(sound_bank_entry_t) == 80);
@@ -0,0 +1,73 @@
+// awry_thread_pool.cpp
+
+#include "awry.h"
+#include <algorithm>
+
+thread_pool_t::thread_pool_t(const int thread_count)
+{
+   const int count = thread_count > 0 ? thread_count : std::max(int(std::thread::hardware_concurrency()) - 1, 1);
+   for (int index = 0; index < count; index++) {
+      m_threads.emplace_back([this] {
+         while (true) {
+            std::function<void()> task;
+            {
+               std::unique_lock lock(m_mutex);
+               m_task_ready.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+               if (m_stopping) {
+                  return;
+               }
+
+               task = std::move(m_tasks.front());
+               m_tasks.pop_front();
+               m_busy++;
+            }
+
+            task();
+
+            {
+               std::lock_guard lock(m_mutex);
+               m_busy--;
+               if (m_busy == 0 && m_tasks.empty()) {
+                  m_idle.notify_all();
+               }
+            }
+         }
+      });
+   }
+}
+
+thread_pool_t::~thread_pool_t()
+{
+   // note: tasks still queued are dropped, the ones already running finish
+   {
+      std::lock_guard lock(m_mutex);
+      m_stopping = true;
+      m_tasks.clear();
+   }
+
+   m_task_ready.notify_all();
+   for (auto &thread : m_threads) {
+      thread.join();
+   }
+}
+
+int thread_pool_t::thread_count() const
+{
+   return int(m_threads.size());
+}
+
+void thread_pool_t::submit(std::function<void()> &&task)
+{
+   {
+      std::lock_guard lock(m_mutex);
+      m_tasks.push_back(std::move(task));
+   }
+
+   m_task_ready.notify_one();
+}
+
+void thread_pool_t::wait()
+{
+   std::unique_lock lock(m_mutex);
+   m_idle.wait(lock, [this] { return m_busy == 0 && m_tasks.empty(); });
+}
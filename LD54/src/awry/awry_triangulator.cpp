@@ -0,0 +1,135 @@
+// awry_triangulator.cpp
+
+#include "awry.h"
+#include <cstring>
+
+// static
+uint64_t triangulator_t::hash(const std::span<const vector2_t> positions)
+{
+   // note: fnv1a over the raw vertex bits, identical shapes share a key
+   const uint32_t *words = reinterpret_cast<const uint32_t *>(positions.data());
+   const size_t word_count = positions.size() * 2;
+
+   uint64_t h = 14695981039346656037ull;
+   for (size_t index = 0; index < word_count; index++) {
+      h ^= uint64_t(words[index]);
+      h *= 1099511628211ull;
+   }
+   h ^= uint64_t(positions.size());
+   h *= 1099511628211ull;
+   return h;
+}
+
+bool triangulator_t::triangulate(const std::span<const vector2_t> positions, std::vector<uint32_t> &indices)
+{
+   indices.clear();
+
+   const uint32_t count = uint32_t(positions.size());
+   if (count < 3) {
+      return false;
+   }
+
+   // note: winding decides which side of an edge counts as convex
+   float area = 0.0f;
+   for (uint32_t curr = 0, prev = count - 1; curr < count; prev = curr++) {
+      area += positions[prev].x * positions[curr].y - positions[curr].x * positions[prev].y;
+   }
+   const float winding = area < 0.0f ? -1.0f : 1.0f;
+
+   std::vector<uint32_t> prev(count);
+   std::vector<uint32_t> next(count);
+   for (uint32_t index = 0; index < count; index++) {
+      prev[index] = (index + count - 1) % count;
+      next[index] = (index + 1) % count;
+   }
+
+   auto cross = [&](uint32_t a, uint32_t b, uint32_t c) {
+      const vector2_t ab = positions[b] - positions[a];
+      const vector2_t ac = positions[c] - positions[a];
+      return (ab.x * ac.y - ab.y * ac.x) * winding;
+   };
+
+   auto coincident = [&](uint32_t a, uint32_t b) {
+      return positions[a].x == positions[b].x && positions[a].y == positions[b].y;
+   };
+
+   auto is_ear = [&](uint32_t b) {
+      const uint32_t a = prev[b];
+      const uint32_t c = next[b];
+      if (cross(a, b, c) <= 0.0f) {
+         return false;
+      }
+
+      for (uint32_t p = next[c]; p != a; p = next[p]) {
+         if (coincident(p, a) || coincident(p, b) || coincident(p, c)) {
+            continue;
+         }
+
+         if (cross(a, b, p) >= 0.0f && cross(b, c, p) >= 0.0f && cross(c, a, p) >= 0.0f) {
+            return false;
+         }
+      }
+
+      return true;
+   };
+
+   indices.reserve((count - 2) * 3);
+
+   bool clean = true;
+   uint32_t remaining = count;
+   uint32_t current = 0;
+   uint32_t attempts = 0;
+   while (remaining > 3) {
+      const bool ear = is_ear(current);
+      if (!ear && attempts++ < remaining) {
+         current = next[current];
+         continue;
+      }
+
+      // note: no ear left means self-intersecting or degenerate input, 
+      //       clip anyway so we always terminate with something drawable.
+      clean = clean && ear;
+
+      indices.insert(indices.end(), { prev[current], current, next[current] });
+      next[prev[current]] = next[current];
+      prev[next[current]] = prev[current];
+      current = prev[current];
+      remaining--;
+      attempts = 0;
+   }
+
+   indices.insert(indices.end(), { prev[current], current, next[current] });
+
+   return clean;
+}
+
+const std::vector<uint32_t> &triangulation_cache_t::triangulate(const std::span<const vector2_t> positions)
+{
+   const uint64_t key = triangulator_t::hash(positions);
+   auto it = m_entries.find(key);
+   if (it != m_entries.end() && same_outline(it->second.positions, positions)) {
+      return it->second.indices;
+   }
+
+   if (it == m_entries.end() && m_entries.size() >= max_entry_count) {
+      m_entries.clear();
+   }
+
+   // note: a collision replaces the entry, the other shape triangulates again when it is next drawn
+   entry_t &entry = m_entries[key];
+   entry.positions.assign(positions.begin(), positions.end());
+   triangulator_t::triangulate(positions, entry.indices);
+   return entry.indices;
+}
+
+void triangulation_cache_t::clear()
+{
+   m_entries.clear();
+}
+
+// static
+bool triangulation_cache_t::same_outline(const std::span<const vector2_t> lhs, const std::span<const vector2_t> rhs)
+{
+   // note: bitwise like the hash, so a cached shape always compares equal to itself
+   return lhs.size() == rhs.size() && (lhs.empty() || std::memcmp(lhs.data(), rhs.data(), lhs.size_bytes()) == 0);
+}
@@ -1,18 +1,30 @@
 // awry_windows.cpp
 
 #include "awry.h"
+#include "awry_audio.h"
+#include <cstdio>
+#include <cstring>
 #include <vector>
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
 #include <cmath>
 #include <numbers>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <Windows.h>
 #include <windowsx.h>
 #include <shellscalingapi.h>
 #include <gl/GL.h>
 #include <xaudio2.h>
 
-#define STB_VORBIS_HEADER_ONLY
-#include <stb_vorbis.h>
 #include <stb_image.h>
+#include <stb_image_write.h>
+
+// GL_VERSION_1_2
+#define GL_BGRA                           0x80E1
 
 // GL_VERSION_1_4
 #define GL_MIRRORED_REPEAT                0x8370
@@ -25,13 +37,43 @@ typedef long long GLintptr;
 #define GL_STREAM_DRAW                    0x88E0
 #define GL_STATIC_DRAW                    0x88E4
 #define GL_DYNAMIC_DRAW                   0x88E8
+#define GL_STREAM_READ                    0x88E1
+#define GL_READ_ONLY                      0x88B8
+
+// GL_VERSION_2_0
+typedef char GLchar;
+#define GL_FRAGMENT_SHADER                0x8B30
+#define GL_VERTEX_SHADER                  0x8B31
+#define GL_COMPILE_STATUS                 0x8B81
+#define GL_LINK_STATUS                    0x8B82
+
+// GL_VERSION_2_1
+#define GL_PIXEL_PACK_BUFFER              0x88EB
 
 #define OPENGL_FUNCTIONS \
    GL_FUNC(void, glGenBuffers, GLsizei n, GLuint *buffers) \
    GL_FUNC(void, glBindBuffer, GLenum target, GLuint buffer) \
    GL_FUNC(void, glDeleteBuffers, GLsizei n, const GLuint *buffers) \
    GL_FUNC(void, glBufferData, GLenum target, GLsizeiptr size, const void *data, GLenum usage) \
-   GL_FUNC(void, glBufferSubData, GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+   GL_FUNC(void, glBufferSubData, GLenum target, GLintptr offset, GLsizeiptr size, const void *data) \
+   GL_FUNC(void *, glMapBuffer, GLenum target, GLenum access) \
+   GL_FUNC(GLboolean, glUnmapBuffer, GLenum target) \
+   GL_FUNC(GLuint, glCreateShader, GLenum type) \
+   GL_FUNC(void, glShaderSource, GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length) \
+   GL_FUNC(void, glCompileShader, GLuint shader) \
+   GL_FUNC(void, glGetShaderiv, GLuint shader, GLenum pname, GLint *params) \
+   GL_FUNC(void, glDeleteShader, GLuint shader) \
+   GL_FUNC(GLuint, glCreateProgram, void) \
+   GL_FUNC(void, glAttachShader, GLuint program, GLuint shader) \
+   GL_FUNC(void, glLinkProgram, GLuint program) \
+   GL_FUNC(void, glGetProgramiv, GLuint program, GLenum pname, GLint *params) \
+   GL_FUNC(void, glUseProgram, GLuint program) \
+   GL_FUNC(void, glDeleteProgram, GLuint program) \
+   GL_FUNC(GLint, glGetUniformLocation, GLuint program, const GLchar *name) \
+   GL_FUNC(void, glUniform1i, GLint location, GLint v0) \
+   GL_FUNC(void, glUniform1f, GLint location, GLfloat v0) \
+   GL_FUNC(void, glUniform2f, GLint location, GLfloat v0, GLfloat v1) \
+   GL_FUNC(void, glUniform4f, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
 
 #define GL_FUNC(ret, name, ...)                 \
    typedef ret APIENTRY type_##name (__VA_ARGS__); \
@@ -248,421 +290,288 @@ struct window_t final : native_window_t {
    WINDOWPLACEMENT m_placement = {};
 };
 
-struct indexer_t {
-   indexer_t() = default;
-   indexer_t(uint32_t i) : m_gen(uint16_t(i >> 16)), m_index(uint16_t(i)) {}
-
-   bool operator==(const indexer_t &rhs) const { return m_gen == rhs.m_gen && m_index == rhs.m_index; }
-
-   uint32_t id()   { return (uint32_t(m_gen) << 16 | uint32_t(m_index)); }
-   void     next() { m_gen++; }
-
-   uint16_t m_gen = 1;
-   uint16_t m_index = 0;
-};
-
-struct audio_buffer_t {
-   indexer_t          handle;
-   uint32_t           size = 0;
-   std::vector<short> samples;
-};
-
-struct audio_source_t {
-   bool                 active = false;
-   IXAudio2SourceVoice *voice = nullptr;
-   XAUDIO2_BUFFER       buffer = {};
-};
-
-struct audio_callback_t final : IXAudio2VoiceCallback
-{
-   void DECLSPEC_NOTHROW OnVoiceProcessingPassStart(UINT32 BytesRequired) { }
-   void DECLSPEC_NOTHROW OnVoiceProcessingPassEnd() { }
-   void DECLSPEC_NOTHROW OnStreamEnd() { }
-   void DECLSPEC_NOTHROW OnBufferStart(void *pBufferContext) { }
-   void DECLSPEC_NOTHROW OnBufferEnd(void *pBufferContext) { (*(audio_source_t *)pBufferContext).active = false; }
-   void DECLSPEC_NOTHROW OnLoopEnd(void *pBufferContext) { }
-   void DECLSPEC_NOTHROW OnVoiceError(void *pBufferContext, HRESULT Error) { }
-};
-
-struct audio_device_t {
-   static inline audio_device_t *ptr = nullptr;
+// note: plays the mixer output through one streaming float source voice
+struct xaudio2_sink_t final : audio_sink_t, IXAudio2VoiceCallback {
+   static constexpr int buffer_count = 3;
 
-   static constexpr int max_buffer_count = 256;
-   static constexpr int max_source_count = 64;
-   static constexpr int channel_count = 2;
-   static constexpr int sample_rate = 44100;
-   static constexpr int bits_per_sample = 16;
+   xaudio2_sink_t() = default;
+   ~xaudio2_sink_t()
+   {
+      close();
+   }
 
-   audio_device_t()
+   bool open(const int sample_rate, const int channel_count, const int block_frame_count)
    {
-      HRESULT hr = S_OK;
-      hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+      HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
       if (FAILED(hr)) {
-         win_fatal_error("CoInitializeEx failed!");
+         return false;
       }
 
       hr = XAudio2Create(&m_audio_device);
       if (FAILED(hr)) {
-         win_fatal_error("XAudio2Create failed!");
+         return false;
       }
 
       hr = m_audio_device->CreateMasteringVoice(&m_master_voice, channel_count, sample_rate);
       if (FAILED(hr)) {
-         win_fatal_error("CreateMasteringVoice failed!");
-      }
-
-      for (uint16_t index = 0; auto &buffer : m_buffers) {
-         buffer.handle.m_index = index++;
+         return false;
       }
 
       const WAVEFORMATEX waveform =
       {
-         .wFormatTag = WAVE_FORMAT_PCM,
-         .nChannels = channel_count,
-         .nSamplesPerSec = sample_rate,
-         .nAvgBytesPerSec = channel_count * sample_rate * (bits_per_sample / 8),
-         .nBlockAlign = 4,
-         .wBitsPerSample = bits_per_sample,
+         .wFormatTag = WAVE_FORMAT_IEEE_FLOAT,
+         .nChannels = WORD(channel_count),
+         .nSamplesPerSec = DWORD(sample_rate),
+         .nAvgBytesPerSec = DWORD(channel_count * sample_rate * sizeof(float)),
+         .nBlockAlign = WORD(channel_count * sizeof(float)),
+         .wBitsPerSample = 32,
          .cbSize = 0,
       };
 
-      for (auto &source : m_sources) {
-         source.buffer.Flags = XAUDIO2_END_OF_STREAM;
-         source.buffer.pContext = &source;
-         hr = m_audio_device->CreateSourceVoice(&source.voice,
-                                                &waveform,
-                                                0,
-                                                XAUDIO2_DEFAULT_FREQ_RATIO,
-                                                &m_callbacks,
-                                                nullptr,
-                                                nullptr);
-         if (FAILED(hr)) {
-            win_fatal_error("CreateSourceVoice failed!");
-         }
+      hr = m_audio_device->CreateSourceVoice(&m_voice,
+                                             &waveform,
+                                             0,
+                                             XAUDIO2_DEFAULT_FREQ_RATIO,
+                                             this,
+                                             nullptr,
+                                             nullptr);
+      if (FAILED(hr)) {
+         return false;
       }
 
-      audio_device_t::ptr = this;
-   }
+      m_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+      m_channel_count = channel_count;
+      m_submitted_frames = 0;
+      m_underruns = 0;
+      for (auto &block : m_blocks) {
+         block.resize(size_t(block_frame_count) * channel_count);
+      }
 
-   ~audio_device_t()
-   {
-      audio_device_t::ptr = nullptr;
-      m_audio_device->Release();
-      CoUninitialize();
+      m_voice->Start(0, XAUDIO2_COMMIT_NOW);
+
+      return true;
    }
 
-   void play(indexer_t handle, float volume)
+   void close()
    {
-      if (m_audio_device == nullptr) {
-         return;
+      if (m_voice != nullptr) {
+         m_voice->Stop(0, XAUDIO2_COMMIT_NOW);
+         m_voice->DestroyVoice();
+         m_voice = nullptr;
       }
 
-      if (m_buffers[handle.m_index].handle != handle) {
-         return;
+      if (m_audio_device != nullptr) {
+         m_audio_device->Release();
+         m_audio_device = nullptr;
+         m_master_voice = nullptr;
+         CoUninitialize();
       }
 
-      if (m_buffers[handle.m_index].samples.empty()) {
-         return;
+      if (m_event != nullptr) {
+         CloseHandle(m_event);
+         m_event = nullptr;
+      }
+   }
+
+   bool write(const float *samples, const int frame_count)
+   {
+      if (m_voice == nullptr) {
+         return false;
       }
 
-      audio_buffer_t &buffer = m_buffers[handle.m_index];
-      for (auto &source : m_sources) {
-         if (source.active) {
-            continue;
+      // note: keep at most buffer_count blocks queued, wait for the voice to finish one.
+      //       finding nothing queued once playback started means the voice ran dry.
+      for (bool first = true;; first = false) {
+         XAUDIO2_VOICE_STATE state = {};
+         m_voice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+         if (first && state.BuffersQueued == 0 && m_submitted_frames > 0) {
+            m_underruns++;
          }
 
-         source.active = true;
-         source.buffer.AudioBytes = (UINT32)buffer.size;
-         source.buffer.pAudioData = (BYTE *)buffer.samples.data();
-         source.buffer.LoopCount = 0;
-         source.voice->SubmitSourceBuffer(&source.buffer, nullptr);
-         source.voice->Start(0, XAUDIO2_COMMIT_NOW);
-         source.voice->SetVolume(volume, XAUDIO2_COMMIT_NOW);
-         break;
+         if (state.BuffersQueued < buffer_count) {
+            break;
+         }
+
+         WaitForSingleObject(m_event, 100);
       }
-   }
 
-   indexer_t create(std::vector<short> &&data)
-   {
-      for (auto &buffer : m_buffers) {
-         if (buffer.samples.empty()) {
-            buffer.size    = uint32_t(data.size() * sizeof(short));
-            buffer.samples = std::move(data);
-            return buffer.handle;
-         }
+      std::vector<float> &block = m_blocks[m_next_block];
+      m_next_block = (m_next_block + 1) % buffer_count;
+      std::memcpy(block.data(), samples, size_t(frame_count) * m_channel_count * sizeof(float));
+
+      XAUDIO2_BUFFER buffer = {};
+      buffer.AudioBytes = UINT32(size_t(frame_count) * m_channel_count * sizeof(float));
+      buffer.pAudioData = (const BYTE *)block.data();
+
+      if (FAILED(m_voice->SubmitSourceBuffer(&buffer, nullptr))) {
+         return false;
       }
 
-      return indexer_t{ 0 };
+      m_submitted_frames += uint64_t(frame_count);
+
+      return true;
    }
 
-   void destroy(indexer_t handle)
+   int queued_frame_count()
    {
-      if (m_buffers[handle.m_index].handle != handle) {
-         return;
+      if (m_voice == nullptr) {
+         return 0;
       }
 
-      if (m_buffers[handle.m_index].samples.empty()) {
-         return;
-      }
+      // note: SamplesPlayed counts frames since the voice started, as does m_submitted_frames
+      XAUDIO2_VOICE_STATE state = {};
+      m_voice->GetState(&state, 0);
+      return int(m_submitted_frames > state.SamplesPlayed ? m_submitted_frames - state.SamplesPlayed : 0);
+   }
 
-      m_buffers[handle.m_index].handle.next();
-      m_buffers[handle.m_index].samples.clear();
+   uint32_t underrun_count()
+   {
+      return m_underruns;
    }
 
+   void DECLSPEC_NOTHROW OnVoiceProcessingPassStart(UINT32 BytesRequired) { }
+   void DECLSPEC_NOTHROW OnVoiceProcessingPassEnd() { }
+   void DECLSPEC_NOTHROW OnStreamEnd() { }
+   void DECLSPEC_NOTHROW OnBufferStart(void *pBufferContext) { }
+   void DECLSPEC_NOTHROW OnBufferEnd(void *pBufferContext) { SetEvent(m_event); }
+   void DECLSPEC_NOTHROW OnLoopEnd(void *pBufferContext) { }
+   void DECLSPEC_NOTHROW OnVoiceError(void *pBufferContext, HRESULT Error) { }
+
    IXAudio2               *m_audio_device = nullptr;
    IXAudio2MasteringVoice *m_master_voice = nullptr;
-   audio_callback_t        m_callbacks;
-   audio_buffer_t          m_buffers[max_buffer_count];
-   audio_source_t          m_sources[max_source_count];
+   IXAudio2SourceVoice    *m_voice = nullptr;
+   HANDLE                  m_event = nullptr;
+   int                     m_channel_count = 0;
+   int                     m_next_block = 0;
+   uint64_t                m_submitted_frames = 0;
+   uint32_t                m_underruns = 0;
+   std::vector<float>      m_blocks[buffer_count];
 };
 
-bool sound_t::valid() const
-{
-   return m_id != 0;
-}
-
-bool sound_t::create_from_file(const char *path)
+// note: zip archives are opened for overlapped io, which keeps no file pointer
+//       and lets reads from several threads be in flight at once. each read
+//       waits on its own event, the handle is signalled by whichever finishes.
+// static
+void *zip_archive_t::open_file(const std::string_view &path, uint64_t &size)
 {
-   int error_code = 0;
-   stb_vorbis *vorbis = stb_vorbis_open_filename(path, &error_code, nullptr);
-   if (vorbis == nullptr) {
-      return false;
+   HANDLE handle = CreateFileA(path.data(),
+                               GENERIC_READ,
+                               FILE_SHARE_READ,
+                               nullptr,
+                               OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+                               nullptr);
+   if (handle == INVALID_HANDLE_VALUE) {
+      return nullptr;
    }
 
-   stb_vorbis_info info = stb_vorbis_get_info(vorbis);
-   uint32_t num_samples = stb_vorbis_stream_length_in_samples(vorbis) * info.channels;
-
-   std::vector<short> samples(num_samples);
-   stb_vorbis_get_samples_short_interleaved(vorbis, info.channels, samples.data(), (int)samples.size());
-   stb_vorbis_close(vorbis);
-
-   m_id = audio_device_t::ptr->create(std::move(samples)).id();
-   
-   return valid();
-}
-
-bool sound_t::create_from_memory(const std::vector<uint8_t> &content)
-{
-   int error_code = 0;
-   stb_vorbis *vorbis = stb_vorbis_open_memory(content.data(), int(content.size()), &error_code, nullptr);
-   if (vorbis == nullptr) {
-      return false;
+   LARGE_INTEGER file_size = {};
+   if (GetFileSizeEx(handle, &file_size) == FALSE) {
+      CloseHandle(handle);
+      return nullptr;
    }
 
-   stb_vorbis_info info = stb_vorbis_get_info(vorbis);
-   uint32_t num_samples = stb_vorbis_stream_length_in_samples(vorbis) * info.channels;
-
-   std::vector<short> samples(num_samples);
-   stb_vorbis_get_samples_short_interleaved(vorbis, info.channels, samples.data(), (int)samples.size());
-   stb_vorbis_close(vorbis);
-
-   m_id = audio_device_t::ptr->create(std::move(samples)).id();
+   size = uint64_t(file_size.QuadPart);
 
-   return valid();
+   return handle;
 }
 
-void sound_t::destroy()
+// static
+void zip_archive_t::close_file(void *handle)
 {
-   if (valid()) {
-      audio_device_t::ptr->destroy(indexer_t{ m_id });
-   }
-
-   m_id = 0;
+   CloseHandle(handle);
 }
 
-void sound_t::play(float volume)
+// static
+uint32_t zip_archive_t::read_file(void *handle, const uint64_t offset, void *buffer, const uint32_t size)
 {
-   if (!valid()) {
-      return;
+   OVERLAPPED overlapped = {};
+   overlapped.Offset = DWORD(offset);
+   overlapped.OffsetHigh = DWORD(offset >> 32);
+   overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+   if (overlapped.hEvent == nullptr) {
+      return 0;
    }
 
-   audio_device_t::ptr->play(indexer_t{ m_id }, volume);
-}
-
-#pragma pack(push, 1)
-struct zip_local_header_t {
-   uint32_t signature;
-   uint16_t version;
-   uint16_t bit_flags;
-   uint16_t method;
-   uint16_t last_mod_time;
-   uint16_t last_mod_date;
-   uint32_t crc32;
-   uint32_t size_compressed;
-   uint32_t size_uncompressed;
-   uint16_t filename_length;
-   uint16_t extra_field_length;
-};
-
-// note: central directory file header
-struct zip_cdir_file_header_t {
-   uint32_t signature;
-   uint16_t version;
-   uint16_t minimum_version;
-   uint16_t bit_flags;
-   uint16_t method;
-   uint16_t last_mod_time;
-   uint16_t last_mod_date;
-   uint32_t crc32;
-   uint32_t size_compressed;
-   uint32_t size_uncompressed;
-   uint16_t filename_length;
-   uint16_t extra_field_length;
-   uint16_t comment_length;
-   uint16_t disk_num_file_start;
-   uint16_t internal_file_attribs;
-   uint32_t external_file_attribs;
-   uint32_t local_header_offset;
-};
-
-// note: end of central directory record
-struct zip_eocdir_record_t {
-   uint32_t signature;
-   uint16_t disk_count;
-   uint16_t disk_cdir_start;
-   uint16_t local_cdir_count;
-   uint16_t cdir_record_count;
-   uint32_t cdir_size;
-   uint32_t cdir_offset;
-   uint16_t comment_length;
-};
-#pragma pack(pop)
-
-static constexpr uint32_t kZipCentralDirSignature = 0x02014B50u;
-static constexpr uint32_t kZipLocalSignature = 0x04034B50u;
-static constexpr uint32_t kZipEocdSignature = 0x06054B50u;
-
-static uint64_t
-fnv1a64(const char *str)
-{
-   uint64_t h = 14695981039346656037;
-   while (*str != '\0') {
-      h ^= uint64_t(str[0]);
-      h *= 1099511628211;
-      str++;
+   DWORD result = 0;
+   const bool started = ReadFile(handle, buffer, size, nullptr, &overlapped) != FALSE || GetLastError() == ERROR_IO_PENDING;
+   if (!started || GetOverlappedResult(handle, &overlapped, &result, TRUE) == FALSE) {
+      result = 0;
    }
-   return h;
-}
 
-zip_archive_t::zip_archive_t()
-   : m_handle(INVALID_HANDLE_VALUE)
-{
+   CloseHandle(overlapped.hEvent);
+
+   return result;
 }
 
-zip_archive_t::~zip_archive_t()
+file_mapping_t::~file_mapping_t()
 {
    close();
 }
 
-bool zip_archive_t::valid() const
+bool file_mapping_t::valid() const
 {
-   return m_handle != INVALID_HANDLE_VALUE;
+   return m_data != nullptr;
 }
 
-bool zip_archive_t::open(const std::string_view &path)
+bool file_mapping_t::open(const std::string_view &path)
 {
-   m_handle = CreateFileA(path.data(),
-                               GENERIC_READ,
-                               FILE_SHARE_READ,
-                               nullptr,
-                               OPEN_EXISTING,
-                               FILE_ATTRIBUTE_NORMAL,
-                               nullptr);
-   if (m_handle == INVALID_HANDLE_VALUE) {
+   close();
+
+   const std::string filename(path);
+   m_file = CreateFileA(filename.c_str(),
+                        GENERIC_READ,
+                        FILE_SHARE_READ,
+                        nullptr,
+                        OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL,
+                        nullptr);
+   if (m_file == INVALID_HANDLE_VALUE) {
+      m_file = nullptr;
       return false;
    }
 
    LARGE_INTEGER size = {};
-   if (GetFileSizeEx(m_handle, &size) == FALSE) {
+   if (GetFileSizeEx(m_file, &size) == FALSE || size.QuadPart == 0) {
       close();
       return false;
    }
 
-   zip_eocdir_record_t eocd = {};
-   LARGE_INTEGER position = { .QuadPart = size.QuadPart - LONGLONG(sizeof(eocd)) };
-   SetFilePointerEx(m_handle, position, nullptr, FILE_BEGIN);
-   ReadFile(m_handle, &eocd, sizeof(eocd), nullptr, nullptr);
-   if (eocd.signature != kZipEocdSignature) {
+   m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if (m_mapping == nullptr) {
       close();
       return false;
    }
 
-   position = { .QuadPart = eocd.cdir_offset };
-   SetFilePointerEx(m_handle, position, nullptr, FILE_BEGIN);
-   for (uint32_t index = 0; index < eocd.cdir_record_count; index++) {
-      zip_cdir_file_header_t cdir = {};
-      ReadFile(m_handle, &cdir, sizeof(cdir), nullptr, nullptr);
-      if (cdir.signature != kZipCentralDirSignature) {
-         close();
-         return false;
-      }
-
-      bool might_be_ascii = (cdir.internal_file_attribs & 0x1);
-      std::string name(cdir.filename_length, '\0');
-      ReadFile(m_handle, name.data(), DWORD(name.size()), nullptr, nullptr);
-
-      zip_entry_t entry = {};
-      entry.name = name;
-      entry.hash = fnv1a64(name.c_str());
-      entry.data_offset = cdir.local_header_offset + sizeof(zip_local_header_t) + cdir.filename_length;
-      entry.size_compressed = cdir.size_compressed + (might_be_ascii ? 1 : 0);
-      entry.size_uncompressed = cdir.size_uncompressed;
-      m_entries.push_back(entry);
-   }
-
-   return valid();
-}
-
-void zip_archive_t::close()
-{
-   if (valid()) {
-      CloseHandle(m_handle);
-   }
-
-   m_handle = INVALID_HANDLE_VALUE;
-}
-
-bool zip_archive_t::contains(const std::string_view &path) const
-{
-   if (!valid()) {
+   m_data = (const uint8_t *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+   if (m_data == nullptr) {
+      close();
       return false;
    }
 
-   const uint64_t hash = fnv1a64(path.data());
-   for (auto &entry : m_entries) {
-      if (entry.hash == hash) {
-         return true;
-      }
-   }
+   m_size = size_t(size.QuadPart);
 
-   return false;
+   return valid();
 }
 
-bool zip_archive_t::load_content(const std::string_view &path, std::vector<uint8_t> &content)
+void file_mapping_t::close()
 {
-   if (!valid()) {
-      return false;
+   if (m_data != nullptr) {
+      UnmapViewOfFile(m_data);
    }
 
-   const uint64_t hash = fnv1a64(path.data());
-   for (auto &entry : m_entries) {
-      if (entry.hash == hash) {
-         std::vector<uint8_t> compressed;
-         compressed.resize(entry.size_compressed);
-
-         LARGE_INTEGER position = { .QuadPart = (LONGLONG)entry.data_offset };
-         SetFilePointerEx(m_handle, position, nullptr, FILE_BEGIN);
-         ReadFile(m_handle, compressed.data(), DWORD(compressed.size()), nullptr, nullptr);
+   if (m_mapping != nullptr) {
+      CloseHandle(m_mapping);
+   }
 
-         content.resize(entry.size_uncompressed);
-         return stbi_zlib_decode_noheader_buffer((char *)content.data(),
-                                                 int(content.size()),
-                                                 (char *)compressed.data(),
-                                                 int(compressed.size())) > 0;
-      }
+   if (m_file != nullptr) {
+      CloseHandle(m_file);
    }
 
-   return true;
+   m_file = nullptr;
+   m_mapping = nullptr;
+   m_data = nullptr;
+   m_size = 0;
 }
 
 namespace
@@ -692,15 +601,16 @@ struct vertex_buffer_t {
       return id != 0;
    }
 
-   bool create(uint64_t sz, const void *data)
+   bool create(uint32_t tgt, uint64_t sz, const void *data)
    {
       destroy();
 
+      target = tgt;
       size = sz;
       glGenBuffers(1, &id);
-      glBindBuffer(GL_ARRAY_BUFFER, id);
-      glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      glBindBuffer(target, id);
+      glBufferData(target, size, data, GL_STATIC_DRAW);
+      glBindBuffer(target, 0);
       if (glGetError() != GL_NO_ERROR) {
          destroy();
          return false;
@@ -715,13 +625,13 @@ struct vertex_buffer_t {
          return;
       }
 
-      glBindBuffer(GL_ARRAY_BUFFER, id);
+      glBindBuffer(target, id);
       if (sz < size) {
-         glBufferSubData(GL_ARRAY_BUFFER, 0, sz, data);
+         glBufferSubData(target, 0, sz, data);
       }
       else {
-         glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
-         glBufferData(GL_ARRAY_BUFFER, sz, data, GL_STATIC_DRAW);
+         glBufferData(target, size, nullptr, GL_STATIC_DRAW);
+         glBufferData(target, sz, data, GL_STATIC_DRAW);
          size = sz;
       }
 
@@ -740,24 +650,87 @@ struct vertex_buffer_t {
    }
 
    uint32_t id = 0;
+   uint32_t target = GL_ARRAY_BUFFER;
    uint64_t  size = 0;
 };
 
 struct command_t {
-   uint32_t         count = 0;
-   const texture_t *texture = nullptr;
+   uint32_t                  count = 0;
+   const texture_t          *texture = nullptr;
+   bool                      sdf = false;
+   graphics_t::sdf_style_t   style;
 };
 
+// note: glsl 1.20 against the fixed function state, only distance field text uses it
+constexpr const char *kSdfVertexShader = R"(
+#version 120
+varying vec2 v_texcoord;
+varying vec4 v_color;
+void main()
+{
+   gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+   v_texcoord = gl_MultiTexCoord0.xy;
+   v_color = gl_Color;
+}
+)";
+
+constexpr const char *kSdfFragmentShader = R"(
+#version 120
+uniform sampler2D u_texture;
+uniform vec4  u_outline_color;
+uniform float u_outline_width;
+uniform vec4  u_shadow_color;
+uniform vec2  u_shadow_offset;
+uniform float u_shadow_softness;
+varying vec2 v_texcoord;
+varying vec4 v_color;
+void main()
+{
+   float distance = texture2D(u_texture, v_texcoord).a;
+   float width = max(fwidth(distance) * 0.5, 0.001);
+   float fill = smoothstep(0.5 - width, 0.5 + width, distance);
+   float outline = smoothstep(0.5 - u_outline_width - width, 0.5 - u_outline_width + width, distance);
+   float shadow_distance = texture2D(u_texture, v_texcoord - u_shadow_offset).a;
+   float shadow = smoothstep(0.5 - u_shadow_softness - width, 0.5 + width, shadow_distance);
+
+   vec4 result = vec4(v_color.rgb, 1.0) * (v_color.a * fill);
+   result += vec4(u_outline_color.rgb, 1.0) * (u_outline_color.a * outline) * (1.0 - result.a);
+   result += vec4(u_shadow_color.rgb, 1.0) * (u_shadow_color.a * shadow) * (1.0 - result.a);
+   gl_FragColor = result.a > 0.0 ? vec4(result.rgb / result.a, result.a) : vec4(0.0);
+}
+)";
+
 struct gl_graphics_t final : graphics_t {
+   // note: one cross section of a strip, the fringe indices alias 
+   //       left/right when there is no feathered edge.
+   struct strip_edge_t {
+      uint32_t left_fringe;
+      uint32_t left;
+      uint32_t right;
+      uint32_t right_fringe;
+   };
+
+   struct feather_t {
+      float core = 0.0f;
+      float outer = 0.0f;
+      float alpha = 1.0f;
+   };
+
    gl_graphics_t()
    {
       uint32_t color = 0xffffffff;
       m_texture.create({ 1,1 }, &color);
-      m_vertex_buffer.create(sizeof(vertex_t) * 8192, nullptr);
+      m_vertex_buffer.create(GL_ARRAY_BUFFER, sizeof(vertex_t) * 8192, nullptr);
+      m_index_buffer.create(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * 12288, nullptr);
+      create_sdf_program();
    }
 
    ~gl_graphics_t()
    {
+      if (m_sdf_program != 0) {
+         glDeleteProgram(m_sdf_program);
+      }
+
       m_texture.destroy();
    }
 
@@ -769,6 +742,16 @@ struct gl_graphics_t final : graphics_t {
    void projection(const vector2_t &projection)
    {
       m_projection = { projection.x, projection.y };
+
+      // note: one screen pixel in canvas units, the width of a feathered edge
+      GLint viewport[4] = {};
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      m_pixel_size = viewport[2] > 0 ? projection.x / float(viewport[2]) : 1.0f;
+   }
+
+   void antialiasing(const bool enabled)
+   {
+      m_antialiasing = enabled;
    }
 
    void draw_rect_filled(const rectangle_t &dst, const color_t &color)
@@ -791,20 +774,16 @@ struct gl_graphics_t final : graphics_t {
 
    void draw_rect_filled(const rectangle_t &dst, const matrix3_t &transform, const color_t &color)
    {
-      const vector2_t p0 = transform * vector2_t{ dst.x        , dst.y         };
-      const vector2_t p1 = transform * vector2_t{ dst.x + dst.w, dst.y         };
-      const vector2_t p2 = transform * vector2_t{ dst.x + dst.w, dst.y + dst.h };
-      const vector2_t p3 = transform * vector2_t{ dst.x        , dst.y + dst.h };
-
-      const vector2_t uv = { 0.5f, 0.5f };
-
-      const vertex_t v0 = { p0, uv, color };
-      const vertex_t v1 = { p1, uv, color };
-      const vertex_t v2 = { p2, uv, color };
-      const vertex_t v3 = { p3, uv, color };
+      const vector2_t corners[] =
+      {
+         transform * vector2_t{ dst.x        , dst.y         },
+         transform * vector2_t{ dst.x + dst.w, dst.y         },
+         transform * vector2_t{ dst.x + dst.w, dst.y + dst.h },
+         transform * vector2_t{ dst.x        , dst.y + dst.h },
+      };
 
-      push(m_texture);
-      push(v0, v1, v2, v3);
+      static constexpr uint32_t indices[] = { 0, 1, 2, 2, 3, 0 };
+      push_filled(corners, indices, color);
    }
 
    void draw_rect_outlined(const rectangle_t &dst, const float thickness, const color_t &color)
@@ -842,71 +821,17 @@ struct gl_graphics_t final : graphics_t {
 
    void draw_circle_filled(const vector2_t &center, const float radius, const int steps, const color_t &color)
    {
-      const vector2_t uv = { 0.5f, 0.5f };
-      const vector2_t p0 = center;
-      vector2_t p1 = center + vector2_t{ radius, 0.0 };
-
-      push(m_texture);
-      for (int i = 1; i <= steps; i++) {
-         const float theta = float(i) / float(steps) * math_t::kPI2;
-         const vector2_t p2{ center.x + std::cosf(theta) * radius, center.y + std::sinf(theta) * radius };
-
-         const vertex_t v0 = { p0, uv, color };
-         const vertex_t v1 = { p1, uv, color };
-         const vertex_t v2 = { p2, uv, color };
-         push(v0, v1, v2);
-
-         p1 = p2;
-      }
+      push_disc(center, radius, steps, color, color);
    }
 
    void draw_circle_filled(const vector2_t &center, const float radius, const int steps, const color_t &center_color, const color_t &outer_color)
    {
-      const vector2_t uv = { 0.5f, 0.5f };
-      const vector2_t p0 = center;
-      vector2_t p1 = center + vector2_t{ radius, 0.0f };
-
-      push(m_texture);
-      for (int i = 1; i <= steps; i++) {
-         const float theta = float(i) / float(steps) * math_t::kPI2;
-         const vector2_t p2{ center.x + std::cosf(theta) * radius, center.y + std::sinf(theta) * radius };
-
-         const vertex_t v0 = { p0, uv, center_color };
-         const vertex_t v1 = { p1, uv, outer_color };
-         const vertex_t v2 = { p2, uv, outer_color };
-
-         push(v0, v1, v2);
-
-         p1 = p2;
-      }
+      push_disc(center, radius, steps, center_color, outer_color);
    }
 
    void draw_circle_outlined(const vector2_t &center, const float radius_outer, const int steps, const float thickness, const color_t &color)
    {
-      const float radius_inner = radius_outer - thickness;
-      vector2_t p1_outer = center + vector2_t{ radius_outer, 0.0 };
-      vector2_t p1_inner = center + vector2_t{ radius_inner, 0.0 };
-
-      const vector2_t uv = { 0.5f, 0.5f };
-
-      push(m_texture);
-      for (int i = 1; i <= steps; i++) {
-         const float theta = float(i) / float(steps) * math_t::kPI2;
-         const vector2_t normal{ std::cosf(theta), std::sinf(theta) };
-
-         const vector2_t p2_outer{ center.x + normal.x * radius_outer, center.y + normal.y * radius_outer };
-         const vector2_t p2_inner{ center.x + normal.x * radius_inner, center.y + normal.y * radius_inner };
-
-         const vertex_t v0 = { p1_inner, uv, color };
-         const vertex_t v1 = { p1_outer, uv, color };
-         const vertex_t v2 = { p2_outer, uv, color };
-         const vertex_t v3 = { p2_inner, uv, color };
-
-         push(v0, v1, v2, v3);
-
-         p1_outer = p2_outer;
-         p1_inner = p2_inner;
-      }
+      push_band(center, radius_outer - thickness * 0.5f, thickness * 0.5f, steps, 0.0f, math_t::kPI2, true, color);
    }
 
    void draw_circle_segment(const vector2_t &center, const float radius, const int steps, const float start_angle,
@@ -914,120 +839,149 @@ struct gl_graphics_t final : graphics_t {
    {
       const float theta = angle_diff(start_angle, end_angle);
 
-      const vector2_t uv = { 0.5f, 0.5f };
-      const vector2_t p0 = center;
-      vector2_t p1 = center + from_angle(start_angle, radius);
-
-      push(m_texture);
-      for (int i = 1; i <= steps; i++) {
-         const float step = i / float(steps);
-         const float angle = start_angle + theta * step;
-
-         vector2_t p2 = center + from_angle(angle, radius);
-
-         const vertex_t v0 = { p0, uv, color };
-         const vertex_t v1 = { p1, uv, color };
-         const vertex_t v2 = { p2, uv, color };
-
-         push(v0, v1, v2);
-
-         p1 = p2;
+      // note: the hub and the arc as an outline, filled as a fan so the radial edges get a fringe too
+      m_transformed.clear();
+      m_fan.clear();
+      m_transformed.push_back(center);
+      for (int i = 0; i <= steps; i++) {
+         m_transformed.push_back(center + from_angle(start_angle + theta * (float(i) / float(steps)), radius));
+         if (i > 0) {
+            m_fan.insert(m_fan.end(), { 0u, uint32_t(i), uint32_t(i + 1) });
+         }
       }
+
+      push_filled(m_transformed, m_fan, color);
    }
 
    void draw_circle_segment(const vector2_t &center, const float radius_outer, const int steps, const float thickness,
                                         const float start_angle, const float end_angle, const color_t &color)
    {
-      const float radius_inner = radius_outer - thickness;
       const float theta = angle_diff(start_angle, end_angle);
-
-      const vector2_t uv = { 0.5f, 0.5f };
-      vector2_t p1_outer = from_angle(start_angle, radius_outer);
-      vector2_t p1_inner = from_angle(start_angle, radius_inner);
-
-      push(m_texture);
-      for (int i = 1; i <= steps; i++) {
-         const float step = i / float(steps);
-         const float angle = start_angle + theta * step;
-
-         vector2_t p2_outer = from_angle(angle, radius_outer);
-         vector2_t p2_inner = from_angle(angle, radius_inner);
-
-         const vertex_t v0 = { center + p1_inner, uv, color };
-         const vertex_t v1 = { center + p1_outer, uv, color };
-         const vertex_t v2 = { center + p2_outer, uv, color };
-         const vertex_t v3 = { center + p2_inner, uv, color };
-
-         push(v0, v1, v2, v3);
-
-         p1_outer = p2_outer;
-         p1_inner = p2_inner;
-      }
+      push_band(center, radius_outer - thickness * 0.5f, thickness * 0.5f, steps, start_angle, theta, false, color);
    }
 
    void draw_line(const vector2_t &from, const vector2_t &to, const float thickness, const color_t &color)
    {
-      const vector2_t perp = (to - from).normalized().perp();
-      const vector2_t disp = perp * thickness * 0.5f;
-      const vector2_t p0 = from + disp;
-      const vector2_t p1 = to + disp;
-      const vector2_t p2 = to - disp;
-      const vector2_t p3 = from - disp;
-
-      const vector2_t uv = { 0.5f, 0.5f };
-
-      const vertex_t v0 = { p0, uv, color };
-      const vertex_t v1 = { p1, uv, color };
-      const vertex_t v2 = { p2, uv, color };
-      const vertex_t v3 = { p3, uv, color };
-
-      push(m_texture);
-      push(v0, v1, v2, v3);
+      push_line(from, to, thickness, color, color);
    }
 
    void draw_line(const vector2_t &from, const vector2_t &to, const float thickness, const color_t &from_color,
                               const color_t &to_color)
    {
-      const vector2_t perp = (to - from).normalized().perp();
-      const vector2_t disp = perp * thickness * 0.5f;
-      const vector2_t p0 = from + disp;
-      const vector2_t p1 = to + disp;
-      const vector2_t p2 = to - disp;
-      const vector2_t p3 = from - disp;
-
-      const vector2_t uv = { 0.5f, 0.5f };
-
-      const vertex_t v0 = { p0, uv, from_color };
-      const vertex_t v1 = { p1, uv, to_color };
-      const vertex_t v2 = { p2, uv, to_color };
-      const vertex_t v3 = { p3, uv, from_color };
-
-      push(m_texture);
-      push(v0, v1, v2, v3);
+      push_line(from, to, thickness, from_color, to_color);
    }
 
    void draw_line_strip(const std::span<const vector2_t> positions, const float thickness, const color_t &color)
    {
+      draw_line_strip(positions, thickness, true, line_join_t::miter, color);
+   }
+
+   void draw_line_strip(const std::span<const vector2_t> positions, const float thickness, const bool closed,
+                        const line_join_t join, const color_t &color)
+   {
+      constexpr float kEpsilon = 1e-4f;
+      constexpr float kMiterLimit = 4.0f;
+
+      gather_strip(positions, closed);
+
+      const bool loop = closed && m_strip.size() > 2;
+      const size_t count = m_strip.size();
+      if (count < 2) {
+         return;
+      }
+
+      const feather_t edge = feather(thickness * 0.5f);
+      const bool fringe = edge.outer > edge.core;
+      const color_t core_color = color.fade(edge.alpha);
+      const color_t fringe_color = core_color.fade(0.0f);
+      const vector2_t uv = { 0.5f, 0.5f };
+
+      // note: pushes the core vertex and, when feathering, its transparent twin further out
+      auto push_pair = [&](const vector2_t &p, const vector2_t &direction, uint32_t &core, uint32_t &outer) {
+         core = push_vertex({ p + direction * edge.core, uv, core_color });
+         outer = fringe ? push_vertex({ p + direction * edge.outer, uv, fringe_color }) : core;
+      };
+
       push(m_texture);
-      for (size_t index = 0; index < positions.size(); index++) {
-         auto from = positions[index];
-         auto to = positions[(index + 1) % positions.size()];
 
-         const vector2_t perp = (to - from).normalized().perp();
-         const vector2_t disp = perp * thickness * 0.5f;
-         const vector2_t p0 = from + disp;
-         const vector2_t p1 = to + disp;
-         const vector2_t p2 = to - disp;
-         const vector2_t p3 = from - disp;
+      strip_edge_t first_in = {};
+      strip_edge_t prev_out = {};
+      for (size_t index = 0; index < count; index++) {
+         const bool has_prev = loop || index > 0;
+         const bool has_next = loop || index + 1 < count;
+
+         const vector2_t p = m_strip[index];
+         const vector2_t p0 = m_strip[(index + count - 1) % count];
+         const vector2_t p1 = m_strip[(index + 1) % count];
+
+         strip_edge_t in = {};
+         strip_edge_t out = {};
+         if (!has_prev || !has_next) {
+            // note: open end, square cap along the only segment
+            const vector2_t n = (has_next ? (p1 - p) : (p - p0)).normalized().perp();
+            push_pair(p, n, in.left, in.left_fringe);
+            push_pair(p, -n, in.right, in.right_fringe);
+            out = in;
+         }
+         else {
+            const vector2_t d0 = (p - p0).normalized();
+            const vector2_t d1 = (p1 - p).normalized();
+            const vector2_t n0 = d0.perp();
+            const vector2_t n1 = d1.perp();
+            const vector2_t bisector = n0 + n1;
+
+            const bool can_miter = bisector.length_squared() > kEpsilon;
+            const vector2_t miter = can_miter ? bisector.normalized() : n0;
+            const float miter_scale = can_miter ? 1.0f / miter.dot(n0) : 1.0f;
+
+            if (join == line_join_t::miter && can_miter && miter_scale <= kMiterLimit) {
+               push_pair(p, miter * miter_scale, in.left, in.left_fringe);
+               push_pair(p, -miter * miter_scale, in.right, in.right_fringe);
+               out = in;
+            }
+            else {
+               // note: bevel, the inner corner is shared and the outer corner is split
+               //       in two with a triangle filling the wedge between them.
+               const float side = d1.dot(n0) > 0.0f ? -1.0f : 1.0f;
+               const float shortest = math_t::min((p - p0).length(), (p1 - p).length());
+               const bool inner_miter = can_miter && edge.outer * miter_scale <= shortest;
+               const vector2_t inner_direction = inner_miter ? miter * (-side * miter_scale) : vector2_t::zero();
+
+               uint32_t inner = 0, inner_fringe = 0;
+               uint32_t outer0 = 0, outer0_fringe = 0;
+               uint32_t outer1 = 0, outer1_fringe = 0;
+               push_pair(p, inner_direction, inner, inner_fringe);
+               push_pair(p, n0 * side, outer0, outer0_fringe);
+               push_pair(p, n1 * side, outer1, outer1_fringe);
+
+               push_triangle(outer0, outer1, inner);
+               if (fringe) {
+                  push_quad(outer0, outer0_fringe, outer1_fringe, outer1);
+               }
+
+               if (side > 0.0f) {
+                  in = { outer0_fringe, outer0, inner, inner_fringe };
+                  out = { outer1_fringe, outer1, inner, inner_fringe };
+               }
+               else {
+                  in = { inner_fringe, inner, outer0, outer0_fringe };
+                  out = { inner_fringe, inner, outer1, outer1_fringe };
+               }
+            }
+         }
 
-         const vector2_t uv = { 0.5f, 0.5f };
+         if (index == 0) {
+            first_in = in;
+         }
+         else {
+            push_segment(prev_out, in, fringe);
+         }
 
-         const vertex_t v0 = { p0, uv, color };
-         const vertex_t v1 = { p1, uv, color };
-         const vertex_t v2 = { p2, uv, color };
-         const vertex_t v3 = { p3, uv, color };
+         prev_out = out;
+      }
 
-         push(v0, v1, v2, v3);
+      if (loop) {
+         push_segment(prev_out, first_in, fringe);
       }
    }
 
@@ -1046,22 +1000,54 @@ struct gl_graphics_t final : graphics_t {
       }
    }
 
-   void draw(const texture_t &texture, const rectangle_t &src, const rectangle_t &dst, const color_t &color)
+   void draw_polygon_filled(const std::span<const vector2_t> positions, const color_t &color)
    {
-      const float iu = 1.0f / texture.m_size.x;
-      const float iv = 1.0f / texture.m_size.y;
+      push_filled(positions, m_triangulations.triangulate(positions), color);
+   }
 
-      const vector2_t p0{ dst.x        , dst.y };
-      const vector2_t p1{ dst.x + dst.w, dst.y };
-      const vector2_t p2{ dst.x + dst.w, dst.y + dst.h };
-      const vector2_t p3{ dst.x        , dst.y + dst.h };
+   void draw_polygon_filled(const std::span<const vector2_t> positions, const matrix3_t &transform, const color_t &color)
+   {
+      const std::vector<uint32_t> &indices = m_triangulations.triangulate(positions);
 
-      const vector2_t t0{ (src.x) * iu        , (src.y) * iv };
-      const vector2_t t1{ (src.x + src.w) * iu, (src.y) * iv };
-      const vector2_t t2{ (src.x + src.w) * iu, (src.y + src.h) * iv };
-      const vector2_t t3{ (src.x) * iu        , (src.y + src.h) * iv };
+      m_transformed.clear();
+      for (const vector2_t &position : positions) {
+         m_transformed.push_back(transform * position);
+      }
 
-      const vertex_t v0 = { p0, t0, color };
+      push_filled(m_transformed, indices, color);
+   }
+
+   void draw_polygon_outlined(const std::span<const vector2_t> positions, const float thickness, const color_t &color)
+   {
+      draw_line_strip(positions, thickness, color);
+   }
+
+   void draw_polygon_outlined(const std::span<const vector2_t> positions, const float thickness, const matrix3_t &transform, const color_t &color)
+   {
+      m_transformed.clear();
+      for (const vector2_t &position : positions) {
+         m_transformed.push_back(transform * position);
+      }
+
+      draw_line_strip(m_transformed, thickness, color);
+   }
+
+   void draw(const texture_t &texture, const rectangle_t &src, const rectangle_t &dst, const color_t &color)
+   {
+      const float iu = 1.0f / texture.m_size.x;
+      const float iv = 1.0f / texture.m_size.y;
+
+      const vector2_t p0{ dst.x        , dst.y };
+      const vector2_t p1{ dst.x + dst.w, dst.y };
+      const vector2_t p2{ dst.x + dst.w, dst.y + dst.h };
+      const vector2_t p3{ dst.x        , dst.y + dst.h };
+
+      const vector2_t t0{ (src.x) * iu        , (src.y) * iv };
+      const vector2_t t1{ (src.x + src.w) * iu, (src.y) * iv };
+      const vector2_t t2{ (src.x + src.w) * iu, (src.y + src.h) * iv };
+      const vector2_t t3{ (src.x) * iu        , (src.y + src.h) * iv };
+
+      const vertex_t v0 = { p0, t0, color };
       const vertex_t v1 = { p1, t1, color };
       const vertex_t v2 = { p2, t2, color };
       const vertex_t v3 = { p3, t3, color };
@@ -1096,6 +1082,31 @@ struct gl_graphics_t final : graphics_t {
       push(v0, v1, v2, v3);
    }
 
+   void draw_sdf(const texture_t &texture, const rectangle_t &src, const vector2_t &position, const vector2_t &size,
+                 const sdf_style_t &style, const color_t &color)
+   {
+      const float iu = 1.0f / texture.m_size.x;
+      const float iv = 1.0f / texture.m_size.y;
+
+      const vector2_t p0{ position.x         , position.y };
+      const vector2_t p1{ position.x + size.x, position.y };
+      const vector2_t p2{ position.x + size.x, position.y + size.y };
+      const vector2_t p3{ position.x         , position.y + size.y };
+
+      const vector2_t t0{ (src.x) * iu        , (src.y) * iv };
+      const vector2_t t1{ (src.x + src.w) * iu, (src.y) * iv };
+      const vector2_t t2{ (src.x + src.w) * iu, (src.y + src.h) * iv };
+      const vector2_t t3{ (src.x) * iu        , (src.y + src.h) * iv };
+
+      const vertex_t v0 = { p0, t0, color };
+      const vertex_t v1 = { p1, t1, color };
+      const vertex_t v2 = { p2, t2, color };
+      const vertex_t v3 = { p3, t3, color };
+
+      push_sdf(texture, style);
+      push(v0, v1, v2, v3);
+   }
+
    void execute()
    {
       glClearColor(m_clear_color.r / 255.0f,
@@ -1106,6 +1117,7 @@ struct gl_graphics_t final : graphics_t {
 
       if (m_commands.empty()) {
          m_vertices.clear();
+         m_indices.clear();
          return;
       }
 
@@ -1145,20 +1157,264 @@ struct gl_graphics_t final : graphics_t {
       glVertexPointer(2, GL_FLOAT, sizeof(vertex_t), (const GLvoid *)offsetof(vertex_t, position));
       glTexCoordPointer(2, GL_FLOAT, sizeof(vertex_t), (const GLvoid *)offsetof(vertex_t, texcoord));
       glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(vertex_t), (const GLvoid *)offsetof(vertex_t, color));
+      m_index_buffer.update(sizeof(uint32_t) * m_indices.size(), m_indices.data());
 
-      GLint offset = 0;
+      uint64_t offset = 0;
+      bool sdf = false;
       for (auto &command : m_commands) {
+         if (command.sdf || sdf) {
+            apply_sdf(command);
+            sdf = command.sdf;
+         }
+
          glBindTexture(GL_TEXTURE_2D, command.texture->m_id);
-         glDrawArrays(GL_TRIANGLES, offset, command.count);
+         glDrawElements(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, (const GLvoid *)(offset * sizeof(uint32_t)));
          offset += command.count;
       }
 
+      if (sdf) {
+         apply_sdf(command_t{});
+      }
+
       assert(glGetError() == GL_NO_ERROR);
 
       m_vertices.clear();
+      m_indices.clear();
       m_commands.clear();
    }
 
+   feather_t feather(const float half) const
+   {
+      // note: coverage ramps to zero over one pixel centered on the geometric edge,
+      //       anything thinner than a pixel becomes a dimmer tent of the same area.
+      if (!m_antialiasing) {
+         return { half, half, 1.0f };
+      }
+
+      const float ramp = m_pixel_size * 0.5f;
+      if (half > ramp) {
+         return { half - ramp, half + ramp, 1.0f };
+      }
+
+      return { 0.0f, half + ramp, (2.0f * half) / (half + ramp) };
+   }
+
+   void gather_strip(const std::span<const vector2_t> positions, const bool closed)
+   {
+      constexpr float kEpsilon = 1e-4f;
+
+      // note: drop zero length segments up front, so every direction taken from the strip is well defined
+      m_strip.clear();
+      for (const vector2_t &position : positions) {
+         if (m_strip.empty() || (position - m_strip.back()).length_squared() > kEpsilon * kEpsilon) {
+            m_strip.push_back(position);
+         }
+      }
+      while (closed && m_strip.size() > 1 && (m_strip.front() - m_strip.back()).length_squared() <= kEpsilon * kEpsilon) {
+         m_strip.pop_back();
+      }
+   }
+
+   void push_segment(const strip_edge_t &from, const strip_edge_t &to, const bool fringe)
+   {
+      push_quad(from.left, to.left, to.right, from.right);
+      if (fringe) {
+         push_quad(from.left_fringe, to.left_fringe, to.left, from.left);
+         push_quad(from.right, to.right, to.right_fringe, from.right_fringe);
+      }
+   }
+
+   void push_line(const vector2_t &from, const vector2_t &to, const float thickness, const color_t &from_color,
+                  const color_t &to_color)
+   {
+      const vector2_t perp = (to - from).normalized().perp();
+      const feather_t edge = feather(thickness * 0.5f);
+      const bool fringe = edge.outer > edge.core;
+      const color_t from_core = from_color.fade(edge.alpha);
+      const color_t to_core = to_color.fade(edge.alpha);
+
+      const vector2_t uv = { 0.5f, 0.5f };
+
+      push(m_texture);
+
+      strip_edge_t a = {};
+      a.left = push_vertex({ from + perp * edge.core, uv, from_core });
+      a.right = push_vertex({ from - perp * edge.core, uv, from_core });
+      a.left_fringe = fringe ? push_vertex({ from + perp * edge.outer, uv, from_core.fade(0.0f) }) : a.left;
+      a.right_fringe = fringe ? push_vertex({ from - perp * edge.outer, uv, from_core.fade(0.0f) }) : a.right;
+
+      strip_edge_t b = {};
+      b.left = push_vertex({ to + perp * edge.core, uv, to_core });
+      b.right = push_vertex({ to - perp * edge.core, uv, to_core });
+      b.left_fringe = fringe ? push_vertex({ to + perp * edge.outer, uv, to_core.fade(0.0f) }) : b.left;
+      b.right_fringe = fringe ? push_vertex({ to - perp * edge.outer, uv, to_core.fade(0.0f) }) : b.right;
+
+      push_segment(a, b, fringe);
+   }
+
+   void push_disc(const vector2_t &center, const float radius, const int steps, const color_t &center_color,
+                  const color_t &outer_color)
+   {
+      const float ramp = m_antialiasing ? m_pixel_size * 0.5f : 0.0f;
+      const bool fringe = ramp > 0.0f;
+      const float core_radius = math_t::max(radius - ramp, 0.0f);
+      const color_t fringe_color = outer_color.fade(0.0f);
+      const uint32_t stride = fringe ? 2 : 1;
+
+      const vector2_t uv = { 0.5f, 0.5f };
+
+      push(m_texture);
+
+      const uint32_t hub = push_vertex({ center, uv, center_color });
+      const uint32_t base = hub + 1;
+      for (int i = 0; i < steps; i++) {
+         const vector2_t normal = from_angle(math_t::kPI2 * (float(i) / float(steps)), 1.0f);
+         push_vertex({ center + normal * core_radius, uv, outer_color });
+         if (fringe) {
+            push_vertex({ center + normal * (radius + ramp), uv, fringe_color });
+         }
+      }
+
+      for (int i = 0; i < steps; i++) {
+         const uint32_t curr = base + uint32_t(i) * stride;
+         const uint32_t next = base + uint32_t((i + 1) % steps) * stride;
+         push_triangle(hub, curr, next);
+         if (fringe) {
+            push_quad(curr, curr + 1, next + 1, next);
+         }
+      }
+   }
+
+   void push_band(const vector2_t &center, const float radius, const float half, const int steps, const float start_angle,
+                  const float sweep, const bool closed, const color_t &color)
+   {
+      const feather_t edge = feather(half);
+      const bool fringe = edge.outer > edge.core;
+      const color_t core_color = color.fade(edge.alpha);
+      const color_t fringe_color = core_color.fade(0.0f);
+      const int point_count = closed ? steps : steps + 1;
+      const uint32_t stride = fringe ? 4 : 2;
+      // note: open ends pull back half the ramp along the arc, the cap ramp then centers on the radial edge
+      const float cap = fringe && !closed ? (edge.outer - edge.core) * 0.5f : 0.0f;
+
+      const vector2_t uv = { 0.5f, 0.5f };
+
+      push(m_texture);
+
+      const uint32_t base = uint32_t(m_vertices.size());
+      for (int i = 0; i < point_count; i++) {
+         const vector2_t normal = from_angle(start_angle + sweep * (float(i) / float(steps)), 1.0f);
+         const vector2_t p = center + (i == 0 ? -normal.perp() : i == point_count - 1 ? normal.perp() : vector2_t::zero()) * cap;
+         push_vertex({ p + normal * (radius + edge.core), uv, core_color });
+         push_vertex({ p + normal * (radius - edge.core), uv, core_color });
+         if (fringe) {
+            push_vertex({ p + normal * (radius + edge.outer), uv, fringe_color });
+            push_vertex({ p + normal * (radius - edge.outer), uv, fringe_color });
+         }
+      }
+
+      auto edge_at = [&](int i) {
+         const uint32_t index = base + uint32_t(i % point_count) * stride;
+         return fringe ? strip_edge_t{ index + 2, index, index + 1, index + 3 } : strip_edge_t{ index, index, index + 1, index + 1 };
+      };
+
+      for (int i = 0; i < steps; i++) {
+         push_segment(edge_at(i), edge_at(i + 1), fringe);
+      }
+
+      if (cap > 0.0f) {
+         const vector2_t start_normal = from_angle(start_angle, 1.0f);
+         const vector2_t end_normal = from_angle(start_angle + sweep, 1.0f);
+         push_cap(edge_at(0), start_normal.perp() * (cap * 2.0f), fringe_color);
+         push_cap(edge_at(steps), -end_normal.perp() * (cap * 2.0f), fringe_color);
+      }
+   }
+
+   // note: a transparent copy of the cross section moved out past the end, ramps the end of a band
+   void push_cap(const strip_edge_t &end, const vector2_t &offset, const color_t &fringe_color)
+   {
+      const vector2_t uv = { 0.5f, 0.5f };
+
+      const uint32_t index = uint32_t(m_vertices.size());
+      for (const uint32_t corner : { end.left_fringe, end.left, end.right, end.right_fringe }) {
+         push_vertex({ m_vertices[corner].position + offset, uv, fringe_color });
+      }
+
+      push_quad(end.left_fringe, end.left, index + 1, index);
+      push_quad(end.left, end.right, index + 2, index + 1);
+      push_quad(end.right, end.right_fringe, index + 3, index + 2);
+   }
+
+   // note: fills a triangulated outline, the ramp centers on the outline as it does for strips,
+   //       the interior is inset by half a pixel and a transparent ring sits half a pixel out.
+   void push_filled(const std::span<const vector2_t> outline, const std::span<const uint32_t> indices, const color_t &color)
+   {
+      constexpr float kEpsilon = 1e-4f;
+      constexpr float kMiterLimit = 4.0f;
+
+      const size_t count = outline.size();
+      const float ramp = m_antialiasing && count >= 3 ? m_pixel_size * 0.5f : 0.0f;
+      const vector2_t uv = { 0.5f, 0.5f };
+
+      m_offsets.assign(count, vector2_t::zero());
+      if (ramp > 0.0f) {
+         // note: winding decides which side of an edge is outside
+         float area = 0.0f;
+         for (size_t curr = 0, prev = count - 1; curr < count; prev = curr++) {
+            area += outline[prev].x * outline[curr].y - outline[curr].x * outline[prev].y;
+         }
+         const float outward = area < 0.0f ? -1.0f : 1.0f;
+
+         for (size_t index = 0; index < count; index++) {
+            // note: neighbours on top of p give no direction, step past them
+            const vector2_t p = outline[index];
+            size_t prev = (index + count - 1) % count;
+            while (prev != index && (outline[prev] - p).length_squared() <= kEpsilon * kEpsilon) {
+               prev = (prev + count - 1) % count;
+            }
+            size_t next = (index + 1) % count;
+            while (next != index && (outline[next] - p).length_squared() <= kEpsilon * kEpsilon) {
+               next = (next + 1) % count;
+            }
+            if (prev == index || next == index) {
+               continue;
+            }
+
+            const vector2_t n0 = (p - outline[prev]).normalized().perp() * outward;
+            const vector2_t n1 = (outline[next] - p).normalized().perp() * outward;
+            const vector2_t bisector = n0 + n1;
+            const vector2_t miter = bisector.length_squared() > kEpsilon ? bisector.normalized() : n0;
+            const float miter_scale = math_t::min(1.0f / math_t::max(miter.dot(n0), 1.0f / kMiterLimit), kMiterLimit);
+            m_offsets[index] = miter * (ramp * miter_scale);
+         }
+      }
+
+      push(m_texture);
+
+      const uint32_t base = uint32_t(m_vertices.size());
+      for (size_t index = 0; index < count; index++) {
+         push_vertex({ outline[index] - m_offsets[index], uv, color });
+      }
+
+      for (size_t index = 0; index + 2 < indices.size(); index += 3) {
+         push_triangle(base + indices[index + 0], base + indices[index + 1], base + indices[index + 2]);
+      }
+
+      if (ramp > 0.0f) {
+         const color_t fringe_color = color.fade(0.0f);
+         const uint32_t ring = uint32_t(m_vertices.size());
+         for (size_t index = 0; index < count; index++) {
+            push_vertex({ outline[index] + m_offsets[index], uv, fringe_color });
+         }
+
+         for (size_t index = 0; index < count; index++) {
+            const uint32_t curr = uint32_t(index);
+            const uint32_t next = uint32_t((index + 1) % count);
+            push_quad(base + curr, ring + curr, ring + next, base + next);
+         }
+      }
+   }
+
    void push(const texture_t &texture)
    {
       assert(texture.valid());
@@ -1166,30 +1422,504 @@ struct gl_graphics_t final : graphics_t {
          m_commands.emplace_back(0, std::addressof(texture));
       }
       else {
-         if (m_commands.back().texture != std::addressof(texture)) {
+         if (m_commands.back().texture != std::addressof(texture) || m_commands.back().sdf) {
             m_commands.emplace_back(0, std::addressof(texture));
          }
       }
    }
 
-   void push(vertex_t v0, vertex_t v1, vertex_t v2)
+   // note: distance field draws batch as long as texture and style match
+   void push_sdf(const texture_t &texture, const sdf_style_t &style)
+   {
+      assert(texture.valid());
+      if (m_commands.empty() ||
+          m_commands.back().texture != std::addressof(texture) ||
+          !m_commands.back().sdf ||
+          !(m_commands.back().style == style))
+      {
+         m_commands.emplace_back(0, std::addressof(texture), true, style);
+      }
+   }
+
+   GLuint compile_shader(const GLenum type, const char *source)
+   {
+      GLuint shader = glCreateShader(type);
+      glShaderSource(shader, 1, &source, nullptr);
+      glCompileShader(shader);
+
+      GLint status = 0;
+      glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+      if (status == 0) {
+         glDeleteShader(shader);
+         return 0;
+      }
+
+      return shader;
+   }
+
+   // note: without a program distance field text falls back to an alpha test
+   void create_sdf_program()
+   {
+      GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, kSdfVertexShader);
+      GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, kSdfFragmentShader);
+      if (vertex_shader != 0 && fragment_shader != 0) {
+         GLuint program = glCreateProgram();
+         glAttachShader(program, vertex_shader);
+         glAttachShader(program, fragment_shader);
+         glLinkProgram(program);
+
+         GLint status = 0;
+         glGetProgramiv(program, GL_LINK_STATUS, &status);
+         if (status != 0) {
+            m_sdf_program = program;
+            m_sdf_uniforms.texture = glGetUniformLocation(program, "u_texture");
+            m_sdf_uniforms.outline_color = glGetUniformLocation(program, "u_outline_color");
+            m_sdf_uniforms.outline_width = glGetUniformLocation(program, "u_outline_width");
+            m_sdf_uniforms.shadow_color = glGetUniformLocation(program, "u_shadow_color");
+            m_sdf_uniforms.shadow_offset = glGetUniformLocation(program, "u_shadow_offset");
+            m_sdf_uniforms.shadow_softness = glGetUniformLocation(program, "u_shadow_softness");
+         }
+         else {
+            glDeleteProgram(program);
+         }
+      }
+
+      if (vertex_shader != 0) {
+         glDeleteShader(vertex_shader);
+      }
+
+      if (fragment_shader != 0) {
+         glDeleteShader(fragment_shader);
+      }
+   }
+
+   void apply_sdf(const command_t &command)
+   {
+      if (m_sdf_program == 0) {
+         if (command.sdf) {
+            glEnable(GL_ALPHA_TEST);
+            glAlphaFunc(GL_GEQUAL, 0.5f);
+         }
+         else {
+            glDisable(GL_ALPHA_TEST);
+         }
+
+         return;
+      }
+
+      if (!command.sdf) {
+         glUseProgram(0);
+         return;
+      }
+
+      const sdf_style_t &style = command.style;
+      const float outline_alpha = style.outline_width > 0.0f ? style.outline_color.a / 255.0f : 0.0f;
+
+      glUseProgram(m_sdf_program);
+      glUniform1i(m_sdf_uniforms.texture, 0);
+      glUniform4f(m_sdf_uniforms.outline_color,
+                  style.outline_color.r / 255.0f,
+                  style.outline_color.g / 255.0f,
+                  style.outline_color.b / 255.0f,
+                  outline_alpha);
+      glUniform1f(m_sdf_uniforms.outline_width, style.outline_width);
+      glUniform4f(m_sdf_uniforms.shadow_color,
+                  style.shadow_color.r / 255.0f,
+                  style.shadow_color.g / 255.0f,
+                  style.shadow_color.b / 255.0f,
+                  style.shadow_color.a / 255.0f);
+      glUniform2f(m_sdf_uniforms.shadow_offset,
+                  style.shadow_offset.x / float(command.texture->m_size.x),
+                  style.shadow_offset.y / float(command.texture->m_size.y));
+      glUniform1f(m_sdf_uniforms.shadow_softness, style.shadow_softness);
+   }
+
+   uint32_t push_vertex(const vertex_t &v)
+   {
+      m_vertices.push_back(v);
+      return uint32_t(m_vertices.size() - 1);
+   }
+
+   void push_triangle(uint32_t i0, uint32_t i1, uint32_t i2)
    {
       m_commands.back().count += 3;
+      m_indices.insert(m_indices.end(), { i0, i1, i2 });
+   }
+
+   void push_quad(uint32_t i0, uint32_t i1, uint32_t i2, uint32_t i3)
+   {
+      m_commands.back().count += 6;
+      m_indices.insert(m_indices.end(), { i0, i1, i2, i2, i3, i0 });
+   }
+
+   void push(vertex_t v0, vertex_t v1, vertex_t v2)
+   {
+      const uint32_t base = uint32_t(m_vertices.size());
       m_vertices.insert(m_vertices.end(), { v0, v1, v2 });
+      push_triangle(base, base + 1, base + 2);
    }
 
    void push(vertex_t v0, vertex_t v1, vertex_t v2, vertex_t v3)
    {
-      m_commands.back().count += 6;
-      m_vertices.insert(m_vertices.end(), { v0, v1, v2, v2, v3, v0 });
+      const uint32_t base = uint32_t(m_vertices.size());
+      m_vertices.insert(m_vertices.end(), { v0, v1, v2, v3 });
+      push_quad(base, base + 1, base + 2, base + 3);
    }
 
    texture_t m_texture;
    color_t m_clear_color;
    vector2_t m_projection;
+   bool m_antialiasing = true;
+   float m_pixel_size = 1.0f;
    vertex_buffer_t m_vertex_buffer;
+   vertex_buffer_t m_index_buffer;
    std::vector<vertex_t> m_vertices;
+   std::vector<uint32_t> m_indices;
    std::vector<command_t> m_commands;
+   std::vector<vector2_t> m_transformed;
+   std::vector<vector2_t> m_strip;
+   std::vector<vector2_t> m_offsets;
+   std::vector<uint32_t> m_fan;
+   triangulation_cache_t m_triangulations;
+   GLuint m_sdf_program = 0;
+   struct {
+      GLint texture = -1;
+      GLint outline_color = -1;
+      GLint outline_width = -1;
+      GLint shadow_color = -1;
+      GLint shadow_offset = -1;
+      GLint shadow_softness = -1;
+   } m_sdf_uniforms;
+};
+
+struct gl_frame_capture_t final : frame_capture_t {
+   static constexpr int    pixel_buffer_count = 3;
+   static constexpr size_t max_pending_jobs = 8;
+
+   struct pixel_buffer_t {
+      GLuint      id = 0;
+      bool        record = false;
+      std::string screenshot_path;
+   };
+
+   struct job_t {
+      point_t              size;
+      FILE                *stream = nullptr;
+      // note: how a finish job closes stream, the next recording may already have replaced m_pipe
+      bool                 pipe = false;
+      bool                 finish = false;
+      std::string          screenshot_path;
+      std::vector<uint8_t> pixels;
+   };
+
+   gl_frame_capture_t()
+   {
+      m_worker = std::thread([this] { worker(); });
+   }
+
+   ~gl_frame_capture_t()
+   {
+      drain_buffers();
+      stop_recording();
+
+      {
+         std::scoped_lock lock(m_mutex);
+         m_running = false;
+      }
+      m_condition.notify_one();
+      m_worker.join();
+
+      destroy_buffers();
+   }
+
+   bool active() const
+   {
+      return m_recording || !m_screenshot_path.empty() || m_in_flight > 0;
+   }
+
+   bool recording() const
+   {
+      return m_recording;
+   }
+
+   void screenshot(const char *path)
+   {
+      m_screenshot_path = path;
+   }
+
+   bool start_recording(const char *path)
+   {
+      stop_recording();
+
+      // note: a leading '|' pipes raw frames into a command, e.g. an encoder
+      m_pipe = path[0] == '|';
+      m_stream = nullptr;
+      if (m_pipe) {
+         m_stream = _popen(path + 1, "wb");
+      }
+      else {
+         fopen_s(&m_stream, path, "wb");
+      }
+
+      m_recording = m_stream != nullptr;
+      m_recorded_count = 0;
+      return m_recording;
+   }
+
+   void stop_recording()
+   {
+      if (!m_recording) {
+         return;
+      }
+
+      // note: frames still in flight are dropped, we never wait on the gpu here
+      for (auto &buffer : m_buffers) {
+         if (buffer.record) {
+            buffer.record = false;
+            m_in_flight -= buffer.screenshot_path.empty() ? 1 : 0;
+         }
+      }
+
+      job_t job;
+      job.stream = m_stream;
+      job.pipe = m_pipe;
+      job.finish = true;
+      submit(std::move(job));
+
+      m_recording = false;
+      m_stream = nullptr;
+   }
+
+   void capture_frame()
+   {
+      if (!active()) {
+         return;
+      }
+
+      const timespan_t start = timespan_t::time_since_start();
+
+      GLint viewport[4] = {};
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      const point_t size = { viewport[2], viewport[3] };
+      if (size.x != m_size.x || size.y != m_size.y) {
+         // note: raw frames carry no size, one stream holds frames of one size only. what
+         //       was read back at the old size is written out and the recording ends here.
+         if (m_recording && m_recorded_count > 0) {
+            drain_buffers();
+            stop_recording();
+         }
+
+         create_buffers(size);
+      }
+
+      pixel_buffer_t &buffer = m_buffers[m_frame_index];
+      m_frame_index = (m_frame_index + 1) % pixel_buffer_count;
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+
+      // note: this buffer was queued pixel_buffer_count frames ago, so the 
+      //       transfer has completed and mapping it does not stall.
+      if (buffer.record || !buffer.screenshot_path.empty()) {
+         retire(buffer);
+      }
+
+      if (m_recording || !m_screenshot_path.empty()) {
+         glReadPixels(0, 0, size.x, size.y, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+         buffer.record = m_recording;
+         buffer.screenshot_path = std::move(m_screenshot_path);
+         m_recorded_count += m_recording ? 1 : 0;
+         m_screenshot_path.clear();
+         m_in_flight++;
+      }
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+      const timespan_t cost = timespan_t::time_since_start() - start;
+      m_last_cost = cost;
+      m_average_cost = timespan_t{ (m_average_cost.elapsed_microseconds() * 15 + cost.elapsed_microseconds()) / 16 };
+   }
+
+   stats_t stats() const
+   {
+      stats_t result;
+      result.size = m_size;
+      result.frames_captured = m_frames_captured.load(std::memory_order_relaxed);
+      result.frames_dropped = m_frames_dropped;
+      result.frames_pending = m_frames_pending.load(std::memory_order_relaxed);
+      result.last_cost = m_last_cost;
+      result.average_cost = m_average_cost;
+      return result;
+   }
+
+   void create_buffers(const point_t &size)
+   {
+      drain_buffers();
+      destroy_buffers();
+
+      m_size = size;
+      for (auto &buffer : m_buffers) {
+         glGenBuffers(1, &buffer.id);
+         glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+         glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size.x) * size.y * 4, nullptr, GL_STREAM_READ);
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   }
+
+   // note: maps every buffer still holding a frame, stalls on the gpu but keeps
+   //       a requested screenshot when the viewport changes size under it.
+   void drain_buffers()
+   {
+      for (int index = 0; index < pixel_buffer_count; index++) {
+         pixel_buffer_t &buffer = m_buffers[(m_frame_index + index) % pixel_buffer_count];
+         if (buffer.record || !buffer.screenshot_path.empty()) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+            retire(buffer);
+         }
+      }
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   }
+
+   void destroy_buffers()
+   {
+      for (auto &buffer : m_buffers) {
+         if (buffer.id != 0) {
+            glDeleteBuffers(1, &buffer.id);
+         }
+
+         buffer = {};
+      }
+
+      m_in_flight = 0;
+      m_size = {};
+   }
+
+   void retire(pixel_buffer_t &buffer)
+   {
+      m_in_flight--;
+
+      job_t job;
+      job.size = m_size;
+      job.stream = buffer.record ? m_stream : nullptr;
+      job.screenshot_path = std::move(buffer.screenshot_path);
+      buffer.record = false;
+      buffer.screenshot_path.clear();
+
+      {
+         std::scoped_lock lock(m_mutex);
+         if (m_jobs.size() >= max_pending_jobs) {
+            m_frames_dropped++;
+            return;
+         }
+
+         if (!m_pixels_pool.empty()) {
+            job.pixels = std::move(m_pixels_pool.back());
+            m_pixels_pool.pop_back();
+         }
+      }
+
+      const void *data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+      if (data == nullptr) {
+         m_frames_dropped++;
+         return;
+      }
+
+      job.pixels.resize(size_t(m_size.x) * m_size.y * 4);
+      std::memcpy(job.pixels.data(), data, job.pixels.size());
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+      submit(std::move(job));
+   }
+
+   void submit(job_t &&job)
+   {
+      {
+         std::scoped_lock lock(m_mutex);
+         m_jobs.push_back(std::move(job));
+         m_frames_pending.store(uint32_t(m_jobs.size()), std::memory_order_relaxed);
+      }
+      m_condition.notify_one();
+   }
+
+   void worker()
+   {
+      for (;;) {
+         job_t job;
+         {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return !m_jobs.empty() || !m_running; });
+            if (m_jobs.empty()) {
+               return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_frames_pending.store(uint32_t(m_jobs.size()), std::memory_order_relaxed);
+         }
+
+         encode(job);
+
+         {
+            std::scoped_lock lock(m_mutex);
+            m_pixels_pool.push_back(std::move(job.pixels));
+         }
+      }
+   }
+
+   void encode(job_t &job)
+   {
+      if (job.finish) {
+         if (job.stream != nullptr) {
+            job.pipe ? _pclose(job.stream) : fclose(job.stream);
+         }
+         return;
+      }
+
+      // note: readback is bottom-up bgra, flip and swizzle to top-down rgba
+      const size_t pitch = size_t(job.size.x) * 4;
+      for (int row = 0; row < (job.size.y + 1) / 2; row++) {
+         uint8_t *top = job.pixels.data() + pitch * row;
+         uint8_t *bottom = job.pixels.data() + pitch * (job.size.y - 1 - row);
+         for (size_t index = 0; index < pitch; index += 4) {
+            const uint8_t t[4] = { top[index + 2], top[index + 1], top[index + 0], 0xff };
+            const uint8_t b[4] = { bottom[index + 2], bottom[index + 1], bottom[index + 0], 0xff };
+            std::memcpy(top + index, b, 4);
+            std::memcpy(bottom + index, t, 4);
+         }
+      }
+
+      if (job.stream != nullptr) {
+         fwrite(job.pixels.data(), 1, job.pixels.size(), job.stream);
+      }
+
+      if (!job.screenshot_path.empty()) {
+         stbi_write_png(job.screenshot_path.c_str(), job.size.x, job.size.y, 4, job.pixels.data(), int(pitch));
+      }
+
+      m_frames_captured.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   point_t               m_size;
+   int                   m_frame_index = 0;
+   int                   m_in_flight = 0;
+   pixel_buffer_t        m_buffers[pixel_buffer_count];
+   bool                  m_recording = false;
+   uint32_t              m_recorded_count = 0;
+   bool                  m_pipe = false;
+   FILE                 *m_stream = nullptr;
+   std::string           m_screenshot_path;
+   uint32_t              m_frames_dropped = 0;
+   timespan_t            m_last_cost;
+   timespan_t            m_average_cost;
+
+   bool                  m_running = true;
+   std::thread           m_worker;
+   std::mutex            m_mutex;
+   std::condition_variable m_condition;
+   std::deque<job_t>     m_jobs;
+   std::vector<std::vector<uint8_t>> m_pixels_pool;
+   std::atomic<uint32_t> m_frames_captured = 0;
+   std::atomic<uint32_t> m_frames_pending = 0;
 };
 
 bool texture_t::valid() const
@@ -1259,6 +1989,20 @@ bool texture_t::create_from_memory(const std::vector<uint8_t> &content,
    return valid();
 }
 
+bool texture_t::update(const rectangle_t &area, const void *data, const int pitch)
+{
+   if (!valid() || area.w <= 0 || area.h <= 0) {
+      return false;
+   }
+
+   glBindTexture(GL_TEXTURE_2D, m_id);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch);
+   glTexSubImage2D(GL_TEXTURE_2D, 0, area.x, area.y, area.w, area.h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+   return glGetError() == GL_NO_ERROR;
+}
+
 void texture_t::destroy()
 {
    if (valid()) {
@@ -1540,8 +2284,6 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance,
          WGL_COLOR_BITS_ARB    , 32               ,
          WGL_DEPTH_BITS_ARB    , 24               ,
          WGL_STENCIL_BITS_ARB  , 8                ,
-         WGL_SAMPLE_BUFFERS_ARB, GL_TRUE          ,
-         WGL_SAMPLES_ARB       , 4                ,
          0
       };
       UINT num_pixel_formats = 0;
@@ -1596,12 +2338,22 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance,
    window_t window(hWnd);
    input_context_t input;
    gl_graphics_t graphics;
-   audio_device_t audio_device;
+   gl_frame_capture_t capture;
+   xaudio2_sink_t audio_sink;
+   audio_device_t audio_device(audio_sink);
+   if (!audio_device.start()) {
+      win_fatal_error("Could not initialize XAudio2!");
+   }
+
+   // note: declared after the audio device so workers are joined before it goes away
+   thread_pool_t thread_pool;
 
    runtime_t runtime;
    runtime.m_window = &window;
    runtime.m_input = &input;
    runtime.m_graphics = &graphics;
+   runtime.m_capture = &capture;
+   runtime.m_thread_pool = &thread_pool;
 
    SetWindowLongPtrA(hWnd, GWLP_USERDATA, (LONG_PTR)&input);
    ShowWindow(hWnd, nCmdShow);
@@ -1618,13 +2370,10 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance,
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-#undef STB_VORBIS_HEADER_ONLY
-#define STB_VORBIS_NO_PUSHDATA_API
+#define STB_IMAGE_WRITE_IMPLEMENTATION
 #pragma warning(push)
 #pragma warning(disable: 4244)
-#pragma warning(disable: 4245)
 #pragma warning(disable: 4456)
-#pragma warning(disable: 4457)
-#pragma warning(disable: 4701)
-#include <stb_vorbis.h>
+#pragma warning(disable: 4996)
+#include <stb_image_write.h>
 #pragma warning(pop)
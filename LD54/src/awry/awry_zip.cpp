@@ -0,0 +1,490 @@
+// awry_zip.cpp
+
+#include "awry.h"
+#include "awry_inflate.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+#pragma pack(push, 1)
+struct zip_local_header_t {
+   uint32_t signature;
+   uint16_t version;
+   uint16_t bit_flags;
+   uint16_t method;
+   uint16_t last_mod_time;
+   uint16_t last_mod_date;
+   uint32_t crc32;
+   uint32_t size_compressed;
+   uint32_t size_uncompressed;
+   uint16_t filename_length;
+   uint16_t extra_field_length;
+};
+
+// note: central directory file header
+struct zip_cdir_file_header_t {
+   uint32_t signature;
+   uint16_t version;
+   uint16_t minimum_version;
+   uint16_t bit_flags;
+   uint16_t method;
+   uint16_t last_mod_time;
+   uint16_t last_mod_date;
+   uint32_t crc32;
+   uint32_t size_compressed;
+   uint32_t size_uncompressed;
+   uint16_t filename_length;
+   uint16_t extra_field_length;
+   uint16_t comment_length;
+   uint16_t disk_num_file_start;
+   uint16_t internal_file_attribs;
+   uint32_t external_file_attribs;
+   uint32_t local_header_offset;
+};
+
+// note: end of central directory record
+struct zip_eocdir_record_t {
+   uint32_t signature;
+   uint16_t disk_count;
+   uint16_t disk_cdir_start;
+   uint16_t local_cdir_count;
+   uint16_t cdir_record_count;
+   uint32_t cdir_size;
+   uint32_t cdir_offset;
+   uint16_t comment_length;
+};
+#pragma pack(pop)
+
+static constexpr uint32_t kZipCentralDirSignature = 0x02014B50u;
+static constexpr uint32_t kZipLocalSignature = 0x04034B50u;
+static constexpr uint32_t kZipEocdSignature = 0x06054B50u;
+static constexpr uint16_t kZipMethodStored = 0;
+static constexpr uint16_t kZipMethodDeflate = 8;
+
+static uint64_t
+fnv1a64(const char *str)
+{
+   uint64_t h = 14695981039346656037ull;
+   while (*str != '\0') {
+      h ^= uint64_t(str[0]);
+      h *= 1099511628211;
+      str++;
+   }
+   return h;
+}
+
+zip_archive_t::zip_archive_t()
+{
+}
+
+zip_archive_t::~zip_archive_t()
+{
+   close();
+}
+
+bool zip_archive_t::valid() const
+{
+   return m_handle != nullptr;
+}
+
+bool zip_archive_t::open(const std::string_view &path)
+{
+   uint64_t size = 0;
+   m_handle = open_file(path, size);
+   if (m_handle == nullptr) {
+      return false;
+   }
+
+   zip_eocdir_record_t eocd = {};
+   if (size < sizeof(eocd) ||
+       read_file(m_handle, size - sizeof(eocd), &eocd, sizeof(eocd)) != sizeof(eocd) ||
+       eocd.signature != kZipEocdSignature) {
+      close();
+      return false;
+   }
+
+   uint64_t offset = eocd.cdir_offset;
+   for (uint32_t index = 0; index < eocd.cdir_record_count; index++) {
+      zip_cdir_file_header_t cdir = {};
+      if (read_file(m_handle, offset, &cdir, sizeof(cdir)) != sizeof(cdir) || cdir.signature != kZipCentralDirSignature) {
+         close();
+         return false;
+      }
+
+      bool might_be_ascii = (cdir.internal_file_attribs & 0x1);
+      std::string name(cdir.filename_length, '\0');
+      read_file(m_handle, offset + sizeof(cdir), name.data(), uint32_t(name.size()));
+
+      // note: the record's extra field and comment sit between it and the next one
+      offset += sizeof(cdir) + cdir.filename_length + cdir.extra_field_length + cdir.comment_length;
+
+      zip_entry_t entry = {};
+      entry.name = name;
+      entry.hash = fnv1a64(name.c_str());
+      entry.local_header_offset = cdir.local_header_offset;
+      entry.size_compressed = cdir.size_compressed + (might_be_ascii ? 1 : 0);
+      entry.size_uncompressed = cdir.size_uncompressed;
+      entry.method = cdir.method;
+      m_entries.push_back(entry);
+   }
+
+   return valid();
+}
+
+void zip_archive_t::close()
+{
+   if (valid()) {
+      close_file(m_handle);
+   }
+
+   m_handle = nullptr;
+}
+
+bool zip_archive_t::contains(const std::string_view &path) const
+{
+   return find(path) != nullptr;
+}
+
+const zip_archive_t::zip_entry_t *zip_archive_t::find(const std::string_view &path) const
+{
+   if (!valid()) {
+      return nullptr;
+   }
+
+   const uint64_t hash = fnv1a64(path.data());
+   for (auto &entry : m_entries) {
+      if (entry.hash == hash) {
+         return &entry;
+      }
+   }
+
+   return nullptr;
+}
+
+bool zip_archive_t::load_content(const std::string_view &path, std::vector<uint8_t> &content)
+{
+   if (!valid()) {
+      return false;
+   }
+
+   const uint64_t hash = fnv1a64(path.data());
+   for (auto &entry : m_entries) {
+      if (entry.hash == hash) {
+         content.resize(entry.size_uncompressed);
+         return load_content(path, std::span<uint8_t>(content));
+      }
+   }
+
+   return true;
+}
+
+bool zip_archive_t::load_content(const std::string_view &path, std::span<uint8_t> content)
+{
+   // note: a read of the whole entry inflates straight into content
+   zip_stream_t stream;
+   if (!stream.open(*this, path) || stream.size() != content.size()) {
+      return false;
+   }
+
+   return stream.read(content) == content.size();
+}
+
+bool zip_archive_t::load_many(thread_pool_t &pool, std::span<const std::string_view> paths, const loaded_t &loaded) const
+{
+   struct result_t {
+      size_t index = 0;
+      bool success = false;
+      std::vector<uint8_t> content;
+   };
+
+   // note: shared with the tasks, the last one may still be notifying after the final result is taken
+   struct batch_t {
+      std::mutex mutex;
+      std::condition_variable finished;
+      std::deque<result_t> results;
+   };
+
+   // note: largest first, so a big entry does not start last and leave the other workers idle
+   std::vector<size_t> order(paths.size());
+   std::vector<uint64_t> sizes(paths.size());
+   for (size_t index = 0; index < paths.size(); index++) {
+      const zip_entry_t *entry = find(paths[index]);
+      order[index] = index;
+      sizes[index] = entry != nullptr ? entry->size_uncompressed : 0;
+   }
+
+   std::stable_sort(order.begin(), order.end(), [&sizes](const size_t lhs, const size_t rhs) {
+      return sizes[lhs] > sizes[rhs];
+   });
+
+   auto batch = std::make_shared<batch_t>();
+   for (const size_t index : order) {
+      pool.submit([this, batch, index, path = paths[index]] {
+         result_t result;
+         result.index = index;
+
+         zip_stream_t stream;
+         if (stream.open(*this, path)) {
+            result.content.resize(size_t(stream.size()));
+            result.success = stream.read(result.content) == result.content.size();
+         }
+
+         if (!result.success) {
+            result.content.clear();
+         }
+
+         {
+            std::lock_guard lock(batch->mutex);
+            batch->results.push_back(std::move(result));
+         }
+
+         batch->finished.notify_one();
+      });
+   }
+
+   bool success = true;
+   for (size_t count = 0; count < paths.size(); count++) {
+      result_t result;
+      {
+         std::unique_lock lock(batch->mutex);
+         batch->finished.wait(lock, [&batch] { return !batch->results.empty(); });
+         result = std::move(batch->results.front());
+         batch->results.pop_front();
+      }
+
+      success &= result.success;
+      loaded(result.index, result.success, result.content);
+   }
+
+   return success;
+}
+
+zip_stream_t::zip_stream_t()
+{
+}
+
+zip_stream_t::~zip_stream_t()
+{
+   close();
+}
+
+bool zip_stream_t::valid() const
+{
+   return m_handle != nullptr;
+}
+
+bool zip_stream_t::open(const zip_archive_t &archive, const std::string_view &path)
+{
+   close();
+
+   const zip_archive_t::zip_entry_t *entry = archive.find(path);
+   if (entry == nullptr || (entry->method != kZipMethodStored && entry->method != kZipMethodDeflate)) {
+      return false;
+   }
+
+   zip_local_header_t local = {};
+   if (zip_archive_t::read_file(archive.m_handle, entry->local_header_offset, &local, sizeof(local)) != sizeof(local) ||
+       local.signature != kZipLocalSignature) {
+      return false;
+   }
+
+   m_handle = archive.m_handle;
+   m_data_offset = entry->local_header_offset + sizeof(local) + local.filename_length + local.extra_field_length;
+   m_size_compressed = entry->size_compressed;
+   m_size = entry->size_uncompressed;
+   m_stored = entry->method == kZipMethodStored;
+   if (!m_stored) {
+      // note: default initialized, make_unique would clear the tables first
+      m_inflater.reset(new inflate_t);
+      m_input.resize(input_chunk_size);
+   }
+
+   return true;
+}
+
+void zip_stream_t::close()
+{
+   m_handle = nullptr;
+   m_data_offset = 0;
+   m_size_compressed = 0;
+   m_compressed_read = 0;
+   m_size = 0;
+   m_position = 0;
+   m_stored = false;
+   m_finished = false;
+   m_failed = false;
+   m_inflater.reset();
+   m_input.clear();
+   m_input_begin = 0;
+   m_input_end = 0;
+   m_window.clear();
+   m_window_read = 0;
+   m_window_write = 0;
+}
+
+size_t zip_stream_t::read(std::span<uint8_t> buffer)
+{
+   if (!valid() || m_failed) {
+      return 0;
+   }
+
+   const size_t count = size_t(std::min<uint64_t>(buffer.size(), m_size - m_position));
+   uint8_t *output = buffer.data();
+   uint8_t *output_end = output + count;
+   if (m_stored) {
+      while (output < output_end) {
+         const uint32_t chunk = uint32_t(std::min<size_t>(output_end - output, 1u << 30));
+         const uint32_t result = zip_archive_t::read_file(m_handle, m_data_offset + m_position, output, chunk);
+         if (result == 0) {
+            m_failed = true;
+            break;
+         }
+
+         output += result;
+         m_position += result;
+      }
+
+      return size_t(output - buffer.data());
+   }
+
+   if (m_position == 0 && count == m_size) {
+      // note: the whole entry at once, the buffer is its own history
+      decode(output, output, output_end);
+      m_failed |= output != output_end;
+      m_position = uint64_t(output - buffer.data());
+      return size_t(m_position);
+   }
+
+   while (output < output_end) {
+      if (m_window_read == m_window_write && !fill_window()) {
+         break;
+      }
+
+      const size_t chunk = std::min<size_t>(output_end - output, m_window_write - m_window_read);
+      std::memcpy(output, m_window.data() + m_window_read, chunk);
+      output += chunk;
+      m_window_read += chunk;
+      m_position += chunk;
+   }
+
+   return size_t(output - buffer.data());
+}
+
+bool zip_stream_t::skip(uint64_t count)
+{
+   if (!valid() || m_failed || count > m_size - m_position) {
+      return false;
+   }
+
+   if (m_stored) {
+      m_position += count;
+      return true;
+   }
+
+   // note: skipped bytes are still inflated, later matches may reach back into them
+   while (count > 0) {
+      if (m_window_read == m_window_write && !fill_window()) {
+         return false;
+      }
+
+      const size_t chunk = size_t(std::min<uint64_t>(count, m_window_write - m_window_read));
+      m_window_read += chunk;
+      m_position += chunk;
+      count -= chunk;
+   }
+
+   return true;
+}
+
+bool zip_stream_t::eof() const
+{
+   return m_position == m_size || m_failed;
+}
+
+bool zip_stream_t::failed() const
+{
+   return m_failed;
+}
+
+uint64_t zip_stream_t::size() const
+{
+   return m_size;
+}
+
+uint64_t zip_stream_t::position() const
+{
+   return m_position;
+}
+
+bool zip_stream_t::fill_input()
+{
+   const size_t remaining = m_input_end - m_input_begin;
+   std::memmove(m_input.data(), m_input.data() + m_input_begin, remaining);
+   m_input_begin = 0;
+   m_input_end = remaining;
+
+   const uint32_t chunk = uint32_t(std::min<uint64_t>(m_input.size() - m_input_end, m_size_compressed - m_compressed_read));
+   if (chunk == 0) {
+      return false;
+   }
+
+   const uint32_t result = zip_archive_t::read_file(m_handle, m_data_offset + m_compressed_read, m_input.data() + m_input_end, chunk);
+   if (result == 0) {
+      return false;
+   }
+
+   m_input_end += result;
+   m_compressed_read += result;
+
+   return true;
+}
+
+bool zip_stream_t::fill_window()
+{
+   if (m_window.empty()) {
+      m_window.resize(window_size);
+   }
+
+   if (m_window_write == m_window.size()) {
+      // note: keep the last 32 kb, the next matches may reach that far back
+      const size_t history = inflate_t::max_distance;
+      std::memmove(m_window.data(), m_window.data() + m_window_write - history, history);
+      m_window_read = history;
+      m_window_write = history;
+   }
+
+   uint8_t *output = m_window.data() + m_window_write;
+   decode(m_window.data(), output, m_window.data() + m_window.size());
+   const size_t written = size_t(output - (m_window.data() + m_window_write));
+   m_window_write += written;
+   m_failed |= written == 0;
+
+   return written > 0;
+}
+
+void zip_stream_t::decode(const uint8_t *window, uint8_t *&output, uint8_t *output_end)
+{
+   while (output < output_end && !m_finished && !m_failed) {
+      const uint8_t *input = m_input.data() + m_input_begin;
+      const bool input_final = m_compressed_read == m_size_compressed;
+      const inflate_t::status_t status = m_inflater->inflate(input,
+                                                             m_input.data() + m_input_end,
+                                                             input_final,
+                                                             window,
+                                                             output,
+                                                             output_end);
+      m_input_begin = size_t(input - m_input.data());
+
+      if (status == inflate_t::status_t::done) {
+         m_finished = true;
+      }
+      else if (status == inflate_t::status_t::error) {
+         m_failed = true;
+      }
+      else if (status == inflate_t::status_t::need_input) {
+         m_failed = input_final || !fill_input();
+      }
+   }
+}
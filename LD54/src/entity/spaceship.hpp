@@ -186,6 +186,13 @@ struct spaceship_t {
    static constexpr float propulsion_base_velocity = propulsion_thrust / drag_coefficient;
    static constexpr float propulsion_maximum_velocity = (propulsion_thrust * propulsion_boost_factor) / drag_coefficient;
 
+   // note: right wing, left wing and body, in local space
+   static constexpr vector2_t hull_outlines[3][3] = {
+      { {  0.0f, 0.0f }, { -8.0f,  9.0f }, { -8.0f,  1.0f } },
+      { {  0.0f, 0.0f }, { -8.0f, -1.0f }, { -8.0f, -9.0f } },
+      { { 10.0f, 0.0f }, { -5.0f,  5.0f }, { -5.0f, -5.0f } },
+   };
+
    spaceship_t() = default;
 
    void initialize(const vector2_t &position, const vector2_t &direction = { 1.0f, 0.0f })
@@ -304,35 +311,23 @@ struct spaceship_t {
       const vector2_t normal = m_direction;
       const vector2_t tangent = normal.perp();
 
-      // body
-      const vector2_t b0 = center + normal * 10.0f;
-      const vector2_t b1 = center - normal * 5.0f + tangent * 5.0f;
-      const vector2_t b2 = center - normal * 5.0f - tangent * 5.0f;
-
-      // right wing
-      const vector2_t r0 = center;
-      const vector2_t r1 = b1 - normal * 3.0f + tangent * 4.0f;
-      const vector2_t r2 = b1 - normal * 3.0f - tangent * 4.0f;
-       
-      // left wing
-      const vector2_t l0 = center;
-      const vector2_t l1 = b2 - normal * 3.0f + tangent * 4.0f;
-      const vector2_t l2 = b2 - normal * 3.0f - tangent * 4.0f;
-
-      const vector2_t vertices[] =
-      {
-         r0, r1, r2,
-         l0, l1, l2,
-         b0, b1, b2,
+      // note: local space has x along the heading and y along its perpendicular,
+      //       the outlines never change so their triangulation stays cached.
+      const matrix3_t transform = {
+         { normal.x, tangent.x, center.x },
+         { normal.y, tangent.y, center.y },
+         { 0.0f, 0.0f, 1.0f },
       };
 
       m_spawnicator.render(graphics);
       m_spacetrail.render(graphics, m_position, m_direction * 5.0f);
 
-      graphics.draw_triangles_filled(vertices, spaceship_fill_color);
-      for (int index = 0; index < 3; index++) {
-         auto span = std::span{ vertices + index * 3, 3 };
-         graphics.draw_line_strip(span, 2.0f, spaceship_outline_color);
+      for (const auto &outline : hull_outlines) {
+         graphics.draw_polygon_filled(outline, transform, spaceship_fill_color);
+      }
+
+      for (const auto &outline : hull_outlines) {
+         graphics.draw_polygon_outlined(outline, 2.0f, transform, spaceship_outline_color);
       }
 
       //m_gunturret.render(graphics);
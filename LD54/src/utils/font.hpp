@@ -2,15 +2,46 @@
 
 #include <algorithm>
 
+struct bitmap_font_t;
+
+// note: laid out glyph quads relative to the text origin,
+//       rendering a mesh only translates and submits them.
+struct text_mesh_t {
+   struct quad_t {
+      rectangle_t m_source;
+      rectangle_t m_dest;
+      uint32_t    m_offset = 0;
+      uint32_t    m_end = 0;
+      point_t     m_pen;
+   };
+
+   void clear()
+   {
+      m_font = nullptr;
+      m_font_version = 0;
+      m_scale = 0;
+      m_text.clear();
+      m_quads.clear();
+   }
+
+   const bitmap_font_t *m_font = nullptr;
+   uint32_t             m_font_version = 0;
+   int                  m_scale = 0;
+   std::string          m_text;
+   std::vector<quad_t>  m_quads;
+};
+
 struct bitmap_font_t {
-   static void construct_monospaced_font(bitmap_font_t &font, 
-                                         const point_t &character_count, 
-                                         const point_t &character_size, 
+   static void construct_monospaced_font(bitmap_font_t &font,
+                                         const point_t &character_count,
+                                         const point_t &character_size,
                                          const int first_codepoint = 32);
 
    static constexpr uint32_t invalid_character_codepoint = '?';
    static constexpr uint32_t newline_character_codepoint = '\n';
    static constexpr uint32_t tab_character_codepoint = '\t';
+   static constexpr uint32_t replacement_character_codepoint = 0xfffd;
+   static constexpr uint32_t dense_codepoint_count = 256;
 
    struct glyph_t {
       uint32_t    m_codepoint = 0;
@@ -18,17 +49,55 @@ struct bitmap_font_t {
       rectangle_t m_source;
    };
 
+   // note: decodes one codepoint and advances, malformed sequences yield U+FFFD
+   static uint32_t decode_utf8(const char *&it, const char *end)
+   {
+      const uint8_t lead = uint8_t(*it++);
+      if (lead < 0x80) {
+         return lead;
+      }
+
+      int length = 0;
+      uint32_t codepoint = 0;
+      if ((lead & 0xe0) == 0xc0) {
+         length = 1;
+         codepoint = lead & 0x1f;
+      }
+      else if ((lead & 0xf0) == 0xe0) {
+         length = 2;
+         codepoint = lead & 0x0f;
+      }
+      else if ((lead & 0xf8) == 0xf0) {
+         length = 3;
+         codepoint = lead & 0x07;
+      }
+      else {
+         return replacement_character_codepoint;
+      }
+
+      for (int index = 0; index < length; index++) {
+         if (it == end || (uint8_t(*it) & 0xc0) != 0x80) {
+            return replacement_character_codepoint;
+         }
+
+         codepoint = (codepoint << 6) | (uint8_t(*it++) & 0x3f);
+      }
+
+      return codepoint;
+   }
+
    bitmap_font_t() = default;
    bitmap_font_t(texture_t &texture)
       : m_texture(&texture)
    {
    }
 
-   void render(graphics_t &graphics, const point_t &position, const std::string &text, const color_t &color, const int scale = 1)
+   void render(graphics_t &graphics, const point_t &position, const std::string_view &text, const color_t &color, const int scale = 1)
    {
       point_t character_position = position;
-      for (auto &ch : text) {
-         uint32_t character_codepoint = static_cast<uint32_t>(uint8_t(ch));
+      const char *end = text.data() + text.size();
+      for (const char *it = text.data(); it != end;) {
+         const uint32_t character_codepoint = decode_utf8(it, end);
 
          if (character_codepoint == newline_character_codepoint) {
             character_position.x = position.x;
@@ -36,43 +105,103 @@ struct bitmap_font_t {
             continue;
          }
 
-         if (character_codepoint < m_first_valid_character_codepoint || 
-             character_codepoint > m_last_valid_character_codepoint)
-         {
-            character_codepoint = invalid_character_codepoint;
-         }
-
-         glyph_t glyph;
-         if (contains(character_codepoint, glyph)) {
-            rectangle_t src = glyph.m_source;
+         if (const glyph_t *glyph = find_or_invalid(character_codepoint)) {
+            const rectangle_t &src = glyph->m_source;
             rectangle_t dest{ character_position, src.width_height() * scale };
             graphics.draw(*m_texture, src, dest, color);
 
-            character_position.x += glyph.m_advance_x * scale;
+            character_position.x += glyph->m_advance_x * scale;
          }
       }
    }
 
-   point_t calculate_bounds(const std::string &text, const int scale = 1)
+   // note: only the characters from the first difference onwards are laid out again
+   void build(text_mesh_t &mesh, const std::string_view &text, const int scale = 1) const
    {
-      point_t result;
-      for (auto &ch : text) {
-         uint32_t character_codepoint = static_cast<uint32_t>(uint8_t(ch));
+      if (mesh.m_font != this || mesh.m_font_version != m_version || mesh.m_scale != scale) {
+         mesh.clear();
+         mesh.m_font = this;
+         mesh.m_font_version = m_version;
+         mesh.m_scale = scale;
+      }
+
+      const std::string_view previous = mesh.m_text;
+      const size_t common = std::min(previous.size(), text.size());
+      size_t prefix = 0;
+      while (prefix < common && previous[prefix] == text[prefix]) {
+         prefix++;
+      }
+
+      if (prefix == previous.size() && prefix == text.size()) {
+         return;
+      }
+
+      while (prefix > 0 && prefix < text.size() && (uint8_t(text[prefix]) & 0xc0) == 0x80) {
+         prefix--;
+      }
+
+      while (!mesh.m_quads.empty() && mesh.m_quads.back().m_offset >= prefix) {
+         mesh.m_quads.pop_back();
+      }
+
+      size_t offset = 0;
+      point_t pen;
+      if (!mesh.m_quads.empty()) {
+         offset = mesh.m_quads.back().m_end;
+         pen = mesh.m_quads.back().m_pen;
+      }
+
+      mesh.m_text.assign(text);
+
+      const char *begin = text.data();
+      const char *end = text.data() + text.size();
+      for (const char *it = begin + offset; it != end;) {
+         const uint32_t character_offset = uint32_t(it - begin);
+         const uint32_t character_codepoint = decode_utf8(it, end);
 
          if (character_codepoint == newline_character_codepoint) {
-            result.y += m_newline_spacing * scale;
+            pen.x = 0;
+            pen.y += m_newline_spacing * scale;
             continue;
          }
 
-         if (character_codepoint < m_first_valid_character_codepoint ||
-             character_codepoint > m_last_valid_character_codepoint)
-         {
-            character_codepoint = invalid_character_codepoint;
+         if (const glyph_t *glyph = find_or_invalid(character_codepoint)) {
+            text_mesh_t::quad_t quad;
+            quad.m_source = glyph->m_source;
+            quad.m_dest = { pen, glyph->m_source.width_height() * scale };
+            quad.m_offset = character_offset;
+            quad.m_end = uint32_t(it - begin);
+
+            pen.x += glyph->m_advance_x * scale;
+            quad.m_pen = pen;
+
+            mesh.m_quads.push_back(quad);
          }
+      }
+   }
+
+   void render(graphics_t &graphics, const point_t &position, const text_mesh_t &mesh, const color_t &color) const
+   {
+      for (const text_mesh_t::quad_t &quad : mesh.m_quads) {
+         const rectangle_t dest{ quad.m_dest.xy() + position, quad.m_dest.width_height() };
+         graphics.draw(*m_texture, quad.m_source, dest, color);
+      }
+   }
+
+   point_t calculate_bounds(const std::string_view &text, const int scale = 1)
+   {
+      point_t result;
+      const char *end = text.data() + text.size();
+      for (const char *it = text.data(); it != end;) {
+         const uint32_t character_codepoint = decode_utf8(it, end);
 
-         glyph_t glyph;
-         if (contains(character_codepoint, glyph)) {
-            result.x += glyph.m_advance_x * scale;
+         if (character_codepoint == newline_character_codepoint) {
+            result.y += m_newline_spacing * scale;
+            continue;
+         }
+
+         if (const glyph_t *glyph = find_or_invalid(character_codepoint)) {
+            result.x += glyph->m_advance_x * scale;
          }
       }
 
@@ -87,43 +216,80 @@ struct bitmap_font_t {
       return *this;
    }
 
+   // note: lookups find nothing until the next sort()
    void add_glyph(glyph_t glyph)
    {
-      if (m_last_valid_character_codepoint < glyph.m_codepoint) {
-         m_last_valid_character_codepoint = glyph.m_codepoint;
-      }
-      if (m_first_valid_character_codepoint > glyph.m_codepoint) {
-         m_first_valid_character_codepoint = glyph.m_codepoint;
-      }
-
       m_glyphs.emplace_back(std::move(glyph));
+
+      std::fill(std::begin(m_dense), std::end(m_dense), uint16_t(0));
+      m_sparse_begin = m_glyphs.size();
+      m_invalid_glyph = 0;
+      m_version++;
    }
 
+   // note: must be called after adding glyphs, orders them and rebuilds the lookup table
    void sort()
    {
       std::sort(m_glyphs.begin(), m_glyphs.end(), [](auto &lhs, auto &rhs) {
          return lhs.m_codepoint < rhs.m_codepoint;
       });
+
+      // note: dense entries store index + 1, zero means no glyph
+      std::fill(std::begin(m_dense), std::end(m_dense), uint16_t(0));
+      for (size_t index = 0; index < m_glyphs.size(); index++) {
+         const uint32_t codepoint = m_glyphs[index].m_codepoint;
+         if (codepoint < dense_codepoint_count) {
+            m_dense[codepoint] = uint16_t(index + 1);
+         }
+      }
+
+      m_sparse_begin = std::lower_bound(m_glyphs.begin(), m_glyphs.end(), dense_codepoint_count, [](auto &lhs, uint32_t rhs) {
+         return lhs.m_codepoint < rhs;
+      }) - m_glyphs.begin();
+
+      const glyph_t *invalid_glyph = find(invalid_character_codepoint);
+      m_invalid_glyph = invalid_glyph != nullptr ? uint32_t(invalid_glyph - m_glyphs.data()) + 1 : 0;
+      m_version++;
    }
 
-   bool contains(const uint32_t codepoint, glyph_t &glyph) const
+   const glyph_t *find(const uint32_t codepoint) const
    {
-      auto it = std::find_if(m_glyphs.begin(), m_glyphs.end(), [&](auto &rhs) {
-         return rhs.m_codepoint == codepoint;
+      if (codepoint < dense_codepoint_count) {
+         const uint16_t index = m_dense[codepoint];
+         return index != 0 ? &m_glyphs[index - 1] : nullptr;
+      }
+
+      // note: codepoints beyond the dense range are rare, binary search the sorted tail
+      auto it = std::lower_bound(m_glyphs.begin() + m_sparse_begin, m_glyphs.end(), codepoint, [](auto &lhs, uint32_t rhs) {
+         return lhs.m_codepoint < rhs;
       });
 
-      if (it == m_glyphs.end()) {
-         return false;
+      if (it == m_glyphs.end() || it->m_codepoint != codepoint) {
+         return nullptr;
       }
 
-      glyph = *it;
+      return &*it;
+   }
 
-      return true;
+   const glyph_t *find_or_invalid(const uint32_t codepoint) const
+   {
+      const glyph_t *glyph = find(codepoint);
+      if (glyph == nullptr && m_invalid_glyph != 0) {
+         glyph = &m_glyphs[m_invalid_glyph - 1];
+      }
+
+      return glyph;
+   }
+
+   bool contains(const uint32_t codepoint) const
+   {
+      return find(codepoint) != nullptr;
    }
 
    void set_newline_spacing(const int spacing)
    {
       m_newline_spacing = spacing;
+      m_version++;
    }
 
    void set_texture(texture_t &texture)
@@ -132,10 +298,14 @@ struct bitmap_font_t {
    }
 
    texture_t           *m_texture = nullptr;
-   uint32_t             m_first_valid_character_codepoint = ~0u;
-   uint32_t             m_last_valid_character_codepoint = 0;
+   // note: bumped whenever glyphs or metrics change, meshes built before are laid out again
+   uint32_t             m_version = 0;
    int                  m_newline_spacing = 12;
    std::vector<glyph_t> m_glyphs;
+   size_t               m_sparse_begin = 0;
+   // note: index + 1 like the dense entries, a pointer would dangle when the font is copied
+   uint32_t             m_invalid_glyph = 0;
+   uint16_t             m_dense[dense_codepoint_count] = {};
 };
 
 #if 0
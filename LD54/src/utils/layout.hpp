@@ -0,0 +1,344 @@
+// layout.hpp
+
+#pragma once
+
+#include <unordered_map>
+
+enum class text_align_t {
+   left, center, right,
+};
+
+struct text_layout_t {
+   point_t     m_size;
+   int         m_line_count = 0;
+   uint32_t    m_last_used = 0;
+   text_mesh_t m_mesh;
+};
+
+// note: layouts are memoized by text, font, wrap width, scale and alignment,
+//       laying out unchanged text again costs one hash and one lookup. a layout
+//       returned this frame stays valid until next_frame().
+struct text_layout_engine_t {
+   static constexpr size_t   max_layout_count = 1024;
+   static constexpr uint32_t stale_frame_count = 120;
+
+   struct key_t {
+      bool operator==(const key_t &rhs) const
+      {
+         return hash == rhs.hash &&
+                text == rhs.text &&
+                font == rhs.font &&
+                width == rhs.width &&
+                scale == rhs.scale &&
+                align == rhs.align;
+      }
+
+      uint64_t             hash = 0;
+      // note: views the layout's own copy once stored, the caller's text while looking up
+      std::string_view     text;
+      const bitmap_font_t *font = nullptr;
+      int                  width = 0;
+      int                  scale = 1;
+      text_align_t         align = text_align_t::left;
+   };
+
+   struct key_hash_t {
+      size_t operator()(const key_t &key) const
+      {
+         uint64_t value = key.hash;
+         value ^= uint64_t(reinterpret_cast<uintptr_t>(key.font)) * 0x9e3779b97f4a7c15ull;
+         value ^= (uint64_t(uint32_t(key.width)) << 32 | uint32_t(key.scale) << 2 | uint32_t(key.align)) * 0xc2b2ae3d27d4eb4full;
+         return size_t(value ^ (value >> 29));
+      }
+   };
+
+   struct line_t {
+      size_t first = 0;
+      size_t last = 0;
+      int    width = 0;
+   };
+
+   struct stats_t {
+      uint32_t hits = 0;
+      uint32_t misses = 0;
+      uint32_t evictions = 0;
+   };
+
+   static uint64_t hash(const std::string_view &text)
+   {
+      uint64_t result = 0xcbf29ce484222325ull;
+      for (const char ch : text) {
+         result ^= uint8_t(ch);
+         result *= 0x100000001b3ull;
+      }
+
+      return result;
+   }
+
+   // note: a width of zero disables wrapping, alignment then uses the widest line
+   const text_layout_t &layout(const bitmap_font_t &font,
+                               const std::string_view &text,
+                               const int width = 0,
+                               const int scale = 1,
+                               const text_align_t align = text_align_t::left)
+   {
+      const key_t key{ hash(text), text, &font, width, scale, align };
+      if (auto it = m_layouts.find(key); it != m_layouts.end()) {
+         text_layout_t &cached = it->second;
+         cached.m_last_used = m_frame;
+         if (cached.m_mesh.m_font_version != font.m_version) {
+            // note: the text is assigned again at the same length, its buffer and the key's view stay put
+            build(cached, font, text, width, scale, align);
+            m_stats.misses++;
+            return cached;
+         }
+
+         m_stats.hits++;
+         return cached;
+      }
+
+      if (m_layouts.size() >= max_layout_count) {
+         evict();
+      }
+
+      auto it = m_layouts.emplace(key, text_layout_t{}).first;
+      text_layout_t &result = it->second;
+      result.m_last_used = m_frame;
+      build(result, font, text, width, scale, align);
+      m_stats.misses++;
+
+      // note: rebinds the key to the stored text, the node and with it result stay where they are
+      auto node = m_layouts.extract(it);
+      node.key().text = node.mapped().m_mesh.m_text;
+      m_layouts.insert(std::move(node));
+
+      return result;
+   }
+
+   void render(graphics_t &graphics, const text_layout_t &layout, const point_t &position, const color_t &color) const
+   {
+      layout.m_mesh.m_font->render(graphics, position, layout.m_mesh, color);
+   }
+
+   // note: glyphs are trimmed to the clip rectangle in whole source texels
+   void render(graphics_t &graphics, const text_layout_t &layout, const point_t &position, const rectangle_t &clip, const color_t &color) const
+   {
+      const bitmap_font_t &font = *layout.m_mesh.m_font;
+      const int scale = std::max(layout.m_mesh.m_scale, 1);
+      const int clip_right = clip.x + clip.w;
+      const int clip_bottom = clip.y + clip.h;
+
+      for (const text_mesh_t::quad_t &quad : layout.m_mesh.m_quads) {
+         rectangle_t src = quad.m_source;
+         rectangle_t dst{ quad.m_dest.xy() + position, quad.m_dest.width_height() };
+
+         if (dst.x >= clip_right || dst.y >= clip_bottom || dst.x + dst.w <= clip.x || dst.y + dst.h <= clip.y) {
+            continue;
+         }
+
+         if (dst.x < clip.x) {
+            const int texels = (clip.x - dst.x + scale - 1) / scale;
+            src.x += texels;
+            src.w -= texels;
+            dst.x += texels * scale;
+            dst.w -= texels * scale;
+         }
+
+         if (dst.y < clip.y) {
+            const int texels = (clip.y - dst.y + scale - 1) / scale;
+            src.y += texels;
+            src.h -= texels;
+            dst.y += texels * scale;
+            dst.h -= texels * scale;
+         }
+
+         if (dst.x + dst.w > clip_right) {
+            const int texels = (dst.x + dst.w - clip_right + scale - 1) / scale;
+            src.w -= texels;
+            dst.w -= texels * scale;
+         }
+
+         if (dst.y + dst.h > clip_bottom) {
+            const int texels = (dst.y + dst.h - clip_bottom + scale - 1) / scale;
+            src.h -= texels;
+            dst.h -= texels * scale;
+         }
+
+         if (src.w <= 0 || src.h <= 0) {
+            continue;
+         }
+
+         graphics.draw(*font.m_texture, src, dst, color);
+      }
+   }
+
+   void next_frame()
+   {
+      m_frame++;
+   }
+
+   void clear()
+   {
+      m_layouts.clear();
+   }
+
+   const stats_t &stats() const
+   {
+      return m_stats;
+   }
+
+private:
+   void evict()
+   {
+      const size_t before = m_layouts.size();
+      std::erase_if(m_layouts, [this](const auto &entry) {
+         return m_frame - entry.second.m_last_used > stale_frame_count;
+      });
+
+      // note: everything is recent, drop all but this frame's layouts rather than grow
+      //       without bound. the caller may still hold those, erasing other entries
+      //       leaves them in place.
+      if (m_layouts.size() >= max_layout_count) {
+         std::erase_if(m_layouts, [this](const auto &entry) {
+            return entry.second.m_last_used != m_frame;
+         });
+      }
+
+      m_stats.evictions += uint32_t(before - m_layouts.size());
+   }
+
+   void build(text_layout_t &result,
+              const bitmap_font_t &font,
+              const std::string_view &text,
+              const int width,
+              const int scale,
+              const text_align_t align)
+   {
+      text_mesh_t &mesh = result.m_mesh;
+      mesh.clear();
+      mesh.m_font = &font;
+      mesh.m_font_version = font.m_version;
+      mesh.m_scale = scale;
+      mesh.m_text.assign(text);
+
+      m_lines.clear();
+
+      const int line_spacing = font.m_newline_spacing * scale;
+      point_t pen;
+      line_t line;
+      int line_right = 0;
+      size_t break_quad = 0;
+      bool has_break = false;
+
+      const auto finish_line = [&](const size_t last) {
+         line.last = last;
+         line.width = line_right;
+         m_lines.push_back(line);
+
+         line = {};
+         line.first = last;
+         line_right = 0;
+         has_break = false;
+         pen.x = 0;
+         pen.y += line_spacing;
+      };
+
+      const char *begin = text.data();
+      const char *end = text.data() + text.size();
+      for (const char *it = begin; it != end;) {
+         const uint32_t offset = uint32_t(it - begin);
+         const uint32_t character_codepoint = bitmap_font_t::decode_utf8(it, end);
+
+         if (character_codepoint == bitmap_font_t::newline_character_codepoint) {
+            finish_line(mesh.m_quads.size());
+            continue;
+         }
+
+         const bitmap_font_t::glyph_t *glyph = font.find_or_invalid(character_codepoint);
+         if (glyph == nullptr) {
+            continue;
+         }
+
+         const int advance = glyph->m_advance_x * scale;
+         if (character_codepoint == ' ') {
+            // note: spaces are break opportunities and never start or end a wrapped line
+            if (pen.x > 0) {
+               break_quad = mesh.m_quads.size();
+               has_break = true;
+               pen.x += advance;
+            }
+
+            continue;
+         }
+
+         if (width > 0 && pen.x > 0 && pen.x + advance > width) {
+            if (has_break) {
+               // note: carry the word after the last space down to the next line
+               const size_t carried = break_quad;
+               int right = 0;
+               for (size_t index = line.first; index < carried; index++) {
+                  const rectangle_t &dest = mesh.m_quads[index].m_dest;
+                  right = std::max(right, dest.x + dest.w);
+               }
+
+               line_right = right;
+               const int shift = carried < mesh.m_quads.size() ? mesh.m_quads[carried].m_dest.x : 0;
+               finish_line(carried);
+
+               for (size_t index = carried; index < mesh.m_quads.size(); index++) {
+                  text_mesh_t::quad_t &quad = mesh.m_quads[index];
+                  quad.m_dest.x -= shift;
+                  quad.m_dest.y = pen.y;
+                  pen.x = quad.m_dest.x + quad.m_pen.x;
+                  line_right = quad.m_dest.x + quad.m_dest.w;
+               }
+            }
+            else {
+               finish_line(mesh.m_quads.size());
+            }
+         }
+
+         text_mesh_t::quad_t quad;
+         quad.m_source = glyph->m_source;
+         quad.m_dest = { pen, glyph->m_source.width_height() * scale };
+         quad.m_offset = offset;
+         quad.m_end = uint32_t(it - begin);
+         quad.m_pen = { advance, 0 };
+         mesh.m_quads.push_back(quad);
+
+         pen.x += advance;
+         line_right = quad.m_dest.x + quad.m_dest.w;
+      }
+
+      finish_line(mesh.m_quads.size());
+
+      int widest = 0;
+      for (const line_t &entry : m_lines) {
+         widest = std::max(widest, entry.width);
+      }
+
+      const int box_width = width > 0 ? width : widest;
+      if (align != text_align_t::left) {
+         for (const line_t &entry : m_lines) {
+            const int slack = box_width - entry.width;
+            const int shift = align == text_align_t::center ? slack / 2 : slack;
+            for (size_t index = entry.first; index < entry.last; index++) {
+               mesh.m_quads[index].m_dest.x += shift;
+            }
+         }
+      }
+
+      // note: quads keep their own advance in m_pen while wrapping, restore the pen
+      for (text_mesh_t::quad_t &quad : mesh.m_quads) {
+         quad.m_pen = { quad.m_dest.x + quad.m_pen.x, quad.m_dest.y };
+      }
+
+      result.m_line_count = int(m_lines.size());
+      result.m_size = { box_width, int(m_lines.size()) * line_spacing };
+   }
+
+   uint32_t                                               m_frame = 0;
+   stats_t                                                m_stats;
+   std::vector<line_t>                                    m_lines;
+   std::unordered_map<key_t, text_layout_t, key_hash_t>   m_layouts;
+};
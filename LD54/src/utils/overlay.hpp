@@ -1,17 +1,36 @@
 // overlay.hpp
 
 #include <cstdarg>
+#include <cstdio>
+#include <cmath>
+#include <unordered_map>
 
+// note: line text lives in a per-frame arena that keeps its capacity across
+//       clear(), once warmed up formatting and rendering lines never allocate.
 struct overlay_t {
+   static constexpr size_t initial_arena_size = 8192;
+   static constexpr uint32_t invalid_mesh = ~0u;
+
    struct line_t {
-      point_t position;
-      color_t color;
-      std::string text;
+      point_t  position;
+      color_t  color;
+      uint32_t offset = 0;
+      uint32_t length = 0;
+   };
+
+   struct cached_mesh_t {
+      text_mesh_t mesh;
+      uint64_t    frame = 0;
+      // note: where the mesh sits in the free list while it is in there
+      uint32_t    free_slot = 0;
    };
 
+   using mesh_lookup_t = std::unordered_map<uint64_t, uint32_t>;
+
    overlay_t(bitmap_font_t &font)
       : m_font(font)
    {
+      m_arena.resize(initial_arena_size);
    }
 
    void render(graphics_t &graphics)
@@ -20,22 +39,153 @@ struct overlay_t {
          return;
       }
 
-      for (auto &line : m_lines) {
-         m_font.render(graphics, line.position + point_t{1,1}, line.text, color_black, m_scale);
-         m_font.render(graphics, line.position, line.text, line.color, m_scale);
+      // note: the distance field path draws the drop shadow in the same pass as the text
+      if (m_sdf_font != nullptr && m_sdf_font->valid()) {
+         const float pixel_height = m_sdf_pixel_height * m_scale;
+         // note: one screen pixel like the bitmap path, capped at half the padding so the
+         //       shadow stays inside the quad and is not clipped at its edges.
+         const float shadow_offset = std::min(m_sdf_font->texels_per_pixel(pixel_height), float(m_sdf_font->m_padding) * 0.5f);
+
+         graphics_t::sdf_style_t style;
+         style.shadow_offset = { shadow_offset, shadow_offset };
+         style.shadow_color = color_black;
+
+         for (const line_t &line : m_lines) {
+            m_sdf_font->render(graphics, line.position, text(line), line.color, pixel_height, style);
+         }
+
+         return;
+      }
+
+      // note: meshes persist across frames, keyed by a hash of their text, scale and
+      //       font, a line that exists since last frame costs one lookup wherever it
+      //       moved. meshes nobody used this frame go back to the free list, still
+      //       holding their map node and buffers, and new text takes one of those,
+      //       preferably the one at its own index last frame so build() keeps the
+      //       prefix both texts share.
+      m_frame++;
+      m_line_meshes.swap(m_previous_line_meshes);
+      m_line_meshes.assign(m_lines.size(), invalid_mesh);
+      bool missed = false;
+      for (size_t index = 0; index < m_lines.size(); index++) {
+         if (auto it = m_mesh_lookup.find(mesh_key(text(m_lines[index]))); it != m_mesh_lookup.end()) {
+            m_meshes[it->second].frame = m_frame;
+            m_line_meshes[index] = it->second;
+         }
+         else {
+            missed = true;
+         }
+      }
+
+      if (missed) {
+         for (auto it = m_mesh_lookup.begin(); it != m_mesh_lookup.end();) {
+            if (m_meshes[it->second].frame != m_frame) {
+               m_meshes[it->second].free_slot = uint32_t(m_free_meshes.size());
+               m_free_meshes.push_back(m_mesh_lookup.extract(it++));
+            }
+            else {
+               ++it;
+            }
+         }
+      }
+
+      for (size_t index = 0; index < m_lines.size(); index++) {
+         if (m_line_meshes[index] == invalid_mesh) {
+            const uint32_t previous = index < m_previous_line_meshes.size() ? m_previous_line_meshes[index] : invalid_mesh;
+            m_line_meshes[index] = claim_mesh(mesh_key(text(m_lines[index])), previous);
+         }
+
+         // note: build() also lays out again after a glyph change or a hash collision
+         const line_t &line = m_lines[index];
+         text_mesh_t &mesh = m_meshes[m_line_meshes[index]].mesh;
+         m_font.build(mesh, text(line), m_scale);
+         m_font.render(graphics, line.position + point_t{1,1}, mesh, color_black);
+         m_font.render(graphics, line.position, mesh, line.color);
+      }
+   }
+
+   uint64_t mesh_key(const std::string_view &line_text) const
+   {
+      uint64_t result = 0xcbf29ce484222325ull;
+      for (const char ch : line_text) {
+         result ^= uint8_t(ch);
+         result *= 0x100000001b3ull;
+      }
+
+      result ^= uint64_t(reinterpret_cast<uintptr_t>(&m_font)) * 0x9e3779b97f4a7c15ull;
+      result ^= uint64_t(uint32_t(m_scale)) * 0xc2b2ae3d27d4eb4full;
+      return result;
+   }
+
+   // note: two new lines with the same text share the mesh the first one claimed
+   uint32_t claim_mesh(const uint64_t key, const uint32_t preferred)
+   {
+      if (auto it = m_mesh_lookup.find(key); it != m_mesh_lookup.end()) {
+         return it->second;
+      }
+
+      uint32_t index = 0;
+      if (!m_free_meshes.empty()) {
+         // note: a mesh unused this frame is in the free list, swap it to the back
+         if (preferred != invalid_mesh && m_meshes[preferred].frame != m_frame) {
+            const uint32_t slot = m_meshes[preferred].free_slot;
+            if (slot + 1 != m_free_meshes.size()) {
+               std::swap(m_free_meshes[slot], m_free_meshes.back());
+               m_meshes[m_free_meshes[slot].mapped()].free_slot = slot;
+            }
+         }
+
+         auto node = std::move(m_free_meshes.back());
+         m_free_meshes.pop_back();
+         node.key() = key;
+         index = node.mapped();
+         m_mesh_lookup.insert(std::move(node));
       }
+      else {
+         index = uint32_t(m_meshes.size());
+         m_meshes.emplace_back();
+         m_mesh_lookup.emplace(key, index);
+      }
+
+      m_meshes[index].frame = m_frame;
+      return index;
    }
 
+   // note: printf style, formatted straight into the arena tail
    void draw_text_va(const color_t &color, const char *format, ...)
    {
-      char text[512] = {};
       va_list args;
       va_start(args, format);
-      vsprintf_s(text, format, args);
+      va_list retry;
+      va_copy(retry, args);
+
+      // note: vsnprintf wants room for the terminator, it is not part of the line
+      const int length = vsnprintf(m_arena.data() + m_arena_used, available(), format, args);
+      if (length >= 0 && size_t(length) >= available()) {
+         reserve(size_t(length) + 1);
+         vsnprintf(m_arena.data() + m_arena_used, available(), format, retry);
+      }
+
+      va_end(retry);
       va_end(args);
 
-      m_lines.emplace_back(m_position, color, std::string(text));
-      m_position.y += m_font.m_newline_spacing * m_scale;
+      if (length >= 0) {
+         push_line(color, size_t(length));
+      }
+   }
+
+   std::string_view text(const line_t &line) const
+   {
+      return { m_arena.data() + line.offset, line.length };
+   }
+
+   int line_spacing() const
+   {
+      if (m_sdf_font != nullptr && m_sdf_font->valid()) {
+         return int(std::ceil(m_sdf_font->line_height(m_sdf_pixel_height * m_scale)));
+      }
+
+      return m_font.m_newline_spacing * m_scale;
    }
 
    void toggle()
@@ -48,6 +198,13 @@ struct overlay_t {
       m_scale = scale;
    }
 
+   // note: unused by the game until a .ttf ships, null keeps the bitmap font
+   void set_sdf_font(sdf_font_t *font, const float pixel_height)
+   {
+      m_sdf_font = font;
+      m_sdf_pixel_height = pixel_height;
+   }
+
    void set_origin(const point_t &origin)
    {
       m_origin = origin;
@@ -56,13 +213,44 @@ struct overlay_t {
    void clear()
    {
       m_lines.clear();
+      m_arena_used = 0;
       m_position = m_origin;
    }
 
-   bitmap_font_t      &m_font;
-   bool                m_active = true;
-   int                 m_scale = 1;
-   point_t             m_origin = { 2, 2 };
-   point_t             m_position = { 2, 2 };
-   std::vector<line_t> m_lines;
+   size_t available() const
+   {
+      return m_arena.size() - m_arena_used;
+   }
+
+   // note: growth only happens until the arena fits the busiest frame
+   void reserve(const size_t length)
+   {
+      if (available() < length) {
+         m_arena.resize(std::max(m_arena.size() * 2, m_arena_used + length));
+      }
+   }
+
+   void push_line(const color_t &color, const size_t length)
+   {
+      m_lines.emplace_back(m_position, color, uint32_t(m_arena_used), uint32_t(length));
+      m_arena_used += length;
+      m_position.y += line_spacing();
+   }
+
+   bitmap_font_t                        &m_font;
+   sdf_font_t                           *m_sdf_font = nullptr;
+   float                                 m_sdf_pixel_height = 8.0f;
+   bool                                  m_active = true;
+   int                                   m_scale = 1;
+   point_t                               m_origin = { 2, 2 };
+   point_t                               m_position = { 2, 2 };
+   std::vector<line_t>                   m_lines;
+   std::vector<char>                     m_arena;
+   size_t                                m_arena_used = 0;
+   std::vector<cached_mesh_t>            m_meshes;
+   std::vector<uint32_t>                 m_line_meshes;
+   std::vector<uint32_t>                 m_previous_line_meshes;
+   uint64_t                              m_frame = 0;
+   mesh_lookup_t                         m_mesh_lookup;
+   std::vector<mesh_lookup_t::node_type> m_free_meshes;
 };
@@ -0,0 +1,649 @@
+// truetype.cpp
+
+#include "../awry/awry.h"
+#include "font.hpp"
+#include "truetype.hpp"
+
+#include <cstdio>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4245)
+#pragma warning(disable: 4456)
+#pragma warning(disable: 4457)
+#pragma warning(disable: 4701)
+#endif
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+namespace
+{
+   uint64_t glyph_key(const uint32_t codepoint, const int pixel_height)
+   {
+      return (uint64_t(pixel_height) << 32) | codepoint;
+   }
+
+   FILE *open_file(const char *path, const char *mode)
+   {
+#if defined(_MSC_VER)
+      FILE *file = nullptr;
+      return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+      return fopen(path, mode);
+#endif
+   }
+
+   bool read_file(const char *path, std::vector<uint8_t> &content)
+   {
+      FILE *file = open_file(path, "rb");
+      if (file == nullptr) {
+         return false;
+      }
+
+      fseek(file, 0, SEEK_END);
+      content.resize(size_t(ftell(file)));
+      fseek(file, 0, SEEK_SET);
+      const size_t read = fread(content.data(), 1, content.size(), file);
+      fclose(file);
+
+      return read == content.size();
+   }
+} // !anon
+
+truetype_font_t::truetype_font_t() = default;
+
+truetype_font_t::~truetype_font_t()
+{
+   destroy();
+}
+
+bool truetype_font_t::valid() const
+{
+   return m_info != nullptr && m_texture.valid();
+}
+
+bool truetype_font_t::create_from_file(const char *path, const int pixel_height, const point_t &atlas_size)
+{
+   std::vector<uint8_t> content;
+   if (!read_file(path, content)) {
+      return false;
+   }
+
+   return create_from_memory(std::move(content), pixel_height, atlas_size);
+}
+
+bool truetype_font_t::create_from_memory(std::vector<uint8_t> content, const int pixel_height, const point_t &atlas_size)
+{
+   destroy();
+
+   m_content = std::move(content);
+   m_info = std::make_unique<stbtt_fontinfo>();
+   const int offset = stbtt_GetFontOffsetForIndex(m_content.data(), 0);
+   if (offset < 0 || !stbtt_InitFont(m_info.get(), m_content.data(), offset)) {
+      destroy();
+      return false;
+   }
+
+   m_pixels.assign(size_t(atlas_size.x) * atlas_size.y, 0);
+   if (!m_texture.create(atlas_size, m_pixels.data())) {
+      destroy();
+      return false;
+   }
+
+   m_pixel_height = pixel_height;
+
+   return true;
+}
+
+void truetype_font_t::destroy()
+{
+   m_texture.destroy();
+   m_info.reset();
+   m_content.clear();
+   m_pixels.clear();
+   m_shelves.clear();
+   m_glyphs.clear();
+   m_dirty = {};
+   m_next_shelf_y = 0;
+   m_stats = {};
+}
+
+void truetype_font_t::next_frame()
+{
+   m_frame++;
+}
+
+void truetype_font_t::flush()
+{
+   if (m_dirty.w <= 0 || m_dirty.h <= 0) {
+      return;
+   }
+
+   const int pitch = m_texture.m_size.x;
+   m_texture.update(m_dirty, m_pixels.data() + size_t(m_dirty.y) * pitch + m_dirty.x, pitch);
+   m_stats.uploads++;
+   m_dirty = {};
+}
+
+void truetype_font_t::render(graphics_t &graphics, const point_t &position, const std::string_view &text, const color_t &color, const int scale)
+{
+   if (!valid()) {
+      return;
+   }
+
+   const int pixel_height = m_pixel_height * scale;
+   const float font_scale = stbtt_ScaleForPixelHeight(m_info.get(), float(pixel_height));
+
+   int ascent = 0, descent = 0, line_gap = 0;
+   stbtt_GetFontVMetrics(m_info.get(), &ascent, &descent, &line_gap);
+
+   float pen_x = float(position.x);
+   int baseline = position.y + int(std::ceil(ascent * font_scale));
+   uint32_t previous = 0;
+
+   const char *end = text.data() + text.size();
+   for (const char *it = text.data(); it != end;) {
+      const uint32_t character_codepoint = bitmap_font_t::decode_utf8(it, end);
+
+      if (character_codepoint == newline_character_codepoint) {
+         pen_x = float(position.x);
+         baseline += line_height(scale);
+         previous = 0;
+         continue;
+      }
+
+      if (previous != 0) {
+         pen_x += stbtt_GetCodepointKernAdvance(m_info.get(), int(previous), int(character_codepoint)) * font_scale;
+      }
+
+      if (const glyph_t *glyph = find(character_codepoint, pixel_height)) {
+         if (glyph->m_source.w > 0) {
+            const point_t origin{ int(std::floor(pen_x + 0.5f)), baseline };
+            graphics.draw(m_texture, glyph->m_source, { origin + glyph->m_offset, glyph->m_source.width_height() }, color);
+         }
+
+         pen_x += glyph->m_advance_x;
+      }
+
+      previous = character_codepoint;
+   }
+
+   // note: glyphs rasterized while laying out this text go up in one upload
+   flush();
+}
+
+point_t truetype_font_t::calculate_bounds(const std::string_view &text, const int scale)
+{
+   if (!valid()) {
+      return {};
+   }
+
+   const int pixel_height = m_pixel_height * scale;
+   const float font_scale = stbtt_ScaleForPixelHeight(m_info.get(), float(pixel_height));
+
+   float pen_x = 0.0f;
+   float width = 0.0f;
+   point_t result;
+   uint32_t previous = 0;
+
+   const char *end = text.data() + text.size();
+   for (const char *it = text.data(); it != end;) {
+      const uint32_t character_codepoint = bitmap_font_t::decode_utf8(it, end);
+
+      if (character_codepoint == newline_character_codepoint) {
+         pen_x = 0.0f;
+         result.y += line_height(scale);
+         previous = 0;
+         continue;
+      }
+
+      if (previous != 0) {
+         pen_x += stbtt_GetCodepointKernAdvance(m_info.get(), int(previous), int(character_codepoint)) * font_scale;
+      }
+
+      if (const glyph_t *glyph = find(character_codepoint, pixel_height)) {
+         pen_x += glyph->m_advance_x;
+      }
+
+      width = std::max(width, pen_x);
+      previous = character_codepoint;
+   }
+
+   result.x = int(std::ceil(width));
+
+   return result;
+}
+
+void truetype_font_t::set_pixel_height(const int pixel_height)
+{
+   m_pixel_height = pixel_height;
+}
+
+int truetype_font_t::line_height(const int scale) const
+{
+   if (m_info == nullptr) {
+      return 0;
+   }
+
+   int ascent = 0, descent = 0, line_gap = 0;
+   stbtt_GetFontVMetrics(m_info.get(), &ascent, &descent, &line_gap);
+
+   const float font_scale = stbtt_ScaleForPixelHeight(m_info.get(), float(m_pixel_height * scale));
+   return int(std::ceil((ascent - descent + line_gap) * font_scale));
+}
+
+const truetype_font_t::stats_t &truetype_font_t::stats() const
+{
+   return m_stats;
+}
+
+const truetype_font_t::glyph_t *truetype_font_t::find(const uint32_t codepoint, const int pixel_height)
+{
+   const uint64_t key = glyph_key(codepoint, pixel_height);
+   if (auto it = m_glyphs.find(key); it != m_glyphs.end()) {
+      if (it->second.m_shelf >= 0) {
+         m_shelves[it->second.m_shelf].m_last_used = m_frame;
+      }
+
+      return &it->second;
+   }
+
+   const int glyph_index = stbtt_FindGlyphIndex(m_info.get(), int(codepoint));
+   if (glyph_index == 0 && codepoint != invalid_character_codepoint) {
+      return find(invalid_character_codepoint, pixel_height);
+   }
+
+   const float font_scale = stbtt_ScaleForPixelHeight(m_info.get(), float(pixel_height));
+
+   int advance = 0, left_side_bearing = 0;
+   stbtt_GetGlyphHMetrics(m_info.get(), glyph_index, &advance, &left_side_bearing);
+
+   int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+   stbtt_GetGlyphBitmapBox(m_info.get(), glyph_index, font_scale, font_scale, &x0, &y0, &x1, &y1);
+
+   glyph_t glyph;
+   glyph.m_offset = { x0, y0 };
+   glyph.m_advance_x = advance * font_scale;
+
+   const point_t size{ x1 - x0, y1 - y0 };
+   if (size.x > 0 && size.y > 0) {
+      rectangle_t area;
+      int shelf_index = -1;
+      if (!allocate({ size.x + glyph_padding, size.y + glyph_padding }, area, shelf_index)) {
+         // note: everything left is in use this frame, draw nothing but keep the advance
+         m_stats.misses++;
+         m_uncached = glyph;
+         return &m_uncached;
+      }
+
+      m_scratch.resize(size_t(size.x) * size.y);
+      stbtt_MakeGlyphBitmap(m_info.get(), m_scratch.data(), size.x, size.y, size.x, font_scale, font_scale, glyph_index);
+
+      // note: padding is cleared as well, the area may hold an evicted glyph
+      const int pitch = m_texture.m_size.x;
+      for (int y = 0; y < area.h; y++) {
+         uint32_t *dst = m_pixels.data() + size_t(area.y + y) * pitch + area.x;
+         for (int x = 0; x < area.w; x++) {
+            const uint8_t coverage = (x < size.x && y < size.y) ? m_scratch[size_t(y) * size.x + x] : 0;
+            dst[x] = (uint32_t(coverage) << 24) | 0x00ffffff;
+         }
+      }
+
+      glyph.m_source = { area.xy(), size };
+      glyph.m_shelf = shelf_index;
+      m_shelves[shelf_index].m_keys.push_back(key);
+      mark_dirty(area);
+      m_stats.glyphs_rasterized++;
+   }
+
+   auto result = m_glyphs.emplace(key, glyph);
+   m_stats.glyphs_cached = uint32_t(m_glyphs.size());
+
+   return &result.first->second;
+}
+
+bool truetype_font_t::allocate(const point_t &size, rectangle_t &result, int &shelf_index)
+{
+   const point_t atlas_size = m_texture.m_size;
+   if (size.x > atlas_size.x || size.y > atlas_size.y) {
+      return false;
+   }
+
+   // note: shelf heights are rounded up so glyphs of similar height share shelves
+   const int height = (size.y + shelf_granularity - 1) / shelf_granularity * shelf_granularity;
+
+   shelf_index = -1;
+   for (int index = 0; index < int(m_shelves.size()); index++) {
+      const shelf_t &shelf = m_shelves[index];
+      if (shelf.m_height < height || shelf.m_cursor_x + size.x > atlas_size.x) {
+         continue;
+      }
+
+      if (shelf_index < 0 || shelf.m_height < m_shelves[shelf_index].m_height) {
+         shelf_index = index;
+      }
+   }
+
+   if (shelf_index < 0 && m_next_shelf_y + height <= atlas_size.y) {
+      shelf_t shelf;
+      shelf.m_y = m_next_shelf_y;
+      shelf.m_height = height;
+      m_shelves.push_back(shelf);
+      m_next_shelf_y += height;
+      shelf_index = int(m_shelves.size()) - 1;
+   }
+
+   if (shelf_index < 0) {
+      for (int index = 0; index < int(m_shelves.size()); index++) {
+         const shelf_t &shelf = m_shelves[index];
+         if (shelf.m_height < height || shelf.m_last_used == m_frame) {
+            continue;
+         }
+
+         if (shelf_index < 0 || shelf.m_last_used < m_shelves[shelf_index].m_last_used) {
+            shelf_index = index;
+         }
+      }
+
+      if (shelf_index >= 0) {
+         evict(m_shelves[shelf_index]);
+      }
+   }
+
+   // note: no stale shelf is tall enough on its own, merge a run of adjacent stale shelves
+   if (shelf_index < 0) {
+      for (int first = 0; first < int(m_shelves.size()) && shelf_index < 0; first++) {
+         int total = 0;
+         for (int last = first; last < int(m_shelves.size()); last++) {
+            if (m_shelves[last].m_last_used == m_frame) {
+               break;
+            }
+
+            total += m_shelves[last].m_height;
+            if (last == int(m_shelves.size()) - 1) {
+               total = std::min(total + atlas_size.y - m_next_shelf_y, std::max(total, height));
+            }
+
+            if (total >= height) {
+               merge(first, last, total);
+               shelf_index = first;
+               break;
+            }
+         }
+      }
+
+      if (shelf_index < 0) {
+         return false;
+      }
+   }
+
+   shelf_t &shelf = m_shelves[shelf_index];
+   result = { shelf.m_cursor_x, shelf.m_y, size };
+   shelf.m_cursor_x += size.x;
+   shelf.m_last_used = m_frame;
+
+   return true;
+}
+
+void truetype_font_t::evict(shelf_t &shelf)
+{
+   for (const uint64_t key : shelf.m_keys) {
+      m_glyphs.erase(key);
+   }
+
+   shelf.m_keys.clear();
+   shelf.m_cursor_x = 0;
+   m_stats.shelves_evicted++;
+}
+
+void truetype_font_t::merge(const int first, const int last, const int height)
+{
+   for (int index = first; index <= last; index++) {
+      evict(m_shelves[index]);
+   }
+
+   m_shelves[first].m_height = height;
+   m_shelves.erase(m_shelves.begin() + first + 1, m_shelves.begin() + last + 1);
+
+   // note: shelves past the merged run moved down, patch the indices of their glyphs
+   for (int index = first + 1; index < int(m_shelves.size()); index++) {
+      for (const uint64_t key : m_shelves[index].m_keys) {
+         m_glyphs[key].m_shelf = index;
+      }
+   }
+
+   if (first == int(m_shelves.size()) - 1) {
+      m_next_shelf_y = m_shelves[first].m_y + height;
+   }
+}
+
+void truetype_font_t::mark_dirty(const rectangle_t &area)
+{
+   if (m_dirty.w <= 0 || m_dirty.h <= 0) {
+      m_dirty = area;
+      return;
+   }
+
+   const int x0 = std::min(m_dirty.x, area.x);
+   const int y0 = std::min(m_dirty.y, area.y);
+   const int x1 = std::max(m_dirty.x + m_dirty.w, area.x + area.w);
+   const int y1 = std::max(m_dirty.y + m_dirty.h, area.y + area.h);
+   m_dirty = { x0, y0, x1 - x0, y1 - y0 };
+}
+
+sdf_font_t::sdf_font_t() = default;
+
+sdf_font_t::~sdf_font_t()
+{
+   destroy();
+}
+
+bool sdf_font_t::valid() const
+{
+   return m_texture.valid();
+}
+
+bool sdf_font_t::create_from_file(const char *path, const int base_pixel_height, const int padding, const point_t &atlas_size)
+{
+   std::vector<uint8_t> content;
+   if (!read_file(path, content)) {
+      return false;
+   }
+
+   return create_from_memory(content, base_pixel_height, padding, atlas_size);
+}
+
+bool sdf_font_t::create_from_memory(const std::vector<uint8_t> &content, const int base_pixel_height, const int padding, const point_t &atlas_size)
+{
+   destroy();
+
+   stbtt_fontinfo info;
+   const int offset = stbtt_GetFontOffsetForIndex(content.data(), 0);
+   if (offset < 0 || !stbtt_InitFont(&info, content.data(), offset)) {
+      return false;
+   }
+
+   const float font_scale = stbtt_ScaleForPixelHeight(&info, float(base_pixel_height));
+
+   int ascent = 0, descent = 0, line_gap = 0;
+   stbtt_GetFontVMetrics(&info, &ascent, &descent, &line_gap);
+   m_ascent = ascent * font_scale;
+   m_line_height = (ascent - descent + line_gap) * font_scale;
+   m_base_pixel_height = base_pixel_height;
+   m_padding = padding;
+
+   // note: the edge sits at 128 and the field falls to zero at the padding border
+   const uint8_t on_edge_value = 128;
+   const float pixel_distance_scale = float(on_edge_value) / float(padding);
+
+   std::vector<uint32_t> pixels(size_t(atlas_size.x) * atlas_size.y, 0x00ffffff);
+   point_t cursor{ glyph_spacing, glyph_spacing };
+   int row_height = 0;
+
+   for (uint32_t codepoint = 32; codepoint < 127; codepoint++) {
+      const int glyph_index = stbtt_FindGlyphIndex(&info, int(codepoint));
+
+      int advance = 0, left_side_bearing = 0;
+      stbtt_GetGlyphHMetrics(&info, glyph_index, &advance, &left_side_bearing);
+
+      glyph_t glyph;
+      glyph.m_codepoint = codepoint;
+      glyph.m_advance_x = advance * font_scale;
+
+      int width = 0, height = 0, x0 = 0, y0 = 0;
+      uint8_t *field = stbtt_GetGlyphSDF(&info, font_scale, glyph_index, padding, on_edge_value, pixel_distance_scale,
+                                         &width, &height, &x0, &y0);
+      if (field != nullptr) {
+         if (cursor.x + width + glyph_spacing > atlas_size.x) {
+            cursor.x = glyph_spacing;
+            cursor.y += row_height + glyph_spacing;
+            row_height = 0;
+         }
+
+         if (cursor.y + height + glyph_spacing > atlas_size.y) {
+            stbtt_FreeSDF(field, nullptr);
+            destroy();
+            return false;
+         }
+
+         for (int y = 0; y < height; y++) {
+            uint32_t *dst = pixels.data() + size_t(cursor.y + y) * atlas_size.x + cursor.x;
+            for (int x = 0; x < width; x++) {
+               dst[x] = (uint32_t(field[y * width + x]) << 24) | 0x00ffffff;
+            }
+         }
+
+         stbtt_FreeSDF(field, nullptr);
+
+         glyph.m_source = { cursor, point_t{ width, height } };
+         glyph.m_offset = { float(x0), float(y0) };
+         cursor.x += width + glyph_spacing;
+         row_height = std::max(row_height, height);
+      }
+
+      m_glyphs.push_back(glyph);
+   }
+
+   if (!m_texture.create(atlas_size, pixels.data(), texture_t::filter_t::linear)) {
+      destroy();
+      return false;
+   }
+
+   const glyph_t *invalid_glyph = find(invalid_character_codepoint);
+   m_invalid_glyph = invalid_glyph != nullptr ? uint32_t(invalid_glyph - m_glyphs.data()) + 1 : 0;
+
+   return true;
+}
+
+void sdf_font_t::destroy()
+{
+   m_texture.destroy();
+   m_glyphs.clear();
+   m_invalid_glyph = 0;
+}
+
+void sdf_font_t::render(graphics_t &graphics, const point_t &position, const std::string_view &text, const color_t &color, const float pixel_height)
+{
+   render(graphics, position, text, color, pixel_height, graphics_t::sdf_style_t{});
+}
+
+void sdf_font_t::render(graphics_t &graphics, const point_t &position, const std::string_view &text, const color_t &color, const float pixel_height,
+                        const graphics_t::sdf_style_t &style)
+{
+   if (!valid()) {
+      return;
+   }
+
+   const float scale = pixel_height / float(m_base_pixel_height);
+   vector2_t pen{ float(position.x), float(position.y) + m_ascent * scale };
+
+   const char *end = text.data() + text.size();
+   for (const char *it = text.data(); it != end;) {
+      const uint32_t character_codepoint = bitmap_font_t::decode_utf8(it, end);
+
+      if (character_codepoint == newline_character_codepoint) {
+         pen.x = float(position.x);
+         pen.y += line_height(pixel_height);
+         continue;
+      }
+
+      const glyph_t *glyph = find_or_invalid(character_codepoint);
+      if (glyph == nullptr) {
+         continue;
+      }
+
+      if (glyph->m_source.w > 0) {
+         const vector2_t origin{ pen.x + glyph->m_offset.x * scale, pen.y + glyph->m_offset.y * scale };
+         const vector2_t size{ glyph->m_source.w * scale, glyph->m_source.h * scale };
+         graphics.draw_sdf(m_texture, glyph->m_source, origin, size, style, color);
+      }
+
+      pen.x += glyph->m_advance_x * scale;
+   }
+}
+
+point_t sdf_font_t::calculate_bounds(const std::string_view &text, const float pixel_height) const
+{
+   const float scale = pixel_height / float(m_base_pixel_height);
+
+   float pen_x = 0.0f;
+   float width = 0.0f;
+   float height = 0.0f;
+
+   const char *end = text.data() + text.size();
+   for (const char *it = text.data(); it != end;) {
+      const uint32_t character_codepoint = bitmap_font_t::decode_utf8(it, end);
+
+      if (character_codepoint == newline_character_codepoint) {
+         pen_x = 0.0f;
+         height += line_height(pixel_height);
+         continue;
+      }
+
+      const glyph_t *glyph = find_or_invalid(character_codepoint);
+      if (glyph != nullptr) {
+         pen_x += glyph->m_advance_x * scale;
+         width = std::max(width, pen_x);
+      }
+   }
+
+   return { int(std::ceil(width)), int(std::ceil(height)) };
+}
+
+float sdf_font_t::texels_per_pixel(const float pixel_height) const
+{
+   return float(m_base_pixel_height) / pixel_height;
+}
+
+float sdf_font_t::line_height(const float pixel_height) const
+{
+   return m_line_height * (pixel_height / float(m_base_pixel_height));
+}
+
+const sdf_font_t::glyph_t *sdf_font_t::find(const uint32_t codepoint) const
+{
+   auto it = std::lower_bound(m_glyphs.begin(), m_glyphs.end(), codepoint, [](auto &lhs, uint32_t rhs) {
+      return lhs.m_codepoint < rhs;
+   });
+
+   if (it == m_glyphs.end() || it->m_codepoint != codepoint) {
+      return nullptr;
+   }
+
+   return &*it;
+}
+
+const sdf_font_t::glyph_t *sdf_font_t::find_or_invalid(const uint32_t codepoint) const
+{
+   const glyph_t *glyph = find(codepoint);
+   if (glyph == nullptr && m_invalid_glyph != 0) {
+      glyph = &m_glyphs[m_invalid_glyph - 1];
+   }
+
+   return glyph;
+}
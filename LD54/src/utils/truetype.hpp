@@ -0,0 +1,134 @@
+// truetype.hpp
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+struct stbtt_fontinfo;
+
+// note: glyphs are rasterized on first use into a shelf packed atlas,
+//       when the atlas is full the least recently used shelf is evicted.
+struct truetype_font_t {
+   static constexpr uint32_t invalid_character_codepoint = '?';
+   static constexpr uint32_t newline_character_codepoint = '\n';
+   static constexpr int      glyph_padding = 1;
+   static constexpr int      shelf_granularity = 4;
+
+   struct glyph_t {
+      rectangle_t m_source;
+      point_t     m_offset;
+      float       m_advance_x = 0.0f;
+      int         m_shelf = -1;
+   };
+
+   struct shelf_t {
+      int                   m_y = 0;
+      int                   m_height = 0;
+      int                   m_cursor_x = 0;
+      uint32_t              m_last_used = 0;
+      std::vector<uint64_t> m_keys;
+   };
+
+   struct stats_t {
+      uint32_t glyphs_cached = 0;
+      uint32_t glyphs_rasterized = 0;
+      uint32_t shelves_evicted = 0;
+      uint32_t uploads = 0;
+      uint32_t misses = 0;
+   };
+
+   truetype_font_t();
+   ~truetype_font_t();
+
+   bool valid() const;
+   bool create_from_file(const char *path, const int pixel_height, const point_t &atlas_size = { 512, 512 });
+   bool create_from_memory(std::vector<uint8_t> content, const int pixel_height, const point_t &atlas_size = { 512, 512 });
+   void destroy();
+
+   // note: advances the lru clock, glyphs used in the current frame are never evicted.
+   //       call it once a frame wherever the font renders, without it no shelf
+   //       ever goes stale and a full atlas misses every new glyph.
+   void next_frame();
+   // note: uploads every atlas change since the last flush as a single sub-rectangle
+   void flush();
+
+   void render(graphics_t &graphics, const point_t &position, const std::string_view &text, const color_t &color, const int scale = 1);
+   point_t calculate_bounds(const std::string_view &text, const int scale = 1);
+
+   void set_pixel_height(const int pixel_height);
+   int line_height(const int scale = 1) const;
+   const stats_t &stats() const;
+
+private:
+   const glyph_t *find(const uint32_t codepoint, const int pixel_height);
+   bool allocate(const point_t &size, rectangle_t &result, int &shelf_index);
+   void evict(shelf_t &shelf);
+   void merge(const int first, const int last, const int height);
+   void mark_dirty(const rectangle_t &area);
+
+   std::unique_ptr<stbtt_fontinfo>       m_info;
+   std::vector<uint8_t>                  m_content;
+   texture_t                             m_texture;
+   std::vector<uint32_t>                 m_pixels;
+   std::vector<uint8_t>                  m_scratch;
+   std::vector<shelf_t>                  m_shelves;
+   std::unordered_map<uint64_t, glyph_t> m_glyphs;
+   rectangle_t                           m_dirty;
+   int                                   m_next_shelf_y = 0;
+   int                                   m_pixel_height = 16;
+   uint32_t                              m_frame = 1;
+   glyph_t                               m_uncached;
+   stats_t                               m_stats;
+};
+
+// note: distance field glyphs are baked once at a base pixel height,
+//       one atlas then serves every size with outline and shadow in the shader.
+//       no font ships in data yet, so the game never creates one and the
+//       overlay stays on the bitmap font until one is set with set_sdf_font.
+struct sdf_font_t {
+   static constexpr uint32_t invalid_character_codepoint = '?';
+   static constexpr uint32_t newline_character_codepoint = '\n';
+   static constexpr int      glyph_spacing = 1;
+
+   struct glyph_t {
+      uint32_t    m_codepoint = 0;
+      rectangle_t m_source;
+      vector2_t   m_offset;
+      float       m_advance_x = 0.0f;
+   };
+
+   sdf_font_t();
+   ~sdf_font_t();
+
+   bool valid() const;
+   bool create_from_file(const char *path,
+                         const int base_pixel_height = 32,
+                         const int padding = 4,
+                         const point_t &atlas_size = { 512, 512 });
+   bool create_from_memory(const std::vector<uint8_t> &content,
+                           const int base_pixel_height = 32,
+                           const int padding = 4,
+                           const point_t &atlas_size = { 512, 512 });
+   void destroy();
+
+   void render(graphics_t &graphics, const point_t &position, const std::string_view &text, const color_t &color, const float pixel_height);
+   void render(graphics_t &graphics, const point_t &position, const std::string_view &text, const color_t &color, const float pixel_height,
+               const graphics_t::sdf_style_t &style);
+   point_t calculate_bounds(const std::string_view &text, const float pixel_height) const;
+
+   // note: converts a distance in output pixels into source texels for style offsets
+   float texels_per_pixel(const float pixel_height) const;
+   float line_height(const float pixel_height) const;
+   const glyph_t *find(const uint32_t codepoint) const;
+   const glyph_t *find_or_invalid(const uint32_t codepoint) const;
+
+   texture_t            m_texture;
+   std::vector<glyph_t> m_glyphs;
+   // note: index + 1 into m_glyphs, zero when the font has no '?'
+   uint32_t             m_invalid_glyph = 0;
+   int                  m_base_pixel_height = 0;
+   int                  m_padding = 0;
+   float                m_ascent = 0.0f;
+   float                m_line_height = 0.0f;
+};
@@ -0,0 +1,71 @@
+// audio_resample_test.cpp
+
+#include "awry/awry_audio.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+   constexpr double pi = 3.14159265358979323846;
+   constexpr int source_rate = 44100;
+   constexpr int source_frame_count = source_rate;
+   constexpr int output_frame_count = 4096;
+
+   // note: rms of the output after reading a full scale tone at step, skipping the kernel warm up
+   double resampled_rms(const double frequency, const double step, const int channel_count)
+   {
+      std::vector<short> samples(size_t(source_frame_count) * channel_count);
+      for (int frame = 0; frame < source_frame_count; frame++) {
+         const short value = short(std::lround(32000.0 * std::sin(2.0 * pi * frequency * frame / source_rate)));
+         for (int channel = 0; channel < channel_count; channel++) {
+            samples[size_t(frame) * channel_count + channel] = value;
+         }
+      }
+
+      std::vector<float> bus(size_t(output_frame_count) * 2);
+      uint64_t position = uint64_t(64) << 32;
+      const uint64_t voice_step = uint64_t(step * double(audio_voice_t::unity_step));
+      audio_kernel_t::resample_sinc(bus.data(), samples.data(), channel_count, source_frame_count, position, voice_step, output_frame_count, 1.0f);
+
+      double sum = 0.0;
+      for (int frame = 0; frame < output_frame_count; frame++) {
+         sum += double(bus[size_t(frame) * 2]) * bus[size_t(frame) * 2];
+      }
+
+      return std::sqrt(sum / output_frame_count) / (32000.0 / std::sqrt(2.0));
+   }
+} // !anon
+
+int main(int, char **)
+{
+   struct case_t {
+      double frequency;
+      double step;
+      double min_gain;
+      double max_gain;
+   };
+
+   // note: tones under the output nyquist pass, tones that would fold back get stopped
+   const case_t cases[] = {
+      {  1000.0, 1.0,  0.95, 1.05 },
+      {  2000.0, 2.0,  0.95, 1.05 },
+      {  1500.0, 3.5,  0.90, 1.05 },
+      { 15000.0, 2.0,  0.00, 0.05 },
+      { 18000.0, 1.5,  0.00, 0.05 },
+      { 12000.0, 4.0,  0.00, 0.05 },
+   };
+
+   int failures = 0;
+   for (const case_t &test : cases) {
+      for (int channel_count = 1; channel_count <= 2; channel_count++) {
+         const double gain = resampled_rms(test.frequency, test.step, channel_count);
+         const bool passed = gain >= test.min_gain && gain <= test.max_gain;
+         printf("%6.0f hz at step %.2f, %d channel(s): gain %.4f %s\n",
+                test.frequency, test.step, channel_count, gain, passed ? "ok" : "FAILED");
+         failures += passed ? 0 : 1;
+      }
+   }
+
+   return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,326 @@
+// inflate_test.cpp
+
+#include "awry/awry_inflate.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+#include <stb_image_write.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+   int g_failure_count = 0;
+
+   void expect(const bool condition, const char *what)
+   {
+      if (!condition) {
+         printf("FAILED: %s\n", what);
+         g_failure_count++;
+      }
+   }
+
+   // note: deflate packs fields from the lowest bit up and huffman codes from their top bit down
+   struct bit_writer_t {
+      void put(const uint32_t value, const int count)
+      {
+         for (int bit = 0; bit < count; bit++) {
+            if (m_bit_count % 8 == 0) {
+               m_bytes.push_back(0);
+            }
+
+            m_bytes.back() |= uint8_t(((value >> bit) & 1) << (m_bit_count % 8));
+            m_bit_count++;
+         }
+      }
+
+      void put_code(const uint32_t code, const int count)
+      {
+         for (int bit = count - 1; bit >= 0; bit--) {
+            put((code >> bit) & 1, 1);
+         }
+      }
+
+      void align()
+      {
+         m_bit_count = int(m_bytes.size()) * 8;
+      }
+
+      std::vector<uint8_t> m_bytes;
+      int                  m_bit_count = 0;
+   };
+
+   // note: text with short and long repeats so a compressor emits matches of every reach
+   std::vector<uint8_t> make_source(const size_t size)
+   {
+      const char *words[] = { "space ", "ship ", "cannon ", "boom ", "ready ", "cargo ", "hull ", "\n" };
+      std::vector<uint8_t> result;
+      uint32_t state = 0x2545f491;
+      while (result.size() < size) {
+         state = state * 1664525u + 1013904223u;
+         if ((state >> 28) == 0 && result.size() > 40000) {
+            const size_t from = result.size() - 40000 + (state >> 8) % 8000;
+            for (size_t index = 0; index < 300 && result.size() < size; index++) {
+               result.push_back(result[from + index]);
+            }
+            continue;
+         }
+
+         for (const char *word = words[(state >> 24) % 8]; *word != 0 && result.size() < size; word++) {
+            result.push_back(uint8_t(*word));
+         }
+      }
+
+      return result;
+   }
+
+   // note: strips the zlib header and adler trailer that stb_image_write adds
+   std::vector<uint8_t> compress_fixed(const std::vector<uint8_t> &source)
+   {
+      int length = 0;
+      unsigned char *zlib = stbi_zlib_compress(const_cast<uint8_t *>(source.data()), int(source.size()), &length, 8);
+      std::vector<uint8_t> result(zlib + 2, zlib + length - 4);
+      STBIW_FREE(zlib);
+      return result;
+   }
+
+   std::vector<uint8_t> store(const std::vector<uint8_t> &source)
+   {
+      bit_writer_t writer;
+      size_t offset = 0;
+      do {
+         const size_t length = std::min<size_t>(source.size() - offset, 65535);
+         const bool final = offset + length == source.size();
+         writer.put(final ? 1 : 0, 1);
+         writer.put(0, 2);
+         writer.align();
+         writer.put(uint32_t(length), 16);
+         writer.put(uint32_t(~length & 0xffff), 16);
+         writer.m_bytes.insert(writer.m_bytes.end(), source.begin() + offset, source.begin() + offset + length);
+         writer.m_bit_count += int(length) * 8;
+         offset += length;
+      } while (offset < source.size());
+
+      return writer.m_bytes;
+   }
+
+   // note: the png's image data, a zlib stream of dynamic blocks
+   std::vector<uint8_t> png_image_data(const char *path)
+   {
+      std::vector<uint8_t> file;
+      if (FILE *handle = std::fopen(path, "rb")) {
+         uint8_t buffer[4096];
+         for (size_t count; (count = std::fread(buffer, 1, sizeof(buffer), handle)) != 0;) {
+            file.insert(file.end(), buffer, buffer + count);
+         }
+         std::fclose(handle);
+      }
+
+      std::vector<uint8_t> result;
+      for (size_t offset = 8; offset + 12 <= file.size();) {
+         const uint32_t length = uint32_t(file[offset]) << 24 | uint32_t(file[offset + 1]) << 16 | uint32_t(file[offset + 2]) << 8 | file[offset + 3];
+         if (offset + 12 + length > file.size()) {
+            break;
+         }
+
+         if (std::memcmp(file.data() + offset + 4, "IDAT", 4) == 0) {
+            result.insert(result.end(), file.begin() + offset + 8, file.begin() + offset + 8 + length);
+         }
+
+         offset += 12 + length;
+      }
+
+      return result;
+   }
+
+   // note: the whole stream at once into an output with guard bytes on either side
+   bool decompress_guarded(const std::vector<uint8_t> &stream, const size_t output_size, std::vector<uint8_t> &output, bool &guard_intact)
+   {
+      constexpr size_t guard_size = 64;
+      std::vector<uint8_t> buffer(output_size + guard_size * 2, 0xa5);
+      size_t written = 0;
+      const bool result = inflate_t::decompress(stream, std::span<uint8_t>(buffer.data() + guard_size, output_size), written);
+
+      guard_intact = written <= output_size;
+      for (size_t index = 0; index < guard_size; index++) {
+         guard_intact = guard_intact && buffer[index] == 0xa5 && buffer[buffer.size() - 1 - index] == 0xa5;
+      }
+
+      output.assign(buffer.begin() + guard_size, buffer.begin() + guard_size + std::min(written, output_size));
+      return result;
+   }
+
+   // note: input trickles in and output is handed out a little at a time, as the zip stream does
+   bool decompress_streaming(const std::vector<uint8_t> &stream, const size_t input_step, const size_t output_step, std::vector<uint8_t> &output)
+   {
+      std::unique_ptr<inflate_t> inflater(new inflate_t);
+      inflater->reset();
+
+      const uint8_t *input = stream.data();
+      const uint8_t *input_end = stream.data();
+      uint8_t *out = output.data();
+      for (;;) {
+         const bool input_final = input_end == stream.data() + stream.size();
+         uint8_t *output_end = std::min(out + output_step, output.data() + output.size());
+         switch (inflater->inflate(input, input_end, input_final, output.data(), out, output_end)) {
+            case inflate_t::status_t::done:
+               return out == output.data() + output.size();
+            case inflate_t::status_t::error:
+               return false;
+            case inflate_t::status_t::need_input:
+               if (input_final) {
+                  return false;
+               }
+               input_end = std::min(input_end + input_step, stream.data() + stream.size());
+               break;
+            case inflate_t::status_t::need_output:
+               if (out == output.data() + output.size()) {
+                  return false;
+               }
+               break;
+         }
+      }
+   }
+
+   void check_round_trip(const char *name, const std::vector<uint8_t> &stream, const std::vector<uint8_t> &expected)
+   {
+      char what[128];
+      bool guard_intact = false;
+      std::vector<uint8_t> output;
+      const bool result = decompress_guarded(stream, expected.size(), output, guard_intact);
+      snprintf(what, sizeof(what), "%s decompresses in one call", name);
+      expect(result && guard_intact && output == expected, what);
+
+      // note: an output one byte short has to stop at its end
+      snprintf(what, sizeof(what), "%s into a short output", name);
+      expect(!decompress_guarded(stream, expected.size() - 1, output, guard_intact) && guard_intact, what);
+
+      const size_t steps[][2] = { { 1, 1 }, { 7, 300 }, { 600, 1 }, { 4096, 70000 } };
+      for (const auto &step : steps) {
+         std::vector<uint8_t> streamed(expected.size());
+         snprintf(what, sizeof(what), "%s streamed %zu bytes in, %zu bytes out at a time", name, step[0], step[1]);
+         expect(decompress_streaming(stream, step[0], step[1], streamed) && streamed == expected, what);
+      }
+
+      // note: any cut short stream fails, without reading or writing past either end
+      int accepted = 0;
+      int overruns = 0;
+      const size_t stride = std::max<size_t>(1, stream.size() / 509);
+      for (size_t length = 0; length < stream.size(); length += stride) {
+         const std::vector<uint8_t> truncated(stream.begin(), stream.begin() + length);
+         accepted += decompress_guarded(truncated, expected.size(), output, guard_intact) ? 1 : 0;
+         overruns += guard_intact ? 0 : 1;
+      }
+
+      snprintf(what, sizeof(what), "%s truncated is rejected", name);
+      expect(accepted == 0 && overruns == 0, what);
+
+      // note: flipped bits may still decode to something, they must never overrun the output
+      overruns = 0;
+      uint32_t state = 0x9e3779b9;
+      for (int attempt = 0; attempt < 500; attempt++) {
+         std::vector<uint8_t> corrupt = stream;
+         state = state * 1664525u + 1013904223u;
+         corrupt[(state >> 8) % corrupt.size()] ^= uint8_t(1 << (state >> 29));
+         decompress_guarded(corrupt, expected.size(), output, guard_intact);
+         overruns += guard_intact ? 0 : 1;
+      }
+
+      snprintf(what, sizeof(what), "%s corrupted stays inside its output", name);
+      expect(overruns == 0, what);
+   }
+
+   // note: streams that are malformed by construction
+   void check_malformed()
+   {
+      std::vector<uint8_t> output;
+      bool guard_intact = false;
+
+      bit_writer_t reserved;
+      reserved.put(1, 1);
+      reserved.put(3, 2);
+      expect(!decompress_guarded(reserved.m_bytes, 16, output, guard_intact) && guard_intact, "reserved block type is rejected");
+
+      bit_writer_t mismatched;
+      mismatched.put(1, 1);
+      mismatched.put(0, 2);
+      mismatched.align();
+      mismatched.put(4, 16);
+      mismatched.put(4, 16);
+      mismatched.put(0x64636261, 32);
+      expect(!decompress_guarded(mismatched.m_bytes, 16, output, guard_intact) && guard_intact, "stored length that does not match its complement is rejected");
+
+      // note: fixed block, literal 'a' then length 3 at distance 2, one byte further back than written
+      bit_writer_t too_far;
+      too_far.put(1, 1);
+      too_far.put(1, 2);
+      too_far.put_code(0x30 + 'a', 8);
+      too_far.put_code(1, 7);
+      too_far.put_code(1, 5);
+      too_far.put_code(0, 7);
+      expect(!decompress_guarded(too_far.m_bytes, 16, output, guard_intact) && guard_intact, "distance before the start of the output is rejected");
+
+      // note: the same block at distance 1 is valid and repeats the literal
+      bit_writer_t repeat;
+      repeat.put(1, 1);
+      repeat.put(1, 2);
+      repeat.put_code(0x30 + 'a', 8);
+      repeat.put_code(1, 7);
+      repeat.put_code(0, 5);
+      repeat.put_code(0, 7);
+      expect(decompress_guarded(repeat.m_bytes, 4, output, guard_intact) && output == std::vector<uint8_t>(4, 'a'), "distance one repeats the last byte");
+
+      // note: literal/length symbol 286 only exists in the fixed code, it must not decode
+      bit_writer_t invalid_symbol;
+      invalid_symbol.put(1, 1);
+      invalid_symbol.put(1, 2);
+      invalid_symbol.put_code(0xc6, 8);
+      invalid_symbol.put_code(0, 7);
+      expect(!decompress_guarded(invalid_symbol.m_bytes, 16, output, guard_intact) && guard_intact, "reserved length symbol is rejected");
+   }
+} // !anon
+
+int main(int argc, char **argv)
+{
+   if (argc < 2) {
+      printf("usage: inflate_test <png>\n");
+      return 1;
+   }
+
+   const std::vector<uint8_t> source = make_source(200000);
+   check_round_trip("stored", store(source), source);
+   check_round_trip("fixed", compress_fixed(source), source);
+
+   const std::vector<uint8_t> empty;
+   std::vector<uint8_t> output;
+   bool guard_intact = false;
+   expect(decompress_guarded(store(empty), 0, output, guard_intact) && guard_intact, "empty stored block");
+
+   // note: stb_image decodes the reference, the zlib header is two bytes and the adler trailer four
+   const std::vector<uint8_t> image_data = png_image_data(argv[1]);
+   int expected_length = 0;
+   char *expected = image_data.size() > 6 ? stbi_zlib_decode_malloc((const char *)image_data.data(), int(image_data.size()), &expected_length) : nullptr;
+   expect(expected != nullptr, "png image data found and decoded by stb_image");
+   if (expected != nullptr) {
+      const std::vector<uint8_t> dynamic(image_data.begin() + 2, image_data.end() - 4);
+      check_round_trip("dynamic", dynamic, std::vector<uint8_t>(expected, expected + expected_length));
+      STBI_FREE(expected);
+   }
+
+   check_malformed();
+
+   printf("%d failure(s)\n", g_failure_count);
+   return g_failure_count == 0 ? 0 : 1;
+}
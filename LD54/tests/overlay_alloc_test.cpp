@@ -0,0 +1,187 @@
+// overlay_alloc_test.cpp
+
+#include "awry/awry.h"
+#include "utils/colors.hpp"
+#include "utils/font.hpp"
+#include "utils/truetype.hpp"
+#include "utils/overlay.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// note: every heap allocation in the process goes through here
+static size_t g_allocation_count = 0;
+static size_t g_mismatch_count = 0;
+
+void *operator new(size_t size)
+{
+   g_allocation_count++;
+   if (void *result = std::malloc(size != 0 ? size : 1)) {
+      return result;
+   }
+
+   throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+   return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+   std::free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+   std::free(pointer);
+}
+
+// note: headless stand-ins, the overlay only needs a texture to point at
+bool texture_t::valid() const
+{
+   return m_id != 0;
+}
+
+bool texture_t::create(const point_t &size, const void *, const filter_t, const address_mode_t)
+{
+   m_id = 1;
+   m_size = size;
+   return true;
+}
+
+bool texture_t::update(const rectangle_t &, const void *, const int)
+{
+   return valid();
+}
+
+void texture_t::destroy()
+{
+   m_id = 0;
+}
+
+namespace
+{
+   struct counting_graphics_t final : graphics_t {
+      void clear(const color_t &) override {}
+      void projection(const vector2_t &) override {}
+      void antialiasing(const bool) override {}
+      void draw_rect_filled(const rectangle_t &, const color_t &) override {}
+      void draw_rect_filled(const rectangle_t &, const matrix3_t &, const color_t &) override {}
+      void draw_rect_outlined(const rectangle_t &, const float, const color_t &) override {}
+      void draw_rect_outlined(const rectangle_t &, const float, const matrix3_t &, const color_t &) override {}
+      void draw_circle_filled(const vector2_t &, const float, const int, const color_t &) override {}
+      void draw_circle_filled(const vector2_t &, const float, const int, const color_t &, const color_t &) override {}
+      void draw_circle_outlined(const vector2_t &, const float, const int, const float, const color_t &) override {}
+      void draw_circle_segment(const vector2_t &, const float, const int, const float, const float, const color_t &) override {}
+      void draw_circle_segment(const vector2_t &, const float, const int, const float, const float, const float, const color_t &) override {}
+      void draw_line(const vector2_t &, const vector2_t &, const float, const color_t &) override {}
+      void draw_line(const vector2_t &, const vector2_t &, const float, const color_t &, const color_t &) override {}
+      void draw_line_strip(const std::span<const vector2_t>, const float, const color_t &) override {}
+      void draw_line_strip(const std::span<const vector2_t>, const float, const bool, const line_join_t, const color_t &) override {}
+      void draw_triangles_filled(const std::span<const vector2_t>, const color_t &) override {}
+      void draw(const texture_t &, const rectangle_t &, const rectangle_t &, const color_t &) override { m_quad_count++; }
+      void draw(const texture_t &, const rectangle_t &, const rectangle_t &, const matrix3_t &, const color_t &) override { m_quad_count++; }
+      void draw_sdf(const texture_t &, const rectangle_t &, const vector2_t &, const vector2_t &, const sdf_style_t &, const color_t &) override {}
+      void draw_polygon_filled(const std::span<const vector2_t>, const color_t &) override {}
+      void draw_polygon_filled(const std::span<const vector2_t>, const matrix3_t &, const color_t &) override {}
+      void draw_polygon_outlined(const std::span<const vector2_t>, const float, const color_t &) override {}
+      void draw_polygon_outlined(const std::span<const vector2_t>, const float, const matrix3_t &, const color_t &) override {}
+      void execute() override {}
+
+      size_t m_quad_count = 0;
+   };
+
+   // note: what the game writes each frame, numbers change every frame and
+   //       every fourth frame a line is inserted at the top.
+   void draw_frame(overlay_t &overlay, graphics_t &graphics, const int frame)
+   {
+      overlay.clear();
+      if (frame % 4 == 0) {
+         overlay.draw_text_va(color_t{}, "frame %d", frame);
+      }
+
+      for (int index = 0; index < 32; index++) {
+         overlay.draw_text_va(color_t{}, "line %d: %d,%d (vel: %1.3f acc: %2.3f)", index, frame, frame * 2, frame * 0.5f, 1.25f);
+      }
+
+      overlay.draw_text_va(color_t{}, "trail: %d angle: %3.3f %s", frame, frame * 0.25f, "deg");
+      overlay.draw_text_va(color_t{}, "sounds: %u %s in %1.3f ms", 12u, frame % 2 ? "mapped" : "decoded", 0.5);
+      for (int index = 0; index < 16; index++) {
+         overlay.draw_text_va(color_t{}, "static %d", index % 12);
+      }
+
+      overlay.render(graphics);
+
+      // note: every line has to be drawn from a mesh of its own text
+      for (size_t index = 0; index < overlay.m_lines.size(); index++) {
+         const text_mesh_t &mesh = overlay.m_meshes[overlay.m_line_meshes[index]].mesh;
+         if (mesh.m_text != overlay.text(overlay.m_lines[index])) {
+            g_mismatch_count++;
+         }
+      }
+   }
+} // !anon
+
+int main()
+{
+   texture_t texture;
+   texture.create({ 128, 48 }, nullptr);
+
+   bitmap_font_t font(texture);
+   bitmap_font_t::construct_monospaced_font(font, { 16, 6 }, { 8, 8 });
+
+   overlay_t overlay(font);
+   counting_graphics_t graphics;
+
+   // note: the arena, line list and meshes grow until they fit the busiest frame
+   const int warm_up_frame_count = 16;
+   const int measured_frame_count = 1000;
+   for (int frame = 0; frame < warm_up_frame_count; frame++) {
+      draw_frame(overlay, graphics, frame);
+   }
+
+   const size_t quad_count = graphics.m_quad_count;
+   const size_t allocation_count = g_allocation_count;
+   for (int frame = warm_up_frame_count; frame < warm_up_frame_count + measured_frame_count; frame++) {
+      draw_frame(overlay, graphics, frame);
+   }
+
+   const size_t allocations = g_allocation_count - allocation_count;
+   printf("%d frames, %zu quads drawn, %zu heap allocations, %zu meshes for %zu lines\n",
+          measured_frame_count, graphics.m_quad_count - quad_count, allocations, overlay.m_meshes.size(), overlay.m_lines.size());
+   if (g_mismatch_count != 0) {
+      printf("%zu lines drawn from a mesh of other text\n", g_mismatch_count);
+      return 1;
+   }
+
+   // note: a line that does not fit the rest of the arena is formatted again after growing it
+   overlay.clear();
+   overlay.draw_text_va(color_t{}, "%d,%u (%1.3f) %s", -3, 7u, 2.0f / 3.0f, "done");
+   overlay.draw_text_va(color_t{}, "%*d", int(overlay_t::initial_arena_size), 42);
+   const std::string_view formatted = overlay.text(overlay.m_lines.front());
+   const std::string_view expected = "-3,7 (0.667) done";
+   const std::string_view padded = overlay.text(overlay.m_lines.back());
+   if (formatted != expected) {
+      printf("formatted \"%.*s\", expected \"%.*s\"\n", int(formatted.size()), formatted.data(), int(expected.size()), expected.data());
+      return 1;
+   }
+
+   if (padded.size() != overlay_t::initial_arena_size || padded.substr(padded.size() - 3) != " 42") {
+      printf("long line formatted to %zu characters\n", padded.size());
+      return 1;
+   }
+
+   return allocations == 0 && graphics.m_quad_count > quad_count ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// text_layout_test.cpp
+
+#include "awry/awry.h"
+#include "utils/font.hpp"
+#include "utils/layout.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// note: headless stand-ins, the font only needs a texture to point at
+bool texture_t::valid() const
+{
+   return m_id != 0;
+}
+
+bool texture_t::create(const point_t &size, const void *, const filter_t, const address_mode_t)
+{
+   m_id = 1;
+   m_size = size;
+   return true;
+}
+
+bool texture_t::update(const rectangle_t &, const void *, const int)
+{
+   return valid();
+}
+
+void texture_t::destroy()
+{
+   m_id = 0;
+}
+
+namespace
+{
+   int g_failure_count = 0;
+
+   void expect(const bool condition, const char *what)
+   {
+      if (!condition) {
+         printf("FAILED: %s\n", what);
+         g_failure_count++;
+      }
+   }
+
+   struct recording_graphics_t final : graphics_t {
+      struct quad_t {
+         rectangle_t source;
+         rectangle_t dest;
+      };
+
+      void clear(const color_t &) override {}
+      void projection(const vector2_t &) override {}
+      void antialiasing(const bool) override {}
+      void draw_rect_filled(const rectangle_t &, const color_t &) override {}
+      void draw_rect_filled(const rectangle_t &, const matrix3_t &, const color_t &) override {}
+      void draw_rect_outlined(const rectangle_t &, const float, const color_t &) override {}
+      void draw_rect_outlined(const rectangle_t &, const float, const matrix3_t &, const color_t &) override {}
+      void draw_circle_filled(const vector2_t &, const float, const int, const color_t &) override {}
+      void draw_circle_filled(const vector2_t &, const float, const int, const color_t &, const color_t &) override {}
+      void draw_circle_outlined(const vector2_t &, const float, const int, const float, const color_t &) override {}
+      void draw_circle_segment(const vector2_t &, const float, const int, const float, const float, const color_t &) override {}
+      void draw_circle_segment(const vector2_t &, const float, const int, const float, const float, const float, const color_t &) override {}
+      void draw_line(const vector2_t &, const vector2_t &, const float, const color_t &) override {}
+      void draw_line(const vector2_t &, const vector2_t &, const float, const color_t &, const color_t &) override {}
+      void draw_line_strip(const std::span<const vector2_t>, const float, const color_t &) override {}
+      void draw_line_strip(const std::span<const vector2_t>, const float, const bool, const line_join_t, const color_t &) override {}
+      void draw_triangles_filled(const std::span<const vector2_t>, const color_t &) override {}
+      void draw(const texture_t &, const rectangle_t &src, const rectangle_t &dst, const color_t &) override { m_quads.push_back({ src, dst }); }
+      void draw(const texture_t &, const rectangle_t &src, const rectangle_t &dst, const matrix3_t &, const color_t &) override { m_quads.push_back({ src, dst }); }
+      void draw_sdf(const texture_t &, const rectangle_t &, const vector2_t &, const vector2_t &, const sdf_style_t &, const color_t &) override {}
+      void draw_polygon_filled(const std::span<const vector2_t>, const color_t &) override {}
+      void draw_polygon_filled(const std::span<const vector2_t>, const matrix3_t &, const color_t &) override {}
+      void draw_polygon_outlined(const std::span<const vector2_t>, const float, const color_t &) override {}
+      void draw_polygon_outlined(const std::span<const vector2_t>, const float, const matrix3_t &, const color_t &) override {}
+      void execute() override {}
+
+      std::vector<quad_t> m_quads;
+   };
+
+   bool same(const rectangle_t &lhs, const rectangle_t &rhs)
+   {
+      return lhs.x == rhs.x && lhs.y == rhs.y && lhs.w == rhs.w && lhs.h == rhs.h;
+   }
+
+   // note: position of the glyph drawn for the character at offset in the text
+   point_t glyph_at(const text_layout_t &layout, const uint32_t offset)
+   {
+      for (const text_mesh_t::quad_t &quad : layout.m_mesh.m_quads) {
+         if (quad.m_offset == offset) {
+            return quad.m_dest.xy();
+         }
+      }
+
+      return { -1, -1 };
+   }
+
+   bool at(const text_layout_t &layout, const uint32_t offset, const point_t &expected)
+   {
+      const point_t position = glyph_at(layout, offset);
+      return position.x == expected.x && position.y == expected.y;
+   }
+} // !anon
+
+int main(int, char **)
+{
+   // note: the game's font, 8 by 8 glyphs that advance 8 with lines 10 apart
+   texture_t texture;
+   texture.create({ 128, 48 }, nullptr);
+
+   bitmap_font_t font(texture);
+   bitmap_font_t::construct_monospaced_font(font, { 16, 6 }, { 8, 8 });
+
+   { // note: wrapping
+      text_layout_engine_t engine;
+
+      const text_layout_t &unwrapped = engine.layout(font, "hello world foo");
+      expect(unwrapped.m_line_count == 1 && unwrapped.m_size.x == 120 && unwrapped.m_size.y == 10, "no width keeps one line");
+
+      const text_layout_t &words = engine.layout(font, "hello world foo", 64);
+      expect(words.m_line_count == 3 && words.m_size.x == 64 && words.m_size.y == 30, "words wrap at the width");
+      expect(at(words, 0, { 0, 0 }) && at(words, 6, { 0, 10 }) && at(words, 12, { 0, 20 }), "wrapped words start their lines");
+      expect(at(words, 10, { 32, 10 }), "carried word keeps its spacing");
+
+      const text_layout_t &long_word = engine.layout(font, "abcdefghij", 32);
+      expect(long_word.m_line_count == 3 && at(long_word, 4, { 0, 10 }) && at(long_word, 8, { 0, 20 }), "word wider than the width breaks anywhere");
+
+      const text_layout_t &newlines = engine.layout(font, "a\nb", 64);
+      expect(newlines.m_line_count == 2 && at(newlines, 2, { 0, 10 }), "newline starts a line");
+
+      const text_layout_t &scaled = engine.layout(font, "ab cd", 40, 2);
+      expect(scaled.m_line_count == 2 && scaled.m_size.y == 40 && at(scaled, 3, { 0, 20 }) && at(scaled, 4, { 16, 20 }), "scale applies to wrapping and spacing");
+   }
+
+   { // note: alignment, against the widest line without a width and the width otherwise
+      text_layout_engine_t engine;
+
+      const text_layout_t &center = engine.layout(font, "ab\nabcd", 0, 1, text_align_t::center);
+      expect(center.m_size.x == 32 && at(center, 0, { 8, 0 }) && at(center, 3, { 0, 10 }), "center aligns to the widest line");
+
+      const text_layout_t &right = engine.layout(font, "ab\nabcd", 0, 1, text_align_t::right);
+      expect(at(right, 0, { 16, 0 }) && at(right, 3, { 0, 10 }), "right aligns to the widest line");
+
+      const text_layout_t &boxed = engine.layout(font, "ab\nabcd", 64, 1, text_align_t::right);
+      expect(boxed.m_size.x == 64 && at(boxed, 0, { 48, 0 }) && at(boxed, 3, { 32, 10 }), "right aligns to the width");
+
+      const text_layout_t &wrapped = engine.layout(font, "hello world", 64, 1, text_align_t::center);
+      expect(at(wrapped, 0, { 12, 0 }) && at(wrapped, 6, { 12, 10 }), "trailing space does not count towards centering");
+   }
+
+   { // note: clipping trims in whole source texels
+      text_layout_engine_t engine;
+      recording_graphics_t graphics;
+
+      const text_layout_t &layout = engine.layout(font, "abcd");
+      engine.render(graphics, layout, { 10, 20 }, rectangle_t{ 14, 22, 16, 100 }, color_t{});
+      expect(graphics.m_quads.size() == 3, "glyph outside the clip is skipped");
+      if (graphics.m_quads.size() == 3) {
+         const rectangle_t a = font.find('a')->m_source;
+         const rectangle_t c = font.find('c')->m_source;
+         expect(same(graphics.m_quads[0].source, { a.x + 4, a.y + 2, 4, 6 }) && same(graphics.m_quads[0].dest, { 14, 22, 4, 6 }), "left and top edges are trimmed");
+         expect(same(graphics.m_quads[1].dest, { 18, 22, 8, 6 }), "glyph inside is only trimmed by the top");
+         expect(same(graphics.m_quads[2].source, { c.x, c.y + 2, 4, 6 }) && same(graphics.m_quads[2].dest, { 26, 22, 4, 6 }), "right edge is trimmed");
+      }
+
+      graphics.m_quads.clear();
+      const text_layout_t &scaled = engine.layout(font, "a", 0, 2);
+      engine.render(graphics, scaled, { 0, 0 }, rectangle_t{ 3, 0, 100, 100 }, color_t{});
+      expect(graphics.m_quads.size() == 1 && same(graphics.m_quads[0].dest, { 4, 0, 12, 16 }) && graphics.m_quads[0].source.w == 6,
+             "scaled glyph is trimmed up to the next texel");
+
+      graphics.m_quads.clear();
+      engine.render(graphics, layout, { 10, 20 }, rectangle_t{ 0, 0, 10, 20 }, color_t{});
+      expect(graphics.m_quads.empty(), "text outside the clip draws nothing");
+   }
+
+   { // note: memoization
+      text_layout_engine_t engine;
+
+      std::string text = "sounds: 5 mapped";
+      const text_layout_t &first = engine.layout(font, text);
+      text.assign("sounds: 5 decoded");
+      const text_layout_t &second = engine.layout(font, std::string("sounds: 5 mapped"));
+      expect(&first == &second && engine.stats().hits == 1 && engine.stats().misses == 1, "same text hits after the caller's buffer changed");
+
+      engine.layout(font, "sounds: 5 mapped", 64);
+      engine.layout(font, "sounds: 5 mapped", 0, 2);
+      engine.layout(font, "sounds: 5 mapped", 0, 1, text_align_t::right);
+      expect(engine.stats().misses == 4, "width, scale and alignment are part of the key");
+
+      font.set_newline_spacing(12);
+      const text_layout_t &rebuilt = engine.layout(font, "a\nb");
+      expect(rebuilt.m_size.y == 24, "layout uses the current metrics");
+      font.set_newline_spacing(16);
+      const text_layout_t &changed = engine.layout(font, "a\nb");
+      expect(&changed == &rebuilt && changed.m_size.y == 32 && engine.stats().hits == 1, "font change lays out again in place");
+      font.set_newline_spacing(10);
+   }
+
+   { // note: eviction of layouts unused for a while
+      text_layout_engine_t engine;
+      for (size_t index = 0; index < text_layout_engine_t::max_layout_count; index++) {
+         engine.layout(font, std::to_string(index));
+      }
+
+      for (uint32_t frame = 0; frame <= text_layout_engine_t::stale_frame_count; frame++) {
+         engine.next_frame();
+      }
+
+      engine.layout(font, "new");
+      expect(engine.stats().evictions == text_layout_engine_t::max_layout_count, "stale layouts are evicted when full");
+      engine.layout(font, "0");
+      expect(engine.stats().misses == text_layout_engine_t::max_layout_count + 2, "evicted layout is laid out again");
+   }
+
+   { // note: eviction when everything is recent keeps this frame's layouts
+      text_layout_engine_t engine;
+      for (size_t index = 0; index < text_layout_engine_t::max_layout_count; index++) {
+         engine.layout(font, std::to_string(index));
+      }
+
+      engine.next_frame();
+      const text_layout_t &kept = engine.layout(font, "0");
+      const point_t kept_size = kept.m_size;
+      engine.layout(font, "new");
+      expect(engine.stats().evictions == text_layout_engine_t::max_layout_count - 1, "layouts not used this frame are evicted");
+      expect(kept.m_size.x == kept_size.x && kept.m_line_count == 1, "layout used this frame stays valid");
+      expect(&engine.layout(font, "0") == &kept && engine.stats().hits == 2, "layout used this frame still hits");
+      engine.layout(font, "1");
+      expect(engine.stats().misses == text_layout_engine_t::max_layout_count + 2, "evicted layout misses");
+   }
+
+   printf("%d failure(s)\n", g_failure_count);
+   return g_failure_count == 0 ? 0 : 1;
+}
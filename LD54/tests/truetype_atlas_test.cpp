@@ -0,0 +1,221 @@
+// truetype_atlas_test.cpp
+
+#include "awry/awry.h"
+#include "utils/font.hpp"
+#include "utils/truetype.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// note: headless stand-ins, the font only needs a texture to upload into
+bool texture_t::valid() const
+{
+   return m_id != 0;
+}
+
+bool texture_t::create(const point_t &size, const void *, const filter_t, const address_mode_t)
+{
+   m_id = 1;
+   m_size = size;
+   return true;
+}
+
+bool texture_t::update(const rectangle_t &, const void *, const int)
+{
+   return valid();
+}
+
+void texture_t::destroy()
+{
+   m_id = 0;
+}
+
+namespace
+{
+   int g_failure_count = 0;
+
+   void expect(const bool condition, const char *what)
+   {
+      if (!condition) {
+         printf("FAILED: %s\n", what);
+         g_failure_count++;
+      }
+   }
+
+   // note: big endian, as every truetype table is
+   struct table_writer_t {
+      void u16(const uint32_t value)
+      {
+         m_bytes.push_back(uint8_t(value >> 8));
+         m_bytes.push_back(uint8_t(value));
+      }
+
+      void u32(const uint32_t value)
+      {
+         u16(value >> 16);
+         u16(value & 0xffff);
+      }
+
+      void zeros(const size_t count)
+      {
+         m_bytes.insert(m_bytes.end(), count, 0);
+      }
+
+      std::vector<uint8_t> m_bytes;
+   };
+
+   // note: the smallest font stb_truetype loads. glyph one and up are squares 'A'
+   //       onwards, one em wide and heights[n] units tall, an em is 1000 units
+   //       and the ascent as well so a glyph of 1000 is pixel_height pixels tall.
+   std::vector<uint8_t> make_font(const std::vector<int> &heights)
+   {
+      const uint32_t glyph_count = uint32_t(heights.size()) + 1;
+
+      table_writer_t glyf;
+      table_writer_t loca;
+      table_writer_t hmtx;
+      loca.u32(0);
+      loca.u32(0);
+      hmtx.u16(1000);
+      hmtx.u16(0);
+      for (const int height : heights) {
+         glyf.u16(1);
+         glyf.u16(0);
+         glyf.u16(0);
+         glyf.u16(1000);
+         glyf.u16(uint32_t(height));
+         glyf.u16(3);
+         glyf.u16(0);
+         for (int point = 0; point < 4; point++) {
+            glyf.m_bytes.push_back(0x01);
+         }
+
+         const int16_t x[] = { 0, 1000, 0, -1000 };
+         const int16_t y[] = { 0, 0, int16_t(height), 0 };
+         for (const int16_t delta : x) {
+            glyf.u16(uint16_t(delta));
+         }
+         for (const int16_t delta : y) {
+            glyf.u16(uint16_t(delta));
+         }
+
+         loca.u32(uint32_t(glyf.m_bytes.size()));
+         hmtx.u16(1000);
+         hmtx.u16(0);
+      }
+
+      table_writer_t cmap;
+      cmap.u16(0);
+      cmap.u16(1);
+      cmap.u16(3);
+      cmap.u16(10);
+      cmap.u32(12);
+      cmap.u16(12);
+      cmap.u16(0);
+      cmap.u32(28);
+      cmap.u32(0);
+      cmap.u32(1);
+      cmap.u32('A');
+      cmap.u32('A' + glyph_count - 2);
+      cmap.u32(1);
+
+      table_writer_t head;
+      head.u32(0x00010000);
+      head.u32(0);
+      head.u32(0);
+      head.u32(0x5f0f3cf5);
+      head.u16(0);
+      head.u16(1000);
+      head.zeros(16);
+      head.zeros(8);
+      head.zeros(6);
+      head.u16(1);
+      head.u16(0);
+
+      table_writer_t hhea;
+      hhea.u32(0x00010000);
+      hhea.u16(1000);
+      hhea.u16(0);
+      hhea.u16(0);
+      hhea.zeros(24);
+      hhea.u16(glyph_count);
+
+      table_writer_t maxp;
+      maxp.u32(0x00005000);
+      maxp.u16(glyph_count);
+
+      const std::pair<const char *, const table_writer_t *> tables[] = {
+         { "cmap", &cmap }, { "glyf", &glyf }, { "head", &head }, { "hhea", &hhea },
+         { "hmtx", &hmtx }, { "loca", &loca }, { "maxp", &maxp },
+      };
+
+      table_writer_t font;
+      font.u32(0x00010000);
+      font.u16(uint32_t(std::size(tables)));
+      font.zeros(6);
+
+      uint32_t offset = uint32_t(12 + 16 * std::size(tables));
+      for (const auto &[tag, table] : tables) {
+         font.m_bytes.insert(font.m_bytes.end(), tag, tag + 4);
+         font.u32(0);
+         font.u32(offset);
+         font.u32(uint32_t(table->m_bytes.size()));
+         offset += uint32_t((table->m_bytes.size() + 3) & ~size_t(3));
+      }
+
+      for (const auto &[tag, table] : tables) {
+         font.m_bytes.insert(font.m_bytes.end(), table->m_bytes.begin(), table->m_bytes.end());
+         font.zeros(((table->m_bytes.size() + 3) & ~size_t(3)) - table->m_bytes.size());
+      }
+
+      return font.m_bytes;
+   }
+
+   // note: lays out text without drawing, which caches its glyphs the same way
+   //       rendering does. returns how many of them had to be rasterized.
+   uint32_t use(truetype_font_t &font, const char *text)
+   {
+      const uint32_t rasterized = font.stats().glyphs_rasterized;
+      font.calculate_bounds(text);
+      return font.stats().glyphs_rasterized - rasterized;
+   }
+} // !anon
+
+int main(int, char **)
+{
+   // note: at 16 pixels a square is 17 with padding on a 20 pixel shelf, the 64 pixel
+   //       atlas fits three shelves of three. 'J' is one more square, 'K' is twice
+   //       as tall and only fits two shelves merged into one.
+   const std::vector<int> heights = { 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 2000 };
+
+   truetype_font_t font;
+   expect(font.create_from_memory(make_font(heights), 16, { 64, 64 }), "generated font loads");
+
+   expect(use(font, "ABCDEFGHI") == 9, "first frame rasterizes every glyph");
+   expect(font.stats().misses == 0, "first frame fits the atlas");
+
+   // note: everything in the atlas was used this frame, nothing may be evicted for 'J'
+   expect(use(font, "J") == 0 && font.stats().misses == 1, "full atlas in use misses");
+   expect(font.stats().shelves_evicted == 0, "shelves used this frame are kept");
+
+   // note: next frame only DEF and GHI are used before 'J' asks for room, ABC goes
+   font.next_frame();
+   expect(use(font, "DEFGHI") == 0, "cached glyphs survive a frame");
+   expect(use(font, "J") == 1 && font.stats().shelves_evicted == 1, "least recently used shelf is evicted");
+   expect(use(font, "DEFGHI") == 0, "recently used shelves are not evicted");
+   expect(use(font, "A") == 1, "glyph of the evicted shelf is rasterized again");
+
+   // note: every shelf was used this frame, there is no stale run to merge for 'K' yet
+   expect(use(font, "K") == 0 && font.stats().misses == 2, "no stale run tall enough misses");
+
+   font.next_frame();
+   use(font, "JA");
+   expect(use(font, "K") == 1, "tall glyph fits once stale shelves merge");
+   expect(use(font, "JA") == 0, "shelf used this frame survives the merge");
+   expect(use(font, "D") == 1, "merged shelves lost their glyphs");
+
+   printf("%u glyphs cached, %u rasterized, %u shelves evicted, %u misses, %u uploads\n",
+          font.stats().glyphs_cached, font.stats().glyphs_rasterized, font.stats().shelves_evicted, font.stats().misses, font.stats().uploads);
+   printf("%d failure(s)\n", g_failure_count);
+   return g_failure_count == 0 ? 0 : 1;
+}
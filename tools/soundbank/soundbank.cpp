@@ -0,0 +1,149 @@
+// soundbank.cpp
+
+// note: converts .ogg files into one sound bank the game maps at startup
+//       usage: soundbank <output.bank> <input.ogg> [<input.ogg> ...]
+
+#include "awry/awry_soundbank.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define STB_VORBIS_HEADER_ONLY
+#include <stb_vorbis.h>
+
+namespace
+{
+   struct sound_t {
+      sound_bank_entry_t entry;
+      short             *samples = nullptr;
+   };
+
+   FILE *open_file(const char *path, const char *mode)
+   {
+#if defined(_MSC_VER)
+      FILE *file = nullptr;
+      return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+      return fopen(path, mode);
+#endif
+   }
+
+   std::string stem_of(const char *path)
+   {
+      std::string result = path;
+      const size_t slash = result.find_last_of("/\\");
+      if (slash != std::string::npos) {
+         result.erase(0, slash + 1);
+      }
+
+      const size_t dot = result.find_last_of('.');
+      if (dot != std::string::npos) {
+         result.erase(dot);
+      }
+
+      return result;
+   }
+
+   uint64_t align_up(const uint64_t value)
+   {
+      const uint64_t mask = sound_bank_header_t::alignment - 1;
+      return (value + mask) & ~mask;
+   }
+} // !anon
+
+int main(int argc, char **argv)
+{
+   if (argc < 3) {
+      fprintf(stderr, "usage: soundbank <output.bank> <input.ogg> [<input.ogg> ...]\n");
+      return 1;
+   }
+
+   std::vector<sound_t> sounds;
+   for (int index = 2; index < argc; index++) {
+      const std::string name = stem_of(argv[index]);
+      if (name.size() > size_t(sound_bank_entry_t::max_name_length)) {
+         fprintf(stderr, "error: name '%s' is longer than %d characters\n", name.c_str(), sound_bank_entry_t::max_name_length);
+         return 1;
+      }
+
+      int channels = 0;
+      int sample_rate = 0;
+      short *samples = nullptr;
+      const int frames = stb_vorbis_decode_filename(argv[index], &channels, &sample_rate, &samples);
+      if (frames <= 0 || samples == nullptr) {
+         fprintf(stderr, "error: could not decode '%s'\n", argv[index]);
+         return 1;
+      }
+
+      // note: the mixer plays mono and stereo only, the runtime loader skips anything else
+      if (channels < 1 || channels > 2) {
+         fprintf(stderr, "error: '%s' has %d channels, only mono and stereo are supported\n", argv[index], channels);
+         free(samples);
+         return 1;
+      }
+
+      sound_t sound;
+      memcpy(sound.entry.name, name.c_str(), name.size());
+      sound.entry.channel_count = uint32_t(channels);
+      sound.entry.sample_rate = uint32_t(sample_rate);
+      sound.entry.frame_count = uint32_t(frames);
+      sound.entry.size = uint64_t(frames) * channels * sizeof(short);
+      sound.samples = samples;
+      sounds.push_back(sound);
+   }
+
+   sound_bank_header_t header;
+   header.entry_count = uint32_t(sounds.size());
+
+   uint64_t offset = align_up(sizeof(header) + sizeof(sound_bank_entry_t) * sounds.size());
+   for (sound_t &sound : sounds) {
+      sound.entry.offset = offset;
+      offset = align_up(offset + sound.entry.size);
+   }
+
+   FILE *file = open_file(argv[1], "wb");
+   if (file == nullptr) {
+      fprintf(stderr, "error: could not open '%s' for writing\n", argv[1]);
+      return 1;
+   }
+
+   fwrite(&header, sizeof(header), 1, file);
+   for (const sound_t &sound : sounds) {
+      fwrite(&sound.entry, sizeof(sound.entry), 1, file);
+   }
+
+   static const uint8_t padding[sound_bank_header_t::alignment] = {};
+   for (const sound_t &sound : sounds) {
+      const long position = ftell(file);
+      fwrite(padding, 1, size_t(sound.entry.offset - uint64_t(position)), file);
+      fwrite(sound.samples, 1, size_t(sound.entry.size), file);
+      printf("%-24s %u ch %u hz %8u frames %8llu bytes\n",
+             sound.entry.name,
+             sound.entry.channel_count,
+             sound.entry.sample_rate,
+             sound.entry.frame_count,
+             (unsigned long long)sound.entry.size);
+      free(sound.samples);
+   }
+
+   fclose(file);
+
+   return 0;
+}
+
+#undef STB_VORBIS_HEADER_ONLY
+#define STB_VORBIS_NO_PUSHDATA_API
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4244)
+#pragma warning(disable: 4245)
+#pragma warning(disable: 4456)
+#pragma warning(disable: 4457)
+#pragma warning(disable: 4701)
+#endif
+#include <stb_vorbis.h>
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif